@@ -0,0 +1,907 @@
+/**
+ * @file buffer_pool_instance.cpp
+ * @author sheep
+ * @brief implementation of buffer pool instance
+ * @version 0.1
+ * @date 2022-06-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BUFFER_POOL_INSTANCE_CPP
+#define BUFFER_POOL_INSTANCE_CPP
+
+#include "buffer/buffer_pool_instance.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "common/logger.h"
+#include "recovery/log_manager.h"
+#include "storage/page/page_header.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace TinyDB {
+
+BufferPoolInstance::BufferPoolInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                       ReplacerType replacer_type, size_t max_pool_size)
+    : pool_size_(pool_size),
+      frame_num_(std::max(pool_size, max_pool_size)),
+      page_size_(disk_manager->GetPageSize()),
+      arena_(frame_num_, BUFFER_POOL_HUGE_PAGE, page_size_),
+      disk_manager_(disk_manager),
+      page_table_(frame_num_),
+      log_manager_(log_manager) {
+    // allocate the frame descriptors, data is stored in the arena
+    pages_ = new Page[frame_num_];
+    for (size_t i = 0; i < frame_num_; i++) {
+        pages_[i].data_ = arena_.GetFrame(i);
+    }
+    frame_io_.reset(new FrameIO[frame_num_]);
+    // replacer should be able to hold every frame we could grow to
+    switch (replacer_type) {
+    case ReplacerType::CLOCK:
+        replacer_ = new ClockReplacer(frame_num_);
+        break;
+    case ReplacerType::LRUK:
+        replacer_ = new LRUKReplacer(frame_num_);
+        break;
+    default:
+        // pool size has no meaning for lru replacer, because we(buffer pool manager)
+        // are controlling the page num
+        replacer_ = new LRUReplacer(frame_num_);
+        break;
+    }
+
+    // initially, every page is in the free list, and frames beyond pool size are retired.
+    // free frames are locked so that stale lookups can not pin them
+    for (size_t i = 0; i < frame_num_; i++) {
+        pages_[i].pin_count_.store(FRAME_LOCKED);
+        if (i < pool_size_) {
+            free_list_.emplace_back(static_cast<frame_id_t>(i));
+        } else {
+            frame_io_[i].retired_ = true;
+        }
+    }
+}
+
+BufferPoolInstance::~BufferPoolInstance() {
+    delete[] pages_;
+    delete replacer_;
+}
+
+bool BufferPoolInstance::PinFrame(frame_id_t frame_id, page_id_t page_id, bool access) {
+    auto page = &pages_[frame_id];
+    int pin_count = page->pin_count_.load();
+    do {
+        if (pin_count < 0) {
+            // frame is free or being evicted
+            return false;
+        }
+    } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+
+    // we may read a stale entry from page table, and frame has been reused by another page.
+    // since we've pinned it, page id won't change anymore. it only happens without latch,
+    // since mapping and page id of an unlocked frame agree with each other under latch
+    if (page->GetPageId() != page_id) {
+        ReleaseFrame(frame_id);
+        return false;
+    }
+
+    // only the first pinner need to take it out of replacer.
+    // flushing doesn't count as an access, frame stays in replacer. if replacer
+    // tries to evict it meanwhile, the frame will be put back when it's unpinned
+    if (pin_count == 0 && access) {
+        UpdateReplacer(frame_id, true);
+    }
+    return true;
+}
+
+bool BufferPoolInstance::UnpinFrame(frame_id_t frame_id) {
+    auto page = &pages_[frame_id];
+    int pin_count = page->pin_count_.load();
+    do {
+        if (pin_count <= 0) {
+            return false;
+        }
+    } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+
+    if (pin_count == 1) {
+        // put it into replacer
+        UpdateReplacer(frame_id, false);
+    }
+    return true;
+}
+
+void BufferPoolInstance::UpdateReplacer(frame_id_t frame_id, bool pin) {
+    std::lock_guard<std::mutex> guard(frame_io_[frame_id].replacer_latch_);
+    int pin_count = pages_[frame_id].GetPinCount();
+    // if the frame is pinned or locked again after we dropped the last pin,
+    // the one who did it will update replacer after us, so leave it alone
+    if (pin && pin_count != 0) {
+        replacer_->Pin(frame_id);
+    } else if (!pin && pin_count == 0) {
+        replacer_->Unpin(frame_id);
+    }
+}
+
+bool BufferPoolInstance::ReleaseFrame(frame_id_t frame_id) {
+    // we are holding the pin, so it's still the page we release
+    page_id_t page_id = pages_[frame_id].GetPageId();
+    if (!UnpinFrame(frame_id)) {
+        return false;
+    }
+    if (pages_[frame_id].GetPinCount() == 0) {
+        if (frame_io_[frame_id].deleting_.exchange(false)) {
+            // the last user of a deleted page, delete it again
+            DeletePage(page_id);
+        }
+        if (frame_io_[frame_id].retiring_.load()) {
+            // the last user of a frame that should be retired
+            std::unique_lock<std::mutex> guard(latch_);
+            RetireFrames(&guard);
+        }
+        NotifyFrameWaiters();
+    }
+    return true;
+}
+
+void BufferPoolInstance::DetachVictim(frame_id_t frame_id, page_id_t *victim_page_id) {
+    auto page = &pages_[frame_id];
+    bool cleaned = frame_io_[frame_id].cleaned_.exchange(false);
+    // page cleaner may have taken a snapshot and cleared the dirty flag, but not written it yet.
+    // frame is locked, so cleaner won't start cleaning it after we checked
+    if (page->IsDirty() || frame_io_[frame_id].clean_pending_.load()) {
+        // keep the old mapping until it's written back, so that others
+        // will wait for us instead of reading a stale version from disk
+        *victim_page_id = page->GetPageId();
+        foreground_write_count_++;
+    } else {
+        if (cleaned) {
+            // page cleaner has written it back for us
+            avoided_write_count_++;
+        }
+        // evict this page
+        page_table_.Erase(page->GetPageId());
+        if (frame_io_[frame_id].deleting_.exchange(false)) {
+            // page is deleted, but it's last user left before seeing the flag
+            DiscardPendingWrite(frame_id);
+            disk_manager_->DeallocatePage(page->GetPageId());
+        }
+    }
+}
+
+bool BufferPoolInstance::AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id,
+                                      BufferAccessStrategy *strategy) {
+    *victim_page_id = INVALID_PAGE_ID;
+    if (strategy != nullptr) {
+        auto ring = strategy->GetRing(this, GetRingCapacity(strategy));
+        if (ring->slots_.size() == ring->capacity_) {
+            // recycle the frame we used a full circle ago. it may be pinned by others,
+            // or evicted and reused by others. then we have to find another one
+            auto [ring_frame_id, ring_page_id] = ring->slots_[ring->cursor_];
+            auto page = &pages_[ring_frame_id];
+            int expected = 0;
+            if (page->GetPageId() == ring_page_id && !frame_io_[ring_frame_id].retiring_.load() &&
+                page->pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+                // take it out of replacer
+                UpdateReplacer(ring_frame_id, true);
+                DetachVictim(ring_frame_id, victim_page_id);
+                *frame_id = ring_frame_id;
+                return true;
+            }
+        }
+    }
+
+    if (!free_list_.empty()) {
+        // we will use free slot first
+        *frame_id = free_list_.back();
+        free_list_.pop_back();
+        return true;
+    }
+
+    // otherwise, let's evict a page and reuse it's slot
+    while (replacer_->Evict(frame_id)) {
+        // lock the frame. this may fail since frame could be pinned again
+        // without latch after it's handed to replacer. it will be back to replacer
+        // when it's unpinned, so just skip it
+        int expected = 0;
+        if (!pages_[*frame_id].pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+            continue;
+        }
+        // instance has shrunk. clean frame could be retired right now, dirty one
+        // is reused this time, and will be retired after it's unpinned
+        if (frame_io_[*frame_id].retiring_.load() && !pages_[*frame_id].IsDirty() &&
+            !frame_io_[*frame_id].clean_pending_.load()) {
+            RetireFrame(*frame_id);
+            continue;
+        }
+        DetachVictim(*frame_id, victim_page_id);
+        return true;
+    }
+
+    // maybe we should throw runtime error?
+    // because this means there is no more slot.
+    // or sleep on conditional variable waiting for a slot
+    return false;
+}
+
+size_t BufferPoolInstance::GetRingCapacity(BufferAccessStrategy *strategy) {
+    // ring takes at most 1/8 of the instance. but we need at least two frames,
+    // since iterator will pin the next page before releasing the current one
+    size_t pool_size = pool_size_.load();
+    return std::max(std::min<size_t>(2, pool_size), std::min(strategy->GetRingSize(), pool_size / 8));
+}
+
+size_t BufferPoolInstance::Resize(size_t pool_size) {
+    TINYDB_ASSERT(pool_size > 0 && pool_size <= frame_num_, "invalid pool size");
+    std::unique_lock<std::mutex> guard(latch_);
+    size_t old_pool_size = pool_size_.load();
+    if (pool_size > old_pool_size) {
+        for (size_t i = old_pool_size; i < pool_size; i++) {
+            auto &frame_io = frame_io_[i];
+            if (frame_io.retiring_.load()) {
+                // it's still in use, just keep it
+                frame_io.retiring_.store(false);
+                retiring_count_--;
+            } else if (frame_io.retired_) {
+                // retired frames are locked already
+                frame_io.retired_ = false;
+                free_list_.push_back(static_cast<frame_id_t>(i));
+            }
+        }
+        pool_size_.store(pool_size);
+        frame_cv_.notify_all();
+        return retiring_count_.load();
+    }
+
+    for (size_t i = pool_size; i < old_pool_size; i++) {
+        if (!frame_io_[i].retired_) {
+            frame_io_[i].retiring_.store(true);
+            retiring_count_++;
+        }
+    }
+    pool_size_.store(pool_size);
+    // free frames could be retired directly
+    for (auto it = free_list_.begin(); it != free_list_.end();) {
+        auto frame_id = *it;
+        if (frame_io_[frame_id].retiring_.load()) {
+            it = free_list_.erase(it);
+            RetireFrame(frame_id);
+        } else {
+            ++it;
+        }
+    }
+    RetireFrames(&guard);
+    return retiring_count_.load();
+}
+
+void BufferPoolInstance::RetireFrames(std::unique_lock<std::mutex> *guard) {
+    std::vector<frame_id_t> dirty_frames;
+    for (size_t i = pool_size_.load(); i < frame_num_; i++) {
+        auto frame_id = static_cast<frame_id_t>(i);
+        // frames under I/O or pinned will be retired when they are unpinned
+        int expected = 0;
+        if (!frame_io_[i].retiring_.load() || !pages_[i].pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+            continue;
+        }
+        UpdateReplacer(frame_id, true);
+        if (pages_[i].IsDirty() || frame_io_[i].clean_pending_.load()) {
+            // keep the mapping until it's written back, others will wait for us
+            BeginIO(frame_id);
+            dirty_frames.push_back(frame_id);
+        } else {
+            RetireFrame(frame_id);
+        }
+    }
+    if (dirty_frames.empty()) {
+        return;
+    }
+
+    guard->unlock();
+    for (auto frame_id : dirty_frames) {
+        FlushPageHelper(frame_id);
+    }
+    guard->lock();
+    for (auto frame_id : dirty_frames) {
+        // instance may have grown back while we were flushing without latch
+        if (frame_io_[frame_id].retiring_.load() && static_cast<size_t>(frame_id) >= pool_size_.load()) {
+            RetireFrame(frame_id);
+        } else {
+            // frame is in service again, unlock it and hand it back to replacer
+            pages_[frame_id].pin_count_.store(0);
+            UpdateReplacer(frame_id, false);
+            frame_cv_.notify_all();
+        }
+        EndIO(frame_id);
+    }
+}
+
+void BufferPoolInstance::RetireFrame(frame_id_t frame_id) {
+    auto page = &pages_[frame_id];
+    auto &frame_io = frame_io_[frame_id];
+    if (page->GetPageId() != INVALID_PAGE_ID) {
+        page_table_.Erase(page->GetPageId());
+        if (frame_io.deleting_.exchange(false)) {
+            DiscardPendingWrite(frame_id);
+            disk_manager_->DeallocatePage(page->GetPageId());
+        }
+        page->page_id_.store(INVALID_PAGE_ID);
+    }
+    page->is_dirty_.store(false);
+    frame_io.cleaned_.store(false);
+    if (frame_io.retiring_.exchange(false)) {
+        retiring_count_--;
+    }
+    frame_io.retired_ = true;
+    arena_.Release(frame_id);
+}
+
+void BufferPoolInstance::RecordRingFrame(BufferAccessStrategy *strategy, frame_id_t frame_id, page_id_t page_id) {
+    // ring has been created by AcquireFrame
+    auto ring = strategy->GetRing(this, 0);
+    if (ring->slots_.size() < ring->capacity_) {
+        ring->slots_.emplace_back(frame_id, page_id);
+        return;
+    }
+    ring->slots_[ring->cursor_] = std::make_pair(frame_id, page_id);
+    ring->cursor_ = (ring->cursor_ + 1) % ring->capacity_;
+}
+
+void BufferPoolInstance::InstallPage(frame_id_t frame_id, page_id_t page_id, page_id_t victim_page_id,
+                                     bool read_from_disk, bool outbound_is_error) {
+    auto page = &pages_[frame_id];
+    PrepareInstall(frame_id, page_id, victim_page_id);
+    if (read_from_disk) {
+        disk_manager_->ReadPage(page_id, page->data_, outbound_is_error);
+        read_count_++;
+    } else {
+        page->ZeroData(page_size_);
+    }
+    FinishInstall(frame_id);
+}
+
+void BufferPoolInstance::PrepareInstall(frame_id_t frame_id, page_id_t page_id, page_id_t victim_page_id) {
+    auto page = &pages_[frame_id];
+    if (victim_page_id != INVALID_PAGE_ID) {
+        // victim has been deleted, drop it's content instead of writing it back
+        bool deleted = frame_io_[frame_id].deleting_.exchange(false);
+        if (!deleted) {
+            FlushPageHelper(frame_id);
+        }
+        if (deleted) {
+            DiscardPendingWrite(frame_id);
+        }
+        std::lock_guard<std::mutex> guard(latch_);
+        page_table_.Erase(victim_page_id);
+        if (deleted) {
+            disk_manager_->DeallocatePage(victim_page_id);
+        }
+    }
+
+    // initialize the in-memory page representation
+    page->page_id_.store(page_id);
+    page->is_dirty_.store(false);
+}
+
+void BufferPoolInstance::FinishInstall(frame_id_t frame_id) {
+    // unlock the frame, we are the first one pinning it
+    pages_[frame_id].pin_count_.store(1);
+    EndIO(frame_id);
+}
+
+size_t BufferPoolInstance::PrefetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+    struct Install {
+        page_id_t page_id_;
+        frame_id_t frame_id_;
+        page_id_t victim_page_id_;
+    };
+    std::vector<Install> installs;
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        for (auto page_id : page_ids) {
+            // page is cached or someone is reading it
+            if (page_table_.Find(page_id) != INVALID_FRAME_ID) {
+                continue;
+            }
+            frame_id_t frame_id;
+            page_id_t victim_page_id;
+            if (!AcquireFrame(&frame_id, &victim_page_id, strategy)) {
+                // every frame is pinned, read-ahead is not worthwhile
+                break;
+            }
+            if (strategy != nullptr) {
+                RecordRingFrame(strategy, frame_id, page_id);
+            }
+            BeginIO(frame_id);
+            page_table_.Insert(page_id, frame_id);
+            installs.push_back({page_id, frame_id, victim_page_id});
+        }
+    }
+    if (installs.empty()) {
+        return 0;
+    }
+
+    // read them in a single batch
+    IOBatch batch;
+    for (auto &install : installs) {
+        PrepareInstall(install.frame_id_, install.page_id_, install.victim_page_id_);
+        batch.AddRead(install.page_id_, pages_[install.frame_id_].data_);
+    }
+    disk_manager_->ExecuteBatch(&batch);
+    for (auto &install : installs) {
+        read_count_++;
+        FinishInstall(install.frame_id_);
+        // nobody is using it, hand it to replacer
+        ReleaseFrame(install.frame_id_);
+    }
+    NotifyFrameWaiters();
+    return installs.size();
+}
+
+void BufferPoolInstance::BeginIO(frame_id_t frame_id) {
+    std::lock_guard<std::mutex> guard(frame_io_[frame_id].latch_);
+    frame_io_[frame_id].in_progress_ = true;
+}
+
+void BufferPoolInstance::EndIO(frame_id_t frame_id) {
+    {
+        std::lock_guard<std::mutex> guard(frame_io_[frame_id].latch_);
+        frame_io_[frame_id].in_progress_ = false;
+    }
+    frame_io_[frame_id].cv_.notify_all();
+}
+
+bool BufferPoolInstance::WaitFrame(std::unique_lock<std::mutex> *guard,
+                                   std::chrono::steady_clock::time_point deadline) {
+    auto start = std::chrono::steady_clock::now();
+    if (start >= deadline) {
+        return false;
+    }
+
+    frame_waiter_count_++;
+    // frames may be unpinned after AcquireFrame failed but before unpinner sees us,
+    // check again after we've registered ourselves
+    if (replacer_->Size() == 0 && free_list_.empty()) {
+        frame_wait_count_++;
+        frame_cv_.wait_until(*guard, deadline);
+        auto end = std::chrono::steady_clock::now();
+        frame_wait_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+    frame_waiter_count_--;
+    return true;
+}
+
+void BufferPoolInstance::NotifyFrameWaiters() {
+    if (frame_waiter_count_.load() == 0) {
+        return;
+    }
+    // waiter checks the replacer and sleeps with latch held, so it won't miss the notification
+    std::lock_guard<std::mutex> guard(latch_);
+    frame_cv_.notify_all();
+}
+
+void BufferPoolInstance::WaitIO(frame_id_t frame_id) {
+    std::unique_lock<std::mutex> guard(frame_io_[frame_id].latch_);
+    frame_io_[frame_id].cv_.wait(guard, [&] { return !frame_io_[frame_id].in_progress_; });
+}
+
+Page *BufferPoolInstance::FetchPage(page_id_t page_id, bool outbound_is_error, BufferAccessStrategy *strategy,
+                                     bool wait) {
+    // fast path: page is cached, pin it without latch
+    frame_id_t frame_id = page_table_.Find(page_id);
+    if (frame_id != INVALID_FRAME_ID && PinFrame(frame_id, page_id)) {
+        hit_count_++;
+        return &pages_[frame_id];
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + FRAME_WAIT_TIMEOUT;
+    while (true) {
+        std::unique_lock<std::mutex> guard(latch_);
+
+        // check again, others may bring it in before we acquire the latch,
+        // or we missed it while page table is rebuilding
+        frame_id = page_table_.Find(page_id);
+        if (frame_id != INVALID_FRAME_ID) {
+            if (PinFrame(frame_id, page_id)) {
+                hit_count_++;
+                return &pages_[frame_id];
+            }
+            // the frame is under I/O, either someone is reading this page,
+            // or it's being written back. wait for this frame only and retry
+            if (!wait) {
+                return nullptr;
+            }
+            guard.unlock();
+            WaitIO(frame_id);
+            continue;
+        }
+
+        // allocate a new slot
+        page_id_t victim_page_id;
+        if (!AcquireFrame(&frame_id, &victim_page_id, strategy)) {
+            if (!wait || !WaitFrame(&guard, deadline)) {
+                return nullptr;
+            }
+            // others may bring this page in while we are waiting
+            continue;
+        }
+        if (strategy != nullptr) {
+            RecordRingFrame(strategy, frame_id, page_id);
+        }
+        // publish the mapping before we release the latch, thus
+        // others fetching the same page will wait for us
+        BeginIO(frame_id);
+        page_table_.Insert(page_id, frame_id);
+        guard.unlock();
+
+        miss_count_++;
+        InstallPage(frame_id, page_id, victim_page_id, true, outbound_is_error);
+        return &pages_[frame_id];
+    }
+}
+
+bool BufferPoolInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+    frame_id_t frame_id = page_table_.Find(page_id);
+    if (frame_id == INVALID_FRAME_ID) {
+        // we may miss it while page table is rebuilding
+        std::lock_guard<std::mutex> guard(latch_);
+        frame_id = page_table_.Find(page_id);
+    }
+    // failed to find this page
+    if (frame_id == INVALID_FRAME_ID) {
+        return false;
+    }
+
+    // update is_dirty flag. it should be visible before we release the pin,
+    // otherwise evictor might drop the modification
+    if (is_dirty) {
+        pages_[frame_id].is_dirty_.store(true);
+    }
+
+    // failed to unpin this page when pin count is zero
+    return ReleaseFrame(frame_id);
+}
+
+bool BufferPoolInstance::IsResident(page_id_t page_id) {
+    // page table may miss it while rebuilding
+    std::lock_guard<std::mutex> guard(latch_);
+    return page_table_.Find(page_id) != INVALID_FRAME_ID;
+}
+
+bool BufferPoolInstance::FlushPage(page_id_t page_id) {
+    while (true) {
+        std::unique_lock<std::mutex> guard(latch_);
+        // this page is not cached
+        frame_id_t frame_id = page_table_.Find(page_id);
+        if (frame_id == INVALID_FRAME_ID) {
+            return false;
+        }
+
+        // pin it so that we can flush it without holding the latch
+        if (PinFrame(frame_id, page_id, false)) {
+            guard.unlock();
+            FlushPageHelper(frame_id);
+            ReleaseFrame(frame_id);
+            return true;
+        }
+        guard.unlock();
+        WaitIO(frame_id);
+    }
+}
+
+void BufferPoolInstance::FlushPageHelper(frame_id_t frame_id) {
+    // writes of the same frame are serialized, so that an older version won't overwrite a newer one
+    std::lock_guard<std::mutex> guard(frame_io_[frame_id].write_latch_);
+    // write ahead log protocol:
+    // before writting a page into disk, all related logs has to be flush into disk first.
+    auto page = &pages_[frame_id];
+    if (log_manager_ != nullptr) {
+        // get lsn of current page
+        auto header = reinterpret_cast<PageHeader *>(page->GetData());
+        auto lsn = header->GetLSN();
+        // flush the log and record the time
+        auto t1 = std::chrono::steady_clock::now();
+        // force the log
+        log_manager_->Flush(lsn, true);
+        auto t2 = std::chrono::steady_clock::now();
+        flush_wait_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+    }
+    // clear the flag before writing, since others may modify and unpin
+    // this page concurrently, and we don't want to lose their dirty flag
+    page->is_dirty_.store(false);
+    disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    // pending snapshot of page cleaner is older than what we've written, it should be discarded
+    frame_io_[frame_id].write_seq_++;
+    frame_io_[frame_id].clean_pending_.store(false);
+}
+
+void BufferPoolInstance::DiscardPendingWrite(frame_id_t frame_id) {
+    // cleaner holds the write latch until it's batch is written, and validates it's snapshot by write_seq_
+    std::lock_guard<std::mutex> guard(frame_io_[frame_id].write_latch_);
+    frame_io_[frame_id].write_seq_++;
+    frame_io_[frame_id].clean_pending_.store(false);
+}
+
+Page *BufferPoolInstance::NewPage(page_id_t page_id) {
+    auto deadline = std::chrono::steady_clock::now() + FRAME_WAIT_TIMEOUT;
+    std::unique_lock<std::mutex> guard(latch_);
+
+    frame_id_t frame_id;
+    page_id_t victim_page_id;
+    while (!AcquireFrame(&frame_id, &victim_page_id)) {
+        if (!WaitFrame(&guard, deadline)) {
+            // no more space
+            return nullptr;
+        }
+    }
+    BeginIO(frame_id);
+    page_table_.Insert(page_id, frame_id);
+    guard.unlock();
+
+    InstallPage(frame_id, page_id, victim_page_id, false, false);
+    return &pages_[frame_id];
+}
+
+bool BufferPoolInstance::DeletePage(page_id_t page_id) {
+    std::unique_lock<std::mutex> guard(latch_);
+
+    frame_id_t frame_id;
+    while (true) {
+        frame_id = page_table_.Find(page_id);
+        if (frame_id == INVALID_FRAME_ID) {
+            // not in memory, return it to disk manager
+            disk_manager_->DeallocatePage(page_id);
+            return true;
+        }
+
+        // check whether other one is still using, and lock the frame
+        // so that nobody could pin it from now on
+        int expected = 0;
+        if (pages_[frame_id].pin_count_.compare_exchange_strong(expected, FRAME_LOCKED)) {
+            break;
+        }
+        if (expected > 0) {
+            // the last user will delete it
+            frame_io_[frame_id].deleting_.store(true);
+            // unless it has left before seeing the flag, then we take it back and retry
+            if (pages_[frame_id].GetPinCount() != 0 || !frame_io_[frame_id].deleting_.exchange(false)) {
+                return false;
+            }
+            continue;
+        }
+        // frame is under I/O
+        guard.unlock();
+        WaitIO(frame_id);
+        guard.lock();
+    }
+    DiscardPendingWrite(frame_id);
+    // reset page id, because this might interfere "FlushAllPages"
+    pages_[frame_id].page_id_.store(INVALID_PAGE_ID);
+    frame_io_[frame_id].cleaned_.store(false);
+    frame_io_[frame_id].deleting_.store(false);
+
+    page_table_.Erase(page_id);
+    // deallocate it only after nobody could reach it, since disk manager will hand it out again
+    disk_manager_->DeallocatePage(page_id);
+    // remove it from replacer
+    UpdateReplacer(frame_id, true);
+    if (frame_io_[frame_id].retiring_.load()) {
+        RetireFrame(frame_id);
+        return true;
+    }
+    // put this slot to free list
+    free_list_.push_front(frame_id);
+    frame_cv_.notify_all();
+    return true;
+}
+
+std::vector<page_id_t> BufferPoolInstance::GetHotPages() {
+    // latch keeps replacer and mapping stable, pin counts may still change
+    std::lock_guard<std::mutex> guard(latch_);
+    std::vector<page_id_t> page_ids;
+    std::vector<bool> taken(frame_num_, false);
+    for (size_t i = 0; i < frame_num_; i++) {
+        auto page_id = pages_[i].GetPageId();
+        if (pages_[i].GetPinCount() > 0 && page_id != INVALID_PAGE_ID) {
+            page_ids.push_back(page_id);
+            taken[i] = true;
+        }
+    }
+    for (auto frame_id : replacer_->GetHotFrames()) {
+        auto page_id = pages_[frame_id].GetPageId();
+        if (!taken[frame_id] && pages_[frame_id].GetPinCount() >= 0 && page_id != INVALID_PAGE_ID) {
+            page_ids.push_back(page_id);
+            taken[frame_id] = true;
+        }
+    }
+    return page_ids;
+}
+
+void BufferPoolInstance::FlushAllPages() {
+    // pages are written in batches, frames of a batch are pinned and their write latches
+    // are held until it's written. latches are taken in frame order, as page cleaner does
+    size_t batch_size = std::max<size_t>(IO_URING_QUEUE_DEPTH, 1);
+    std::vector<frame_id_t> frames;
+    std::vector<std::unique_lock<std::mutex>> guards;
+    auto flush_batch = [&] {
+        if (frames.empty()) {
+            return;
+        }
+        // write ahead log protocol. a single force covers the whole batch
+        lsn_t max_lsn = INVALID_LSN;
+        for (auto frame_id : frames) {
+            max_lsn = std::max(max_lsn, reinterpret_cast<PageHeader *>(pages_[frame_id].GetData())->GetLSN());
+        }
+        if (log_manager_ != nullptr && max_lsn != INVALID_LSN) {
+            auto t1 = std::chrono::steady_clock::now();
+            log_manager_->Flush(max_lsn, true);
+            auto t2 = std::chrono::steady_clock::now();
+            flush_wait_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+        }
+
+        IOBatch batch;
+        for (auto frame_id : frames) {
+            // clear the flag before writing, same as FlushPageHelper
+            pages_[frame_id].is_dirty_.store(false);
+            batch.AddWrite(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
+        }
+        disk_manager_->ExecuteBatch(&batch);
+        for (auto frame_id : frames) {
+            frame_io_[frame_id].write_seq_++;
+            frame_io_[frame_id].clean_pending_.store(false);
+        }
+        guards.clear();
+        for (auto frame_id : frames) {
+            ReleaseFrame(frame_id);
+        }
+        frames.clear();
+    };
+
+    // maybe we should iterate hash table?
+    for (size_t i = 0; i < frame_num_; i++) {
+        auto page_id = pages_[i].GetPageId();
+        // frames under I/O will be skipped. victims are written back by the evictor,
+        // and pages being read are clean
+        if (page_id == INVALID_PAGE_ID || !PinFrame(i, page_id, false)) {
+            continue;
+        }
+        guards.emplace_back(frame_io_[i].write_latch_);
+        frames.push_back(static_cast<frame_id_t>(i));
+        if (frames.size() >= batch_size) {
+            flush_batch();
+        }
+    }
+    flush_batch();
+}
+
+size_t BufferPoolInstance::CleanPages(double clean_ratio, size_t max_batch_size) {
+    // find dirty pages that could be evicted. we don't need latch here,
+    // since everything will be validated after we pin the frame
+    std::vector<std::pair<page_id_t, frame_id_t>> candidates;
+    size_t evictable_num = 0;
+    size_t clean_num = 0;
+    for (size_t i = 0; i < frame_num_; i++) {
+        auto page = &pages_[i];
+        auto page_id = page->GetPageId();
+        if (page->GetPinCount() != 0 || page_id == INVALID_PAGE_ID) {
+            continue;
+        }
+        evictable_num++;
+        if (page->IsDirty()) {
+            candidates.emplace_back(page_id, static_cast<frame_id_t>(i));
+        } else {
+            clean_num++;
+        }
+    }
+
+    auto target = static_cast<size_t>(std::ceil(evictable_num * clean_ratio));
+    if (clean_num >= target || candidates.empty()) {
+        return 0;
+    }
+    candidates.resize(std::min({target - clean_num, candidates.size(), max_batch_size}));
+    // write them in page id order, so that disk sees a (mostly) sequential pattern
+    std::sort(candidates.begin(), candidates.end());
+
+    // take a snapshot of every page. frames are pinned only while copying, and pending writes
+    // are tracked by clean_pending_, thus eviction of a page we haven't written yet will
+    // write it back itself. write_seq_ tells us whether others have written it since our snapshot
+    struct Snapshot {
+        page_id_t page_id_;
+        frame_id_t frame_id_;
+        uint64_t write_seq_;
+    };
+    std::vector<Snapshot> batch;
+    // aligned, so that direct I/O won't bounce it
+    std::unique_ptr<char, decltype(&free)> buffer(
+        static_cast<char *>(aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, candidates.size() * page_size_)), &free);
+    lsn_t max_lsn = INVALID_LSN;
+    for (auto [page_id, frame_id] : candidates) {
+        auto page = &pages_[frame_id];
+        auto &frame_io = frame_io_[frame_id];
+        if (!PinFrame(frame_id, page_id, false)) {
+            continue;
+        }
+        if (!page->IsDirty()) {
+            ReleaseFrame(frame_id);
+            continue;
+        }
+
+        uint64_t write_seq;
+        {
+            std::lock_guard<std::mutex> guard(frame_io.write_latch_);
+            write_seq = frame_io.write_seq_;
+            frame_io.clean_pending_.store(true);
+        }
+        // clear the flag before taking the snapshot, modification after
+        // that will mark it as dirty again
+        page->is_dirty_.store(false);
+        page->RLatch();
+        memcpy(buffer.get() + batch.size() * page_size_, page->GetData(), page_size_);
+        max_lsn = std::max(max_lsn, reinterpret_cast<PageHeader *>(page->GetData())->GetLSN());
+        page->RUnlatch();
+        ReleaseFrame(frame_id);
+        batch.push_back({page_id, frame_id, write_seq});
+    }
+
+    // write ahead log protocol. a single force covers the whole batch
+    if (log_manager_ != nullptr && max_lsn != INVALID_LSN) {
+        log_manager_->Flush(max_lsn, true);
+    }
+
+    // write latches are held until the batch is written, so that nobody could write a
+    // newer version meanwhile. take them in frame order to avoid deadlock with FlushAllPages
+    std::vector<size_t> lock_order(batch.size());
+    std::iota(lock_order.begin(), lock_order.end(), 0);
+    std::sort(lock_order.begin(), lock_order.end(),
+              [&](size_t a, size_t b) { return batch[a].frame_id_ < batch[b].frame_id_; });
+    std::vector<std::unique_lock<std::mutex>> guards(batch.size());
+    for (auto i : lock_order) {
+        guards[i] = std::unique_lock<std::mutex>(frame_io_[batch[i].frame_id_].write_latch_);
+    }
+
+    IOBatch io_batch;
+    std::vector<size_t> written;
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (frame_io_[batch[i].frame_id_].write_seq_ != batch[i].write_seq_) {
+            // someone has written a newer version
+            continue;
+        }
+        io_batch.AddWrite(batch[i].page_id_, buffer.get() + i * page_size_);
+        written.push_back(i);
+    }
+    disk_manager_->ExecuteBatch(&io_batch);
+    for (auto i : written) {
+        auto &frame_io = frame_io_[batch[i].frame_id_];
+        frame_io.write_seq_++;
+        frame_io.clean_pending_.store(false);
+        frame_io.cleaned_.store(true);
+    }
+    cleaner_write_count_ += written.size();
+    return written.size();
+}
+
+bool BufferPoolInstance::CheckPinCount() {
+    std::lock_guard<std::mutex> guard(latch_);
+    bool flag = true;
+    for (size_t i = 0; i < frame_num_; i++) {
+        if (page_table_.Find(pages_[i].GetPageId()) != static_cast<frame_id_t>(i)) {
+            continue;
+        }
+        if (pages_[i].GetPinCount() != 0) {
+            LOG_ERROR("page %d has pin count %d", pages_[i].GetPageId(), pages_[i].GetPinCount());
+            flag = false;
+        }
+    }
+    return flag;
+}
+
+}
+
+#endif
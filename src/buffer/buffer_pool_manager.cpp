@@ -4,242 +4,494 @@
  * @brief implementation of buffer pool manager
  * @version 0.1
  * @date 2022-04-30
- * 
+ *
  * @copyright Copyright (c) 2022
- * 
+ *
  */
 
 #ifndef BUFFER_POOL_MANAGER_CPP
 #define BUFFER_POOL_MANAGER_CPP
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_replacer.h"
 #include "common/logger.h"
-#include "recovery/log_manager.h"
-#include "storage/page/page_header.h"
+#include "common/macros.h"
 
-namespace TinyDB {
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-    // allocate the in-memory page array
-    pages_ = new Page[pool_size_];
-    // pool size has no meaning for lru replacer, because we(buffer pool manager)
-    // are controlling the page num
-    replacer_ = new LRUReplacer(pool_size_);
+namespace TinyDB {
 
-    // initially, every page is in the free list
-    for (size_t i = 0; i < pool_size_; i++) {
-        free_list_.emplace_back(static_cast<frame_id_t>(i));
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     size_t num_instances, ReplacerType replacer_type, size_t max_pool_size)
+    : pool_size_(pool_size), max_pool_size_(max_pool_size), disk_manager_(disk_manager) {
+    if (pool_size == 0) {
+        // size it to the host's memory
+        pool_size = GetDefaultPoolSize(disk_manager->GetPageSize());
+        pool_size_.store(pool_size);
+        LOG_INFO("buffer pool is sized to %zu frames", pool_size);
+    }
+    max_pool_size_ = std::max(pool_size, max_pool_size);
+    TINYDB_ASSERT(num_instances > 0, "we need at least one buffer pool instance");
+    TINYDB_ASSERT(num_instances <= pool_size, "every instance should own at least one frame");
+
+    // split the frames evenly, first few instances will take the remainder
+    for (size_t i = 0; i < num_instances; i++) {
+        size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+        size_t max_instance_size = max_pool_size_ / num_instances + (i < max_pool_size_ % num_instances ? 1 : 0);
+        instances_.emplace_back(std::make_unique<BufferPoolInstance>(instance_size, disk_manager, log_manager,
+                                                                     replacer_type, max_instance_size));
     }
 }
 
 BufferPoolManager::~BufferPoolManager() {
-    delete[] pages_;
-    delete replacer_;
-}
-
-Page *BufferPoolManager::FetchPage(page_id_t page_id, bool outbound_is_error) {
-    std::lock_guard<std::mutex> guard(latch_);
-
-    // if the page is cached
-    auto it = page_table_.find(page_id);
-    if (it != page_table_.end()) {
-        auto page = &pages_[it->second];
-        // pin this frame
-        replacer_->Pin(it->second);
-        // increment the pin count
-        page->pin_count_ += 1;
-        return page;
-    }
-
-    // allocate a new slot
-    frame_id_t frame_id = -1;
-    if (!free_list_.empty()) {
-        // we will use free slot first
-        frame_id = free_list_.back();
-        free_list_.pop_back();
-    } else {
-        // otherwise, let's evict a page and reuse it's slot
-        if (!replacer_->Evict(&frame_id)) {
-            // maybe we should throw runtime error?
-            // because this means there is no more slot.
-            // or sleep on conditional variable waiting for a slot
-            return nullptr;
-        }
+    StopPageCleaner();
+    StopPageLoader();
+    StopPageDumper();
+    {
+        std::lock_guard<std::mutex> guard(prefetch_latch_);
+        enable_prefetch_ = false;
+        // nobody is going to wait for them
+        prefetch_queue_.clear();
+    }
+    prefetch_cv_.notify_one();
+    if (prefetch_thread_ != nullptr) {
+        prefetch_thread_->join();
+        delete prefetch_thread_;
+    }
+}
 
-        auto page = &pages_[frame_id];
-        if (page->is_dirty_) {
-            FlushPageHelper(frame_id);
-        }
-        // evict this page
-        page_table_.erase(page->GetPageId());
+size_t BufferPoolManager::Resize(size_t pool_size) {
+    TINYDB_ASSERT(pool_size >= instances_.size(), "every instance should own at least one frame");
+    TINYDB_ASSERT(pool_size <= max_pool_size_, "buffer pool can not grow beyond max pool size");
+
+    // split it in the same way as constructor, so that instances never exceed their max size
+    size_t retiring_count = 0;
+    size_t num_instances = instances_.size();
+    for (size_t i = 0; i < num_instances; i++) {
+        size_t instance_size = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+        retiring_count += instances_[i]->Resize(instance_size);
     }
+    pool_size_.store(pool_size);
+    return retiring_count;
+}
+
+size_t BufferPoolManager::GetDefaultPoolSize(size_t page_size) {
+    auto page_num = sysconf(_SC_PHYS_PAGES);
+    auto os_page_size = sysconf(_SC_PAGE_SIZE);
+    if (page_num <= 0 || os_page_size <= 0) {
+        return MIN_BUFFER_POOL_SIZE;
+    }
+    auto memory_size = static_cast<double>(page_num) * static_cast<double>(os_page_size);
+    auto pool_size = static_cast<size_t>(memory_size * BUFFER_POOL_MEMORY_RATIO / page_size);
+    return std::max<size_t>(pool_size, MIN_BUFFER_POOL_SIZE);
+}
 
-    page_table_[page_id] = frame_id;
+Page *BufferPoolManager::FetchPage(page_id_t page_id, bool outbound_is_error, BufferAccessStrategy *strategy,
+                                    bool wait) {
+    return GetInstance(page_id)->FetchPage(page_id, outbound_is_error, strategy, wait);
+}
+
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+    return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+    return GetInstance(page_id)->FlushPage(page_id);
+}
 
-    auto page = &pages_[frame_id];
-    // initialize the in-memory page representation
-    page->page_id_ = page_id;
-    page->is_dirty_ = false;
-    page->pin_count_ = 1;
-    disk_manager_->ReadPage(page_id, page->data_, outbound_is_error);
+Page *BufferPoolManager::NewPage(page_id_t *page_id) {
+    // disk manager decides the page id, and page id decides the instance.
+    // so we have to allocate the page before we know whether the owner has space for it
+    page_id_t new_page_id = disk_manager_->AllocatePage();
+    auto page = GetInstance(new_page_id)->NewPage(new_page_id);
+    if (page == nullptr) {
+        // give it back since nobody is going to use it
+        disk_manager_->DeallocatePage(new_page_id);
+        return nullptr;
+    }
 
+    *page_id = new_page_id;
     return page;
 }
 
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-    std::lock_guard<std::mutex> guard(latch_);
-    // failed to find this page
-    auto it = page_table_.find(page_id);
-    if (it == page_table_.end()) {
-        return false;
+bool BufferPoolManager::DeletePage(page_id_t page_id) {
+    return GetInstance(page_id)->DeletePage(page_id);
+}
+
+bool BufferPoolManager::IsResident(page_id_t page_id) {
+    return GetInstance(page_id)->IsResident(page_id);
+}
+
+void BufferPoolManager::FlushAllPages() {
+    for (auto &instance : instances_) {
+        instance->FlushAllPages();
+    }
+    // it's a checkpoint, make sure pages are durable
+    disk_manager_->Sync();
+}
+
+void BufferPoolManager::RunPageCleaner() {
+    if (cleaner_thread_ != nullptr) {
+        return;
     }
-    frame_id_t frame_id = it->second;
+    enable_cleaning_.store(true);
+    cleaner_thread_ = new std::thread(&BufferPoolManager::PageCleanerThread, this);
+}
 
-    // update is_dirty flag
-    pages_[frame_id].is_dirty_ = pages_[frame_id].is_dirty_ || is_dirty;
+void BufferPoolManager::StopPageCleaner() {
+    if (cleaner_thread_ == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(cleaner_latch_);
+        enable_cleaning_.store(false);
+    }
+    cleaner_cv_.notify_one();
+    cleaner_thread_->join();
+    delete cleaner_thread_;
+    cleaner_thread_ = nullptr;
+}
 
-    // failed to unpin this page
-    if (pages_[frame_id].pin_count_ == 0) {
-        return false;
+void BufferPoolManager::PageCleanerThread() {
+    while (enable_cleaning_.load()) {
+        for (auto &instance : instances_) {
+            instance->CleanPages(PAGE_CLEANER_CLEAN_RATIO, PAGE_CLEANER_BATCH_SIZE);
+        }
+        std::unique_lock<std::mutex> latch(cleaner_latch_);
+        cleaner_cv_.wait_for(latch, PAGE_CLEANER_INTERVAL, [&] { return !enable_cleaning_.load(); });
     }
+}
 
-    pages_[frame_id].pin_count_ -= 1;
-    if (pages_[frame_id].pin_count_ == 0) {
-        // put it into replacer
-        replacer_->Unpin(frame_id);
+bool BufferPoolManager::DumpPages(const std::string &filename) {
+    std::vector<std::vector<page_id_t>> instance_pages;
+    size_t total = 0;
+    for (auto &instance : instances_) {
+        instance_pages.push_back(instance->GetHotPages());
+        total += instance_pages.back().size();
+    }
+    // hotness is only comparable within an instance, so we interleave them by rank
+    std::vector<page_id_t> page_ids;
+    page_ids.reserve(total);
+    for (size_t rank = 0; page_ids.size() < total; rank++) {
+        for (auto &pages : instance_pages) {
+            if (rank < pages.size()) {
+                page_ids.push_back(pages[rank]);
+            }
+        }
     }
 
+    // write into a temporary file first, so that a crash won't leave a partial dump
+    auto tmp_filename = filename + ".tmp";
+    std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc | std::ios::out);
+    if (!file.is_open()) {
+        LOG_WARN("failed to open dump file %s", tmp_filename.c_str());
+        return false;
+    }
+    auto count = static_cast<uint32_t>(page_ids.size());
+    file.write(reinterpret_cast<const char *> (&count), sizeof(count));
+    file.write(reinterpret_cast<const char *> (page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    file.close();
+    if (file.fail() || std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        LOG_WARN("failed to write dump file %s", filename.c_str());
+        return false;
+    }
     return true;
 }
 
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-    std::lock_guard<std::mutex> guard(latch_);
-    // this page is not cached
-    auto it = page_table_.find(page_id);
-    if (it == page_table_.end()) {
-        return false;
+size_t BufferPoolManager::LoadPages(const std::string &filename, bool wait) {
+    std::ifstream file(filename, std::ios::binary | std::ios::in | std::ios::ate);
+    if (!file.is_open()) {
+        // nothing to load, e.g. the first start
+        return 0;
+    }
+    auto file_size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+    uint32_t count = 0;
+    file.read(reinterpret_cast<char *> (&count), sizeof(count));
+    if (!file || file_size != sizeof(count) + static_cast<size_t>(count) * sizeof(page_id_t)) {
+        LOG_WARN("dump file %s is corrupted", filename.c_str());
+        return 0;
+    }
+    std::vector<page_id_t> dumped(count);
+    file.read(reinterpret_cast<char *> (dumped.data()), count * sizeof(page_id_t));
+
+    // take the hottest pages that fit in every instance
+    std::vector<size_t> instance_count(instances_.size(), 0);
+    std::vector<page_id_t> page_ids;
+    for (auto page_id : dumped) {
+        auto index = static_cast<size_t>(page_id) % instances_.size();
+        if (page_id >= 0 && instance_count[index] < instances_[index]->GetPoolSize()) {
+            instance_count[index]++;
+            page_ids.push_back(page_id);
+        }
+    }
+    // random reads of hot pages become a (mostly) sequential sweep
+    std::sort(page_ids.begin(), page_ids.end());
+    page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+
+    StopPageLoader();
+    enable_loading_.store(true);
+    if (wait) {
+        LoadPagesHelper(page_ids);
+    } else {
+        loader_thread_ = new std::thread(&BufferPoolManager::LoadPagesHelper, this, page_ids);
+    }
+    return page_ids.size();
+}
+
+void BufferPoolManager::LoadPagesHelper(const std::vector<page_id_t> &page_ids) {
+    for (auto page_id : page_ids) {
+        if (!enable_loading_.load()) {
+            break;
+        }
+        if (FetchPage(page_id) == nullptr) {
+            // foreground traffic has pinned every frame
+            break;
+        }
+        UnpinPage(page_id, false);
     }
+}
 
-    // flush to disk
-    frame_id_t frame_id = it->second;
-    FlushPageHelper(frame_id);
+void BufferPoolManager::StopPageLoader() {
+    if (loader_thread_ == nullptr) {
+        return;
+    }
+    enable_loading_.store(false);
+    loader_thread_->join();
+    delete loader_thread_;
+    loader_thread_ = nullptr;
+}
 
-    return true;
+void BufferPoolManager::RunPageDumper(const std::string &filename) {
+    if (dumper_thread_ != nullptr) {
+        return;
+    }
+    dump_filename_ = filename;
+    enable_dumping_.store(true);
+    dumper_thread_ = new std::thread(&BufferPoolManager::PageDumperThread, this);
 }
 
-void BufferPoolManager::FlushPageHelper(frame_id_t frame_id) {
-    // write ahead log protocol: 
-    // before writting a page into disk, all related logs has to be flush into disk first.
-    auto page = &pages_[frame_id];
-    if (log_manager_ != nullptr) {
-        // get lsn of current page
-        auto header = reinterpret_cast<PageHeader *>(page->GetData());
-        auto lsn = header->GetLSN();
-        // flush the log and record the time
-        auto t1 = std::chrono::steady_clock::now();
-        // force the log
-        log_manager_->Flush(lsn, true);
-        auto t2 = std::chrono::steady_clock::now();
-        flush_wait_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+void BufferPoolManager::StopPageDumper() {
+    if (dumper_thread_ == nullptr) {
+        return;
     }
-    disk_manager_->WritePage(page->GetPageId(), page->GetData());
-    page->is_dirty_ = false;
+    {
+        std::lock_guard<std::mutex> guard(dumper_latch_);
+        enable_dumping_.store(false);
+    }
+    dumper_cv_.notify_one();
+    dumper_thread_->join();
+    delete dumper_thread_;
+    dumper_thread_ = nullptr;
+    // the last dump
+    DumpPages(dump_filename_);
 }
 
-Page *BufferPoolManager::NewPage(page_id_t *page_id) {
-    std::lock_guard<std::mutex> guard(latch_);
+void BufferPoolManager::PageDumperThread() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> latch(dumper_latch_);
+            dumper_cv_.wait_for(latch, BUFFER_POOL_DUMP_INTERVAL, [&] { return !enable_dumping_.load(); });
+            if (!enable_dumping_.load()) {
+                return;
+            }
+        }
+        DumpPages(dump_filename_);
+    }
+}
 
-    // no more space
-    if (free_list_.empty() && replacer_->Size() == 0) {
-        return nullptr;
+void BufferPoolManager::Prefetch(page_id_t page_id, std::shared_ptr<BufferAccessStrategy> strategy) {
+    PrefetchChain(page_id, 1, nullptr, std::move(strategy));
+}
+
+void BufferPoolManager::PrefetchChain(page_id_t page_id, size_t depth, std::function<page_id_t(Page *)> next_page_id,
+                                      std::shared_ptr<BufferAccessStrategy> strategy) {
+    if (strategy != nullptr) {
+        // every page of the chain stays in the ring until scan reaches it. pages are spread among
+        // instances, and scan itself needs two frames of the ring
+        auto ring_capacity = GetInstance(page_id)->GetRingCapacity(strategy.get());
+        depth = std::min(depth, (ring_capacity - std::min<size_t>(ring_capacity, 2)) * instances_.size());
+    }
+    if (page_id == INVALID_PAGE_ID || depth == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(prefetch_latch_);
+        if (prefetch_queue_.size() >= PREFETCH_QUEUE_SIZE) {
+            // prefetcher is falling behind, reading these pages synchronously is better
+            // than prefetching them after they are accessed
+            return;
+        }
+        prefetch_queue_.push_back({page_id, depth, std::move(next_page_id), std::move(strategy)});
+        // pools that never prefetch don't pay for the thread
+        if (prefetch_thread_ == nullptr) {
+            prefetch_thread_ = new std::thread(&BufferPoolManager::PrefetchThread, this);
+        }
     }
+    prefetch_cv_.notify_one();
+}
 
-    // allocate new page from disk
-    *page_id = disk_manager_->AllocatePage();
+void BufferPoolManager::PrefetchThread() {
+    while (true) {
+        std::deque<PrefetchRequest> requests;
+        {
+            std::unique_lock<std::mutex> latch(prefetch_latch_);
+            prefetch_cv_.wait(latch, [&] { return !enable_prefetch_ || !prefetch_queue_.empty(); });
+            if (!enable_prefetch_) {
+                return;
+            }
+            requests.swap(prefetch_queue_);
+        }
 
-    frame_id_t frame_id = -1;
-    if (!free_list_.empty()) {
-        frame_id = free_list_.back();
-        free_list_.pop_back();
-    } else {
-        if (!replacer_->Evict(&frame_id)) {
-            return nullptr;
+        // single pages are independent, read them in batches. chains are followed
+        // page by page, since we need the content of a page to find the next one
+        std::vector<std::vector<page_id_t>> batches(instances_.size());
+        std::vector<BufferAccessStrategy *> batch_strategies(instances_.size(), nullptr);
+        auto flush_batch = [&](size_t index) {
+            if (batches[index].empty()) {
+                return;
+            }
+            instances_[index]->PrefetchPages(batches[index], batch_strategies[index]);
+            prefetch_count_ += batches[index].size();
+            batches[index].clear();
+        };
+        for (auto &request : requests) {
+            if (request.depth_ == 1) {
+                if (!IsPrefetchable(request.page_id_)) {
+                    continue;
+                }
+                auto index = static_cast<size_t>(request.page_id_) % instances_.size();
+                // pages of a batch share the same strategy
+                if (batch_strategies[index] != request.strategy_.get()) {
+                    flush_batch(index);
+                    batch_strategies[index] = request.strategy_.get();
+                }
+                batches[index].push_back(request.page_id_);
+            } else {
+                PrefetchChainHelper(request);
+            }
         }
+        for (size_t i = 0; i < instances_.size(); i++) {
+            flush_batch(i);
+        }
+    }
+}
 
-        auto page = &pages_[frame_id];
-        if (page->is_dirty_) {
-            FlushPageHelper(frame_id);
+bool BufferPoolManager::IsPrefetchable(page_id_t page_id) {
+    // page id is usually read from a page we no longer hold, e.g. a sibling pointer, the page
+    // may be freed and reused since then. don't trust it unless it points to an allocated page
+    return page_id >= 0 && disk_manager_->IsAllocated(page_id);
+}
+
+void BufferPoolManager::PrefetchChainHelper(const PrefetchRequest &request) {
+    auto page_id = request.page_id_;
+    for (size_t i = 0; i < request.depth_ && page_id != INVALID_PAGE_ID; i++) {
+        if (!IsPrefetchable(page_id)) {
+            break;
+        }
+        // pages that are already in the pool are simply pinned and unpinned
+        auto page = FetchPage(page_id, false, request.strategy_.get(), false);
+        if (page == nullptr) {
+            // every frame is pinned or page is being read by others, read-ahead is not worthwhile
+            break;
+        }
+        prefetch_count_++;
+
+        auto next_page_id = INVALID_PAGE_ID;
+        if (request.next_page_id_ && i + 1 < request.depth_) {
+            // we only hold a single latch, so we won't deadlock with others
+            page->RLatch();
+            next_page_id = request.next_page_id_(page);
+            page->RUnlatch();
         }
+        UnpinPage(page_id, false);
+        page_id = next_page_id;
+    }
+}
 
-        page_table_.erase(page->GetPageId());
+size_t BufferPoolManager::GetReadCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetReadCount();
     }
-    page_table_[*page_id] = frame_id;
+    return count;
+}
 
-    auto page = &pages_[frame_id];
-    // initialize the in-memory page representation
-    page->page_id_ = *page_id;
-    page->is_dirty_ = false;
-    page->pin_count_ = 1;
-    page->ZeroData();
+size_t BufferPoolManager::GetHitCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetHitCount();
+    }
+    return count;
+}
 
-    return page;
+size_t BufferPoolManager::GetMissCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetMissCount();
+    }
+    return count;
 }
 
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-    std::lock_guard<std::mutex> guard(latch_);
-    // deallocate this page, return it to disk manager
-    disk_manager_->DeallocatePage(page_id);
-    auto it = page_table_.find(page_id);
-    if (it == page_table_.end()) {
-        // already removed
-        return true;
-    }
-
-    frame_id_t frame_id = page_table_[page_id];
-    // check whether other one is still using
-    if (pages_[frame_id].pin_count_ > 0) {
-        return false;
+size_t BufferPoolManager::GetCleanerWriteCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetCleanerWriteCount();
+    }
+    return count;
+}
+
+size_t BufferPoolManager::GetForegroundWriteCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetForegroundWriteCount();
     }
-    // reset page id, because this might interfere "FlushAllPages"
-    pages_[frame_id].page_id_ = -1;
+    return count;
+}
 
-    page_table_.erase(page_id);
-    // put this slot to free list
-    free_list_.push_front(frame_id);
-    // remove it from replacer
-    replacer_->Pin(frame_id);
-    return true;
+size_t BufferPoolManager::GetAvoidedWriteCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetAvoidedWriteCount();
+    }
+    return count;
 }
 
-void BufferPoolManager::FlushAllPages() {
-    std::lock_guard<std::mutex> guard(latch_);
+std::chrono::milliseconds BufferPoolManager::GetFrameWaitTime() {
+    std::chrono::milliseconds time{0};
+    for (auto &instance : instances_) {
+        time += instance->GetFrameWaitTime();
+    }
+    return time;
+}
 
-    // maybe we should iterate hash table?
-    for (size_t i = 0; i < pool_size_; i++) {
-        if (page_table_.count(pages_[i].GetPageId()) == 0) {
-            continue;
-        }
-        FlushPageHelper(i);
+size_t BufferPoolManager::GetFrameWaitCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetFrameWaitCount();
     }
+    return count;
+}
+
+size_t BufferPoolManager::GetFrameWaiterCount() {
+    size_t count = 0;
+    for (auto &instance : instances_) {
+        count += instance->GetFrameWaiterCount();
+    }
+    return count;
 }
 
 bool BufferPoolManager::CheckPinCount() {
-    std::lock_guard<std::mutex> guard(latch_);
     bool flag = true;
-    for (size_t i = 0; i < pool_size_; i++) {
-        if (page_table_.count(pages_[i].GetPageId()) == 0) {
-            continue;
-        }
-        if (pages_[i].GetPinCount() != 0) {
-            LOG_ERROR("page %d has pin count %d", pages_[i].GetPageId(), pages_[i].GetPinCount());
-            flag = false;
-        }
+    for (auto &instance : instances_) {
+        flag = instance->CheckPinCount() && flag;
     }
     return flag;
 }
 
 }
 
-#endif
\ No newline at end of file
+#endif
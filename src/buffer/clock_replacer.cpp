@@ -0,0 +1,102 @@
+/**
+ * @file clock_replacer.cpp
+ * @author sheep
+ * @brief implementation of clock replacer
+ * @version 0.1
+ * @date 2022-06-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef CLOCK_REPLACER_CPP
+#define CLOCK_REPLACER_CPP
+
+#include "buffer/clock_replacer.h"
+#include "common/macros.h"
+
+namespace TinyDB {
+
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages), state_(new std::atomic<uint8_t>[num_pages]) {
+    for (size_t i = 0; i < num_pages_; i++) {
+        state_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool ClockReplacer::Evict(frame_id_t *victim) {
+    // we shouldn't just evict a frame without knowing who he is
+    // because that way we would leak a page
+    TINYDB_ASSERT(victim != nullptr, "victim should not be nullptr");
+
+    // every round clears the reference bits, so we will find a victim within two rounds
+    // unless others keep pinning and unpinning frames concurrently
+    while (size_.load() > 0) {
+        auto &state = state_[hand_];
+        auto frame_id = static_cast<frame_id_t>(hand_);
+        hand_ = (hand_ + 1) % num_pages_;
+
+        uint8_t old_state = state.load();
+        if ((old_state & EVICTABLE) == 0) {
+            continue;
+        }
+        if (old_state & REFERENCED) {
+            // give it a second chance. it's fine if we lose the race here
+            state.compare_exchange_strong(old_state, old_state & ~REFERENCED);
+            continue;
+        }
+        if (state.compare_exchange_strong(old_state, 0)) {
+            size_--;
+            *victim = frame_id;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+    TINYDB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+    if (state_[frame_id].exchange(0) & EVICTABLE) {
+        size_--;
+    }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+    TINYDB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+    // unpin means the frame has just been accessed
+    if ((state_[frame_id].fetch_or(EVICTABLE | REFERENCED) & EVICTABLE) == 0) {
+        size_++;
+    }
+}
+
+size_t ClockReplacer::Size() {
+    auto size = size_.load();
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+std::vector<frame_id_t> ClockReplacer::GetHotFrames() {
+    // referenced frames survive the next sweep. in each group, frames right behind
+    // the hand are the last ones the hand will reach
+    std::vector<frame_id_t> referenced;
+    std::vector<frame_id_t> unreferenced;
+    size_t hand = hand_;
+    for (size_t i = 1; i <= num_pages_; i++) {
+        auto frame_id = static_cast<frame_id_t>((hand + num_pages_ - i) % num_pages_);
+        uint8_t state = state_[frame_id].load();
+        if ((state & EVICTABLE) == 0) {
+            continue;
+        }
+        if (state & REFERENCED) {
+            referenced.push_back(frame_id);
+        } else {
+            unreferenced.push_back(frame_id);
+        }
+    }
+    referenced.insert(referenced.end(), unreferenced.begin(), unreferenced.end());
+    return referenced;
+}
+
+}
+
+#endif
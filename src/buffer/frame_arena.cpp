@@ -0,0 +1,77 @@
+/**
+ * @file frame_arena.cpp
+ * @author sheep
+ * @brief implementation of frame arena
+ * @version 0.1
+ * @date 2022-06-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "buffer/frame_arena.h"
+#include "common/logger.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+namespace TinyDB {
+
+FrameArena::FrameArena(size_t frame_num, bool huge_page, size_t page_size) : page_size_(page_size) {
+    TINYDB_ASSERT(frame_num > 0, "arena should not be empty");
+    size_ = frame_num * page_size_;
+    // huge page is only worthwhile when the arena could fill one
+    huge_page = huge_page && size_ >= HUGE_PAGE_SIZE;
+    if (huge_page) {
+        size_ = (size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    // anonymous mapping is page-aligned and zeroed already. to use huge pages, arena
+    // should be aligned to huge page, so we map a bit more and trim the head and tail
+    size_t map_size = huge_page ? size_ + HUGE_PAGE_SIZE : size_;
+    void *addr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr != MAP_FAILED) {
+        auto start = reinterpret_cast<uintptr_t>(addr);
+        auto aligned = huge_page ? (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE : start;
+        if (aligned > start) {
+            munmap(addr, aligned - start);
+        }
+        if (start + map_size > aligned + size_) {
+            munmap(reinterpret_cast<void *>(aligned + size_), start + map_size - aligned - size_);
+        }
+        data_ = reinterpret_cast<char *>(aligned);
+        mapped_ = true;
+#ifdef MADV_HUGEPAGE
+        // it's only a hint, kernel may ignore it when transparent huge page is disabled
+        if (huge_page && madvise(data_, size_, MADV_HUGEPAGE) != 0) {
+            LOG_DEBUG("failed to enable huge page for frame arena");
+        }
+#endif
+        return;
+    }
+
+    // fall back to heap
+    LOG_WARN("failed to map frame arena, falling back to heap");
+    data_ = static_cast<char *>(std::aligned_alloc(PAGE_SIZE, size_));
+    TINYDB_ASSERT(data_ != nullptr, "failed to allocate frame arena");
+    memset(data_, 0, size_);
+}
+
+void FrameArena::Release(frame_id_t frame_id) {
+    // heap memory couldn't be released partially
+    if (mapped_) {
+        madvise(GetFrame(frame_id), page_size_, MADV_DONTNEED);
+    }
+}
+
+FrameArena::~FrameArena() {
+    if (mapped_) {
+        munmap(data_, size_);
+    } else {
+        std::free(data_);
+    }
+}
+
+}
@@ -0,0 +1,155 @@
+/**
+ * @file lru_k_replacer.cpp
+ * @author sheep
+ * @brief implementation of lru-k replacer
+ * @version 0.1
+ * @date 2022-06-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LRU_K_REPLACER_CPP
+#define LRU_K_REPLACER_CPP
+
+#include "buffer/lru_k_replacer.h"
+#include "common/macros.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace TinyDB {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_period)
+    : num_pages_(num_pages),
+      k_(k),
+      correlated_period_(correlated_period),
+      history_(num_pages * k, 0),
+      access_count_(num_pages, 0),
+      last_access_(num_pages, 0),
+      evictable_(num_pages, false) {
+    TINYDB_ASSERT(k_ > 0, "k should be positive");
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+    // timestamp starts from 1, 0 means we never accessed it
+    current_timestamp_++;
+    if (access_count_[frame_id] > 0 && current_timestamp_ - last_access_[frame_id] <= correlated_period_) {
+        // correlated access, just refresh the last access time
+        last_access_[frame_id] = current_timestamp_;
+        return;
+    }
+
+    history_[frame_id * k_ + access_count_[frame_id] % k_] = current_timestamp_;
+    access_count_[frame_id]++;
+    last_access_[frame_id] = current_timestamp_;
+}
+
+uint64_t LRUKReplacer::KthAccess(frame_id_t frame_id) {
+    auto count = access_count_[frame_id];
+    if (count < k_) {
+        return 0;
+    }
+    // the oldest one in the ring buffer
+    return history_[frame_id * k_ + count % k_];
+}
+
+bool LRUKReplacer::Evict(frame_id_t *victim) {
+    std::lock_guard<std::mutex> guard(mu_);
+    TINYDB_ASSERT(victim != nullptr, "victim should not be nullptr");
+
+    if (size_ == 0) {
+        return false;
+    }
+
+    // candidate outside correlated period goes first. then frames with infinite
+    // backward k-distance, ordered by last access. otherwise the one whose k-th access is the oldest
+    frame_id_t best = INVALID_FRAME_ID;
+    bool best_correlated = true;
+    uint64_t best_kth = 0;
+    uint64_t best_last = 0;
+    for (size_t i = 0; i < num_pages_; i++) {
+        if (!evictable_[i]) {
+            continue;
+        }
+        auto frame_id = static_cast<frame_id_t>(i);
+        bool correlated = current_timestamp_ - last_access_[i] < correlated_period_;
+        uint64_t kth = KthAccess(frame_id);
+        uint64_t last = last_access_[i];
+
+        bool better = false;
+        if (best == INVALID_FRAME_ID || correlated != best_correlated) {
+            better = best == INVALID_FRAME_ID || !correlated;
+        } else if (kth != best_kth) {
+            better = kth < best_kth;
+        } else {
+            better = last < best_last;
+        }
+
+        if (better) {
+            best = frame_id;
+            best_correlated = correlated;
+            best_kth = kth;
+            best_last = last;
+        }
+    }
+
+    // frame will hold another page, forget about the history
+    evictable_[best] = false;
+    access_count_[best] = 0;
+    last_access_[best] = 0;
+    size_--;
+    *victim = best;
+    return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+    std::lock_guard<std::mutex> guard(mu_);
+    TINYDB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+
+    RecordAccess(frame_id);
+    if (evictable_[frame_id]) {
+        evictable_[frame_id] = false;
+        size_--;
+    }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+    std::lock_guard<std::mutex> guard(mu_);
+    TINYDB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+
+    // a newly loaded page, this is the first access
+    if (access_count_[frame_id] == 0) {
+        RecordAccess(frame_id);
+    }
+    if (!evictable_[frame_id]) {
+        evictable_[frame_id] = true;
+        size_++;
+    }
+}
+
+size_t LRUKReplacer::Size() {
+    std::lock_guard<std::mutex> guard(mu_);
+    return size_;
+}
+
+std::vector<frame_id_t> LRUKReplacer::GetHotFrames() {
+    std::lock_guard<std::mutex> guard(mu_);
+    std::vector<frame_id_t> frames;
+    for (size_t i = 0; i < num_pages_; i++) {
+        if (evictable_[i]) {
+            frames.push_back(static_cast<frame_id_t>(i));
+        }
+    }
+    // reverse of the order used by Evict
+    auto key = [&](frame_id_t frame_id) {
+        bool correlated = current_timestamp_ - last_access_[frame_id] < correlated_period_;
+        return std::make_tuple(correlated, KthAccess(frame_id), last_access_[frame_id]);
+    };
+    std::sort(frames.begin(), frames.end(), [&](frame_id_t a, frame_id_t b) { return key(a) > key(b); });
+    return frames;
+}
+
+}
+
+#endif
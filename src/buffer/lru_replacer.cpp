@@ -77,6 +77,12 @@ size_t LRUReplacer::Size() {
     return list_.size();
 }
 
+std::vector<frame_id_t> LRUReplacer::GetHotFrames() {
+    std::lock_guard<std::mutex> guard(mu_);
+    // most recently used one is at front
+    return std::vector<frame_id_t>(list_.begin(), list_.end());
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+/**
+ * @file page_table.cpp
+ * @author sheep
+ * @brief implementation of page table
+ * @version 0.1
+ * @date 2022-06-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "buffer/page_table.h"
+
+#include <vector>
+
+namespace TinyDB {
+
+PageTable::PageTable(size_t capacity) {
+    // keep load factor under 1/4. while a frame is switching from one page to another,
+    // both page ids might be in the table
+    slot_num_ = 8;
+    shift_ = 61;
+    while (slot_num_ < capacity * 4) {
+        slot_num_ <<= 1;
+        shift_ -= 1;
+    }
+    slots_.reset(new std::atomic<uint64_t>[slot_num_]);
+    for (size_t i = 0; i < slot_num_; i++) {
+        slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+}
+
+frame_id_t PageTable::Find(page_id_t page_id) const {
+    size_t mask = slot_num_ - 1;
+    for (size_t i = Hash(page_id), probe = 0; probe < slot_num_; i = (i + 1) & mask, probe++) {
+        uint64_t slot = slots_[i].load(std::memory_order_acquire);
+        if (slot == EMPTY_SLOT) {
+            return INVALID_FRAME_ID;
+        }
+        if (SlotKey(slot) == page_id) {
+            return SlotValue(slot);
+        }
+    }
+    return INVALID_FRAME_ID;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+    TINYDB_ASSERT(page_id >= 0, "only valid page could be inserted");
+    size_t mask = slot_num_ - 1;
+    size_t i = Hash(page_id);
+    // take the first empty slot or tombstone. readers skip tombstones,
+    // so reusing them won't break the probing sequence of other keys
+    uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+    while (slot != EMPTY_SLOT && slot != TOMBSTONE_SLOT) {
+        i = (i + 1) & mask;
+        slot = slots_[i].load(std::memory_order_relaxed);
+    }
+    if (slot == TOMBSTONE_SLOT) {
+        tombstone_num_--;
+    }
+    slots_[i].store(MakeSlot(page_id, frame_id), std::memory_order_release);
+    size_++;
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+    size_t mask = slot_num_ - 1;
+    for (size_t i = Hash(page_id), probe = 0; probe < slot_num_; i = (i + 1) & mask, probe++) {
+        uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+        if (slot == EMPTY_SLOT) {
+            return false;
+        }
+        if (SlotKey(slot) == page_id) {
+            slots_[i].store(TOMBSTONE_SLOT, std::memory_order_release);
+            size_--;
+            tombstone_num_++;
+            // too many tombstones will make probing longer and longer
+            if (size_ + tombstone_num_ > slot_num_ / 2) {
+                Rebuild();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void PageTable::Rebuild() {
+    std::vector<uint64_t> live;
+    live.reserve(size_);
+    for (size_t i = 0; i < slot_num_; i++) {
+        uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+        if (slot != EMPTY_SLOT && slot != TOMBSTONE_SLOT) {
+            live.push_back(slot);
+        }
+        slots_[i].store(EMPTY_SLOT, std::memory_order_release);
+    }
+    // concurrent readers may miss some entries during rebuilding, they will retry under latch
+    size_ = 0;
+    tombstone_num_ = 0;
+    for (auto slot : live) {
+        Insert(SlotKey(slot), SlotValue(slot));
+    }
+}
+
+}
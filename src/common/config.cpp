@@ -17,4 +17,46 @@ std::chrono::milliseconds CYCLE_DETECTION_INTERVAL = std::chrono::milliseconds(5
 
 std::chrono::milliseconds LOG_TIMEOUT = std::chrono::seconds(1);
 
+bool LOG_GROUP_COMMIT = true;
+
+size_t LRUK_K = 2;
+
+size_t LRUK_CORRELATED_PERIOD = 0;
+
+size_t BULKREAD_RING_SIZE = 32;
+
+double BULKREAD_TABLE_RATIO = 0.25;
+
+std::chrono::milliseconds PAGE_CLEANER_INTERVAL = std::chrono::milliseconds(10);
+
+double PAGE_CLEANER_CLEAN_RATIO = 0.25;
+
+size_t PAGE_CLEANER_BATCH_SIZE = 32;
+
+double BUFFER_POOL_MEMORY_RATIO = 0.25;
+
+std::chrono::milliseconds BUFFER_POOL_DUMP_INTERVAL = std::chrono::seconds(60);
+
+bool BUFFER_POOL_HUGE_PAGE = true;
+
+std::chrono::milliseconds FRAME_WAIT_TIMEOUT = std::chrono::milliseconds(0);
+
+size_t READ_AHEAD_DEPTH = 4;
+
+size_t PREFETCH_QUEUE_SIZE = 64;
+
+bool DISK_DIRECT_IO = false;
+
+size_t IO_URING_QUEUE_DEPTH = 64;
+
+bool DISK_PAGE_COMPRESSION = false;
+
+size_t DISK_SEGMENT_SIZE = 1 << 30;
+
+size_t DISK_PAGE_SIZE = PAGE_SIZE;
+
+size_t LOG_PARTITION_NUM = 1;
+
+size_t DISK_EXTENSION_PAGES = 64;
+
 }
\ No newline at end of file
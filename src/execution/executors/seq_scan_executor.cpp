@@ -19,8 +19,14 @@ void SeqScanExecutor::Init() {
     auto plan = GetPlanNode<SeqScanPlan>();
     // store table info
     table_info_ = context_->GetCatalog()->GetTable(plan.GetTableOid());
-    // initialize the iterator
-    iterator_ = table_info_->table_->Begin();
+    // initialize the iterator with a bulk read ring if the table is large compared to the buffer pool,
+    // table of unknown size is considered as large. small tables are cached as usual
+    auto page_count = table_info_->table_->GetPageCount();
+    if (page_count == 0 || page_count > BULKREAD_TABLE_RATIO * table_info_->bpm_->GetPoolSize()) {
+        iterator_ = table_info_->table_->Begin(std::make_shared<BufferAccessStrategy>());
+    } else {
+        iterator_ = table_info_->table_->Begin();
+    }
     table_schema_ = &table_info_->schema_;
     txn_context_ = context_->GetTransactionContext();
     txn_manager_ = context_->GetTransactionManager();
@@ -0,0 +1,91 @@
+/**
+ * @file buffer_access_strategy.h
+ * @author sheep
+ * @brief access strategy used by operations that read lots of pages only once,
+ * e.g. sequential scan. similar to BAS_BULKREAD in postgres
+ * @version 0.1
+ * @date 2022-06-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BUFFER_ACCESS_STRATEGY_H
+#define BUFFER_ACCESS_STRATEGY_H
+
+#include "common/config.h"
+#include "common/macros.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace TinyDB {
+
+class BufferPoolInstance;
+
+/**
+ * @brief
+ * a bulk read keeps a small private ring of frames in every buffer pool instance.
+ * when it misses, it will recycle the frame it used a full circle ago instead of
+ * evicting others' pages, thus a large scan won't wash out the pool.
+ * frames of the ring are ordinary frames, others could still hit or evict them.
+ * strategy is shared by the scan and the read-ahead it issues, rings of different
+ * instances are protected by latch of the instance
+ */
+class BufferAccessStrategy {
+    friend class BufferPoolInstance;
+public:
+    /**
+     * @brief Construct a new Buffer Access Strategy object
+     * @param ring_size maximum number of frames in the ring of every instance
+     */
+    explicit BufferAccessStrategy(size_t ring_size = BULKREAD_RING_SIZE)
+        : ring_size_(ring_size) {
+        TINYDB_ASSERT(ring_size_ > 0, "ring should not be empty");
+    }
+
+    ~BufferAccessStrategy() = default;
+
+    DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+    size_t GetRingSize() {
+        return ring_size_;
+    }
+
+private:
+    // frames recently used by this strategy in a buffer pool instance
+    struct Ring {
+        // (frame id, the page we've put into it)
+        std::vector<std::pair<frame_id_t, page_id_t>> slots_;
+        // maximum number of slots
+        size_t capacity_{0};
+        // next slot to recycle once the ring is full
+        size_t cursor_{0};
+    };
+
+    /**
+     * @brief
+     * get the ring of an instance, called by instance with it's latch held
+     * @param instance
+     * @param capacity size of ring when it's created
+     */
+    Ring *GetRing(const BufferPoolInstance *instance, size_t capacity) {
+        std::lock_guard<std::mutex> guard(latch_);
+        auto &ring = rings_[instance];
+        if (ring.capacity_ == 0) {
+            ring.capacity_ = capacity;
+        }
+        return &ring;
+    }
+
+    size_t ring_size_;
+    // protects the map only. elements won't move once they are inserted
+    std::mutex latch_;
+    std::unordered_map<const BufferPoolInstance *, Ring> rings_;
+};
+
+}
+
+#endif
@@ -0,0 +1,462 @@
+/**
+ * @file buffer_pool_instance.h
+ * @author sheep
+ * @brief a single shard of the buffer pool. every instance owns its own frames,
+ * page table, free list and replacer, so instances never contend with each other
+ * @version 0.1
+ * @date 2022-06-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BUFFER_POOL_INSTANCE_H
+#define BUFFER_POOL_INSTANCE_H
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/frame_arena.h"
+#include "buffer/replacer.h"
+#include "buffer/page_table.h"
+#include "storage/page/page.h"
+#include "storage/disk/disk_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace TinyDB {
+
+class LogManager;
+
+class BufferPoolInstance {
+public:
+    /**
+     * @brief Construct a new Buffer Pool Instance object
+     *
+     * @param pool_size number of frames owned by this instance
+     * @param disk_manager disk manager
+     * @param log_manager log manager, used to enforce WAL protocol
+     * @param replacer_type replacement policy
+     * @param max_pool_size maximum number of frames this instance could grow to, 0 means pool_size.
+     * frame descriptors are allocated up front, while memory of frames is committed lazily
+     */
+    BufferPoolInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                       ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
+
+    ~BufferPoolInstance();
+
+    DISALLOW_COPY_AND_MOVE(BufferPoolInstance);
+
+    /**
+     * @brief
+     * fetch a page though page id ignoring whether it's from disk or memory.
+     * when page is cached, we will pin it without acquiring the latch
+     * @param page_id
+     * @param outbound_is_error used in ReadPage in disk manager, check it for more details.
+     * @param strategy access strategy, nullptr for normal access
+     * @param wait whether to wait for a free frame or for the I/O of frame in flight
+     * @return pointer pointing to corresponding page, or nullptr when we don't have more slots
+     * after waiting for FRAME_WAIT_TIMEOUT, or right away when we shouldn't wait
+     */
+    Page *FetchPage(page_id_t page_id, bool outbound_is_error = false, BufferAccessStrategy *strategy = nullptr,
+                    bool wait = true);
+
+    /**
+     * @brief
+     * unpin the page. Now it can be swapped out from memory. latch-free
+     * @param page_id
+     * @param is_dirty
+     * @return false when page is not in memory, or the pin count is zero
+     */
+    bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+    /**
+     * @brief
+     * flush the page to disk
+     * @param page_id
+     * @return false when the page is not in memory
+     */
+    bool FlushPage(page_id_t page_id);
+
+    /**
+     * @brief
+     * whether the page is cached in this instance
+     * @param page_id
+     */
+    bool IsResident(page_id_t page_id);
+
+    /**
+     * @brief
+     * bring a page that was just allocated by disk manager into this instance.
+     * page id is decided by the caller, since it also decides which instance owns the page
+     * @param page_id id of the allocated page
+     * @return pointer pointing to new page, or nullptr if we don't have more space
+     * after waiting for FRAME_WAIT_TIMEOUT
+     */
+    Page *NewPage(page_id_t page_id);
+
+    /**
+     * @brief
+     * delete the page, return it back to disk
+     * @param page_id
+     * @return false when someone is still using this page, then it's deleted by the last user
+     */
+    bool DeletePage(page_id_t page_id);
+
+    /**
+     * @brief
+     * flush all pages to disk
+     */
+    void FlushAllPages();
+
+    size_t GetPoolSize() {
+        return pool_size_.load();
+    }
+
+    size_t GetMaxPoolSize() {
+        return frame_num_;
+    }
+
+    /**
+     * @brief
+     * grow or shrink the instance online. new frames are put into free list. when shrinking,
+     * frames at the tail are retired: free ones are retired immediately, unpinned ones are
+     * written back and retired, pinned ones are retired once they are unpinned
+     * @param pool_size new number of frames, no more than max pool size
+     * @return number of frames that are still waiting to be retired
+     */
+    size_t Resize(size_t pool_size);
+
+    /**
+     * @brief
+     * number of frames that are still in use and waiting to be retired
+     */
+    size_t GetRetiringCount() {
+        return retiring_count_.load();
+    }
+
+    /**
+     * @brief
+     * bring the pages into this instance without pinning them. pages that aren't cached
+     * are read in a single I/O batch. it never waits for a frame
+     * @param page_ids
+     * @param strategy access strategy, could be nullptr
+     * @return size_t number of pages read from disk
+     */
+    size_t PrefetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy = nullptr);
+
+    /**
+     * @brief
+     * get the resident pages ordered by hotness, the hottest one first.
+     * pinned pages go first, then the evictable ones in the order of replacer
+     * @return std::vector<page_id_t>
+     */
+    std::vector<page_id_t> GetHotPages();
+
+    /**
+     * @brief
+     * for debug purposes, it will check the refcnt of in-memory pages.
+     * @return true when refcnt of all pages are zero
+     */
+    bool CheckPinCount();
+
+    /**
+     * @brief
+     * write back dirty pages that could be evicted, until the given fraction of evictable frames
+     * are clean. called by page cleaner without latch
+     * @param clean_ratio fraction of evictable frames that should be clean
+     * @param max_batch_size maximum number of pages written in one call
+     * @return number of pages written
+     */
+    size_t CleanPages(double clean_ratio, size_t max_batch_size);
+
+    size_t GetCleanerWriteCount() {
+        return cleaner_write_count_.load();
+    }
+
+    size_t GetForegroundWriteCount() {
+        return foreground_write_count_.load();
+    }
+
+    size_t GetAvoidedWriteCount() {
+        return avoided_write_count_.load();
+    }
+
+    size_t GetReadCount() {
+        return read_count_.load();
+    }
+
+    size_t GetHitCount() {
+        return hit_count_.load();
+    }
+
+    size_t GetMissCount() {
+        return miss_count_.load();
+    }
+
+    /**
+     * @brief
+     * number of frames a strategy could keep in the ring of this instance
+     */
+    size_t GetRingCapacity(BufferAccessStrategy *strategy);
+
+    std::chrono::milliseconds GetFlushWaitTime() {
+        return std::chrono::milliseconds(flush_wait_time_.load());
+    }
+
+    std::chrono::milliseconds GetFrameWaitTime() {
+        return std::chrono::milliseconds(frame_wait_time_.load());
+    }
+
+    size_t GetFrameWaitCount() {
+        return frame_wait_count_.load();
+    }
+
+    size_t GetFrameWaiterCount() {
+        return frame_waiter_count_.load();
+    }
+
+private:
+    void FlushPageHelper(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * drop the snapshot page cleaner has taken from a deleted page. it must be done before the page id
+     * is returned to disk manager, otherwise cleaner may write the dead page over the next owner of the id
+     * @param frame_id
+     */
+    void DiscardPendingWrite(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * try to pin the frame without latch, and check whether it's still holding the page.
+     * @param frame_id
+     * @param page_id page we are expecting
+     * @param access whether we should tell replacer. flushing is not an access
+     * @return false when frame is locked by buffer pool, or it's holding another page
+     */
+    bool PinFrame(frame_id_t frame_id, page_id_t page_id, bool access = true);
+
+    /**
+     * @brief
+     * decrease the pin count, frame will be handed to replacer when pin count reaches zero
+     * @param frame_id
+     * @return false when pin count is already zero
+     */
+    bool UnpinFrame(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * drop the pin we are holding. the last user carries out the deferred deletion or retirement
+     * of the frame. every pin taken outside the latch should be released by it.
+     * should be called without latch held
+     * @param frame_id
+     * @return false when pin count is already zero
+     */
+    bool ReleaseFrame(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * take frame out of replacer or hand it back, according to its current pin count.
+     * pin count transition and replacer update aren't atomic together, a delayed unpinner
+     * may reach replacer after the next pinner, so updates of a frame are serialized and
+     * checked against the pin count, the last one always sees the final state
+     * @param frame_id
+     * @param pin true if frame is pinned or locked by us, false if we've dropped the last pin
+     */
+    void UpdateReplacer(frame_id_t frame_id, bool pin);
+
+    /**
+     * @brief
+     * find a frame to hold a new page. ring of the strategy goes first, then free list,
+     * then we will ask replacer for a victim.
+     * the returned frame is locked, i.e. pin count is FRAME_LOCKED.
+     * should be called with latch held
+     * @param[out] frame_id
+     * @param[out] victim_page_id page that should be written back before reusing the frame,
+     * it's still in page table. INVALID_PAGE_ID if victim is clean
+     * @param strategy access strategy, could be nullptr
+     * @return false when every frame is pinned
+     */
+    bool AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id, BufferAccessStrategy *strategy = nullptr);
+
+    /**
+     * @brief
+     * every frame is pinned, wait until some frame is unpinned or deleted.
+     * should be called with latch held, and caller should retry after it returns true
+     * @param guard guard of latch
+     * @param deadline
+     * @return false when we've reached the deadline
+     */
+    bool WaitFrame(std::unique_lock<std::mutex> *guard, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief
+     * wake up threads waiting for a frame. should be called without latch
+     */
+    void NotifyFrameWaiters();
+
+    /**
+     * @brief
+     * remove the mapping of a locked victim frame, or hand it to caller if it should be written back.
+     * should be called with latch held
+     */
+    void DetachVictim(frame_id_t frame_id, page_id_t *victim_page_id);
+
+    /**
+     * @brief
+     * retire every retiring frame that isn't pinned, dirty pages are written back without latch.
+     * should be called with latch held
+     * @param guard guard of latch, it's held when we return
+     */
+    void RetireFrames(std::unique_lock<std::mutex> *guard);
+
+    /**
+     * @brief
+     * drop the clean page in a locked frame and take the frame out of service.
+     * should be called with latch held
+     */
+    void RetireFrame(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * remember the frame in ring of the strategy, so that it will be recycled by the strategy later.
+     * should be called with latch held
+     */
+    void RecordRingFrame(BufferAccessStrategy *strategy, frame_id_t frame_id, page_id_t page_id);
+
+    /**
+     * @brief
+     * write back the victim and bring the new page into a locked frame,
+     * then hand it to caller with pin count 1. called without latch,
+     * the frame should be marked as under I/O
+     * @param frame_id
+     * @param page_id new page
+     * @param victim_page_id dirty victim returned by AcquireFrame
+     * @param read_from_disk whether we should read the page or zero it
+     * @param outbound_is_error
+     */
+    void InstallPage(frame_id_t frame_id, page_id_t page_id, page_id_t victim_page_id,
+                     bool read_from_disk, bool outbound_is_error);
+
+    /**
+     * @brief
+     * first half of InstallPage, write back the victim and reset the frame for the new page
+     */
+    void PrepareInstall(frame_id_t frame_id, page_id_t page_id, page_id_t victim_page_id);
+
+    /**
+     * @brief
+     * second half of InstallPage, data is ready. hand the frame to caller with pin count 1
+     */
+    void FinishInstall(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * mark the frame as under I/O, called with latch held
+     */
+    void BeginIO(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * I/O is done, wake up threads waiting for this frame
+     */
+    void EndIO(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * wait until I/O on this frame is finished, should be called without latch
+     */
+    void WaitIO(frame_id_t frame_id);
+
+    // I/O state of a single frame
+    struct FrameIO {
+        // used to wait for in-flight I/O
+        std::mutex latch_;
+        std::condition_variable cv_;
+        bool in_progress_{false};
+        // serializes writes of this frame
+        std::mutex write_latch_;
+        // number of writes, protected by write_latch_
+        uint64_t write_seq_{0};
+        // page cleaner has taken a snapshot and cleared the dirty flag, but hasn't written it
+        std::atomic<bool> clean_pending_{false};
+        // page was written back by page cleaner and stays clean since then
+        std::atomic<bool> cleaned_{false};
+        // instance has shrunk, frame should be retired once it's not used. modified with latch held
+        std::atomic<bool> retiring_{false};
+        // frame is out of service, protected by latch
+        bool retired_{false};
+        // page was deleted while someone is still using it, it's returned to disk
+        // by whoever detaches it from the frame: the last user or the evictor
+        std::atomic<bool> deleting_{false};
+        // serializes replacer updates of this frame
+        std::mutex replacer_latch_;
+    };
+
+    // pin count of frames that are free or being evicted
+    static constexpr int FRAME_LOCKED = -1;
+
+    // number of frames in service, frames beyond it are retired or retiring
+    std::atomic<size_t> pool_size_;
+    // number of frame descriptors, i.e. maximum pool size
+    size_t frame_num_;
+    // size of pages, it's decided by the db file
+    size_t page_size_;
+    // data of every frame, page aligned
+    FrameArena arena_;
+    // descriptors of frames, data_ of them point into the arena
+    Page *pages_;
+    // I/O state of every frame
+    std::unique_ptr<FrameIO[]> frame_io_;
+    // pointer to disk manager
+    DiskManager *disk_manager_;
+    // mapping from page id to frame id, lookup is latch-free,
+    // insertion and deletion are protected by latch_
+    PageTable page_table_;
+    // replacer used to find victim pages. since pages are pinned without latch, replacer
+    // may hand out a frame that has been pinned again, so victim should be validated
+    // by locking it's pin count
+    Replacer *replacer_;
+    // list of free pages
+    std::list<frame_id_t> free_list_;
+    // latch protecting this instance only. it protects free list, modification of page table
+    // and choosing victims. disk I/O is never performed while holding it
+    std::mutex latch_;
+    // used to wait for an evictable frame, protected by latch_
+    std::condition_variable frame_cv_;
+    // log manager
+    LogManager *log_manager_;
+
+    // debug and analyse, in milliseconds. WAL is forced outside the latch
+    std::atomic<std::chrono::milliseconds::rep> flush_wait_time_{0};
+    // pages written back by page cleaner
+    std::atomic<size_t> cleaner_write_count_{0};
+    // dirty victims written back on the miss path
+    std::atomic<size_t> foreground_write_count_{0};
+    // time spent on waiting for a frame, in milliseconds
+    std::atomic<std::chrono::milliseconds::rep> frame_wait_time_{0};
+    // number of times we've waited for a frame
+    std::atomic<size_t> frame_wait_count_{0};
+    // threads waiting for a frame right now
+    std::atomic<size_t> frame_waiter_count_{0};
+    // frames waiting to be retired
+    std::atomic<size_t> retiring_count_{0};
+    // pages read from disk
+    std::atomic<size_t> read_count_{0};
+    // fetches served from memory
+    std::atomic<size_t> hit_count_{0};
+    // fetches that had to bring the page in
+    std::atomic<size_t> miss_count_{0};
+    // clean victims that were cleaned by page cleaner, i.e. writes we avoided on the miss path
+    std::atomic<size_t> avoided_write_count_{0};
+};
+
+}
+
+#endif
@@ -1,7 +1,8 @@
 /**
  * @file buffer_pool_manager.h
  * @author sheep
- * @brief simple buffer pool manager that very likely to become the bottleneck
+ * @brief buffer pool manager. pages are hashed to several independent buffer pool instances,
+ * so threads touching different pages won't queue on the same latch
  * @version 0.1
  * @date 2022-04-30
  * 
@@ -12,14 +13,20 @@
 #ifndef BUFFER_POOL_MANAGER_H
 #define BUFFER_POOL_MANAGER_H
 
-#include "buffer/replacer.h"
+#include "buffer/buffer_pool_instance.h"
 #include "storage/page/page.h"
 #include "storage/disk/disk_manager.h"
 #include "common/config.h"
 
-#include <unordered_map>
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace TinyDB {
 
@@ -30,10 +37,19 @@ public:
     /**
      * @brief Construct a new Buffer Pool Manager object
      * 
-     * @param pool_size size of buffer pool
+     * @param pool_size size of buffer pool, it will be split among instances.
+     * 0 means sizing it to the host's memory, see GetDefaultPoolSize
      * @param disk_manager disk manager
+     * @param log_manager log manager
+     * @param num_instances number of independent buffer pool instances. page is assigned to
+     * instance by page_id % num_instances
+     * @param replacer_type replacement policy used by every instance
+     * @param max_pool_size maximum size the buffer pool could grow to, 0 means pool_size.
+     * it's split among instances in the same way as pool_size
      */
-    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                      size_t num_instances = 1, ReplacerType replacer_type = ReplacerType::LRU,
+                      size_t max_pool_size = 0);
 
     /**
      * @brief Destroy the Buffer Pool Manager object
@@ -46,9 +62,13 @@ public:
      * fetch a page though page id ignoring whether it's from disk or memory
      * @param page_id 
      * @param outbound_is_error used in ReadPage in disk manager, check it for more details.
+     * @param strategy access strategy. bulk reads should use it to avoid polluting the pool,
+     * nullptr for normal access
+     * @param wait whether to wait for a free frame or for the I/O of frame in flight, prefetch doesn't wait
      * @return pointer pointing to corresponding page, or nullptr when we don't have more slots
      */
-    Page *FetchPage(page_id_t page_id, bool outbound_is_error = false);
+    Page *FetchPage(page_id_t page_id, bool outbound_is_error = false, BufferAccessStrategy *strategy = nullptr,
+                    bool wait = true);
 
     /**
      * @brief 
@@ -83,13 +103,19 @@ public:
      * delete the page, return it back to disk
      * @param page_id 
      * @return true when deletion succeed
-     * @return false when someone is still using this page
+     * @return false when someone is still using this page, then it's deleted by the last user
      */
     bool DeletePage(page_id_t page_id);
 
+    /**
+     * @brief
+     * whether the page is cached in this buffer pool. it doesn't pin the page
+     */
+    bool IsResident(page_id_t page_id);
+
     /**
      * @brief 
-     * flush all pages to disk
+     * flush all pages to disk, and sync the db file
      */
     void FlushAllPages();
 
@@ -99,9 +125,181 @@ public:
      * @return size_t 
      */
     size_t GetPoolSize() {
-        return pool_size_;
+        return pool_size_.load();
+    }
+
+    size_t GetMaxPoolSize() {
+        return max_pool_size_;
+    }
+
+    /**
+     * @brief
+     * size of pages in this buffer pool, it's decided by the db file
+     */
+    size_t GetPageSize() {
+        return disk_manager_->GetPageSize();
+    }
+
+    /**
+     * @brief
+     * grow or shrink the buffer pool online. frames are added or retired in every instance,
+     * pinned frames are retired after they are unpinned
+     * @param pool_size new size of buffer pool, no more than max pool size
+     * @return number of frames that are still waiting to be retired
+     */
+    size_t Resize(size_t pool_size);
+
+    /**
+     * @brief
+     * default size of buffer pool, i.e. BUFFER_POOL_MEMORY_RATIO of the physical memory,
+     * but no less than MIN_BUFFER_POOL_SIZE
+     * @param page_size size of every frame
+     * @return size_t number of frames
+     */
+    static size_t GetDefaultPoolSize(size_t page_size = PAGE_SIZE);
+
+    /**
+     * @brief
+     * return the number of buffer pool instances
+     * @return size_t
+     */
+    size_t GetInstanceNum() {
+        return instances_.size();
+    }
+
+    /**
+     * @brief
+     * start the background page cleaner. every PAGE_CLEANER_INTERVAL, it writes back dirty
+     * evictable pages, until PAGE_CLEANER_CLEAN_RATIO of evictable frames are clean.
+     * thus misses are less likely to write back a dirty victim and wait for the log
+     */
+    void RunPageCleaner();
+
+    /**
+     * @brief
+     * stop the background page cleaner, it's called by destructor as well
+     */
+    void StopPageCleaner();
+
+    /**
+     * @brief
+     * write ids of resident pages into the file, hottest ones first. file is replaced atomically
+     * @param filename
+     * @return false when we failed to write the file
+     */
+    bool DumpPages(const std::string &filename);
+
+    /**
+     * @brief
+     * bring pages dumped by DumpPages back to the pool, so that we won't start with a cold pool.
+     * hottest pages that fit in the pool are read in page id order.
+     * should be called before creating any page
+     * @param filename
+     * @param wait whether we should wait for the loading. otherwise pages are loaded in background,
+     * in parallel with the traffic
+     * @return number of pages we are going to load
+     */
+    size_t LoadPages(const std::string &filename, bool wait = true);
+
+    /**
+     * @brief
+     * dump resident pages into the file every BUFFER_POOL_DUMP_INTERVAL in background.
+     * pages are dumped once more when the dumper is stopped, i.e. on clean shutdown
+     * @param filename
+     */
+    void RunPageDumper(const std::string &filename);
+
+    /**
+     * @brief
+     * stop the page dumper after the last dump, it's called by destructor as well
+     */
+    void StopPageDumper();
+
+    /**
+     * @brief
+     * start loading the page in background, it's a hint and may be dropped.
+     * page is left unpinned once it's in the pool
+     * @param page_id
+     * @param strategy access strategy used to load the page, could be nullptr
+     */
+    void Prefetch(page_id_t page_id, std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+    /**
+     * @brief
+     * read ahead along a page chain in background, e.g. next page of table page or leaf page.
+     * prefetcher holds the read latch of a page while calling next_page_id
+     * @param page_id first page to load
+     * @param depth maximum number of pages to load
+     * @param next_page_id get the next page id from a loaded page, INVALID_PAGE_ID ends the chain
+     * @param strategy access strategy used to load the pages, could be nullptr. depth is limited by
+     * the ring size, so that read-ahead won't recycle the pages before scan reaching them
+     */
+    void PrefetchChain(page_id_t page_id, size_t depth, std::function<page_id_t(Page *)> next_page_id,
+                       std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+    /**
+     * @brief
+     * number of pages read from disk
+     */
+    size_t GetReadCount();
+
+    /**
+     * @brief
+     * number of fetches served from memory
+     */
+    size_t GetHitCount();
+
+    /**
+     * @brief
+     * number of fetches that had to bring the page in
+     */
+    size_t GetMissCount();
+
+    /**
+     * @brief
+     * number of pages loaded by prefetcher, including the ones that were already in the pool
+     */
+    size_t GetPrefetchCount() {
+        return prefetch_count_.load();
     }
 
+    /**
+     * @brief
+     * number of pages written back by page cleaner
+     */
+    size_t GetCleanerWriteCount();
+
+    /**
+     * @brief
+     * number of dirty victims written back on the miss path
+     */
+    size_t GetForegroundWriteCount();
+
+    /**
+     * @brief
+     * number of clean victims that were cleaned by page cleaner,
+     * i.e. writes page cleaner saved for the miss path
+     */
+    size_t GetAvoidedWriteCount();
+
+    /**
+     * @brief
+     * time spent on waiting for a frame when every frame is pinned
+     */
+    std::chrono::milliseconds GetFrameWaitTime();
+
+    /**
+     * @brief
+     * number of times FetchPage/NewPage waited for a frame
+     */
+    size_t GetFrameWaitCount();
+
+    /**
+     * @brief
+     * number of threads waiting for a frame right now
+     */
+    size_t GetFrameWaiterCount();
+
     /**
      * @brief 
      * for debug purposes, it will check the refcnt of in-memory pages.
@@ -112,35 +310,113 @@ public:
     std::string GetTimeConsumption() {
         std::stringstream os;
 
+        std::chrono::milliseconds flush_wait_time{0};
+        for (auto &instance : instances_) {
+            flush_wait_time += instance->GetFlushWaitTime();
+        }
+
         os << "BufferPoolManagerTimeConsumption: "
-           << "FlushWaitTime: " << flush_wait_time_.count() << "ms";
+           << "FlushWaitTime: " << flush_wait_time.count() << "ms, "
+           << "FrameWaitTime: " << GetFrameWaitTime().count() << "ms, "
+           << "FrameWait: " << GetFrameWaitCount() << ", "
+           << "ForegroundWrite: " << GetForegroundWriteCount() << ", "
+           << "CleanerWrite: " << GetCleanerWriteCount() << ", "
+           << "AvoidedWrite: " << GetAvoidedWriteCount();
         
         return os.str();
     }
 
 private:
-    void FlushPageHelper(frame_id_t frame_id);
+    /**
+     * @brief
+     * get the instance that owns the page
+     * @param page_id
+     * @return BufferPoolInstance*
+     */
+    inline BufferPoolInstance *GetInstance(page_id_t page_id) {
+        return instances_[static_cast<size_t>(page_id) % instances_.size()].get();
+    }
+
+    void PageCleanerThread();
+
+    void PrefetchThread();
+
+    void PageDumperThread();
+
+    /**
+     * @brief
+     * fetch and unpin the pages one by one, stop when loading is disabled
+     */
+    void LoadPagesHelper(const std::vector<page_id_t> &page_ids);
+
+    /**
+     * @brief
+     * wait for the background loading to finish
+     */
+    void StopPageLoader();
+
+    // a pending read-ahead
+    struct PrefetchRequest {
+        page_id_t page_id_;
+        size_t depth_;
+        std::function<page_id_t(Page *)> next_page_id_;
+        std::shared_ptr<BufferAccessStrategy> strategy_;
+    };
+
+    /**
+     * @brief
+     * follow the page chain of the request, called by prefetcher
+     */
+    void PrefetchChainHelper(const PrefetchRequest &request);
+
+    /**
+     * @brief
+     * whether page id of a prefetch request points to an allocated page
+     */
+    bool IsPrefetchable(page_id_t page_id);
 
     // number of pages in the buffer pool
-    size_t pool_size_;
-    // array of in-memory pages
-    Page *pages_;
+    std::atomic<size_t> pool_size_;
+    // maximum number of pages in the buffer pool
+    size_t max_pool_size_;
     // pointer to disk manager
     DiskManager *disk_manager_;
-    // mapping from page id to frame id
-    std::unordered_map<page_id_t, frame_id_t> page_table_;
-    // replacer used to find victim pages
-    Replacer *replacer_;
-    // list of free pages
-    std::list<frame_id_t> free_list_;
-    // big latch, currently it will protect whole buffer pool manager
-    // i.e. no fine-grained locking
-    std::mutex latch_;
-    // log manager
-    LogManager *log_manager_;
-
-    // debug and analyse
-    std::chrono::milliseconds flush_wait_time_{0};
+    // independent buffer pool instances, each of them has its own latch
+    std::vector<std::unique_ptr<BufferPoolInstance>> instances_;
+
+    // whether background page cleaner is enabled
+    std::atomic<bool> enable_cleaning_{false};
+    // page cleaner thread
+    std::thread *cleaner_thread_{nullptr};
+    // used to wakeup page cleaner when we are stopping it
+    std::mutex cleaner_latch_;
+    std::condition_variable cleaner_cv_;
+
+    // file that page dumper writes into
+    std::string dump_filename_;
+    // whether page dumper is running
+    std::atomic<bool> enable_dumping_{false};
+    // page dumper thread
+    std::thread *dumper_thread_{nullptr};
+    // used to wakeup page dumper when we are stopping it
+    std::mutex dumper_latch_;
+    std::condition_variable dumper_cv_;
+
+    // whether background loading should go on
+    std::atomic<bool> enable_loading_{false};
+    // thread loading the dumped pages in background
+    std::thread *loader_thread_{nullptr};
+
+    // whether prefetcher is running
+    bool enable_prefetch_{true};
+    // pending read-ahead requests, protected by prefetch_latch_
+    std::deque<PrefetchRequest> prefetch_queue_;
+    std::mutex prefetch_latch_;
+    std::condition_variable prefetch_cv_;
+    // pages loaded by prefetcher
+    std::atomic<size_t> prefetch_count_{0};
+    // prefetch thread. it's started by the first prefetch request, protected by prefetch_latch_
+    std::thread *prefetch_thread_{nullptr};
 };
 
 }
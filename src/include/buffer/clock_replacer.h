@@ -0,0 +1,73 @@
+/**
+ * @file clock_replacer.h
+ * @author sheep
+ * @brief clock(second chance) replacer used in buffer pool manager
+ * @version 0.1
+ * @date 2022-06-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef CLOCK_REPLACER_H
+#define CLOCK_REPLACER_H
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+#include <atomic>
+#include <memory>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * every frame owns a state byte in a flat array indexed by frame id,
+ * so Pin/Unpin is a single atomic instruction without allocation or hashing.
+ * Evict moves the clock hand, clearing reference bit of frames it passed,
+ * and the first evictable frame without reference bit will be the victim.
+ * Evict should be serialized by the caller, while Pin/Unpin could be called concurrently
+ */
+class ClockReplacer: public Replacer {
+public:
+    /**
+     * @brief Construct a new ClockReplacer object
+     *
+     * @param num_pages the number of frames, frame id should be less than it
+     */
+    explicit ClockReplacer(size_t num_pages);
+
+    ~ClockReplacer() override = default;
+
+    // inherited methods from Replacer
+
+    bool Evict(frame_id_t *victim) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    size_t Size() override;
+
+    std::vector<frame_id_t> GetHotFrames() override;
+
+private:
+    // frame could be chosen as victim
+    static constexpr uint8_t EVICTABLE = 1;
+    // frame has been accessed since the last time clock hand passed it
+    static constexpr uint8_t REFERENCED = 2;
+
+    // number of frames
+    size_t num_pages_;
+    // state of every frame
+    std::unique_ptr<std::atomic<uint8_t>[]> state_;
+    // position of clock hand
+    size_t hand_{0};
+    // number of evictable frames. it's signed since concurrent Pin may
+    // decrease it before the corresponding Unpin increased it
+    std::atomic<int64_t> size_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file frame_arena.h
+ * @author sheep
+ * @brief contiguous memory holding the data of every frame in a buffer pool instance
+ * @version 0.1
+ * @date 2022-06-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * data of frames are stored in a single page-aligned region, apart from the frame
+ * descriptors(Page). so that descriptors are dense and the pool is covered by a few
+ * (huge) pages in TLB. it's also what direct I/O requires.
+ * memory is zeroed when the arena is created, and it's committed lazily
+ * when a frame is touched for the first time
+ */
+class FrameArena {
+public:
+    /**
+     * @brief Construct a new Frame Arena object
+     * @param frame_num number of frames
+     * @param huge_page whether we should ask kernel to back the arena with huge pages
+     * @param page_size size of every frame
+     */
+    explicit FrameArena(size_t frame_num, bool huge_page = BUFFER_POOL_HUGE_PAGE, size_t page_size = PAGE_SIZE);
+
+    ~FrameArena();
+
+    DISALLOW_COPY_AND_MOVE(FrameArena);
+
+    inline char *GetFrame(frame_id_t frame_id) {
+        return data_ + static_cast<size_t>(frame_id) * page_size_;
+    }
+
+    /**
+     * @brief
+     * give the memory of a frame back to OS, content of the frame is lost
+     * @param frame_id
+     */
+    void Release(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * whether arena is mapped directly, otherwise it's allocated from heap
+     */
+    inline bool IsMapped() {
+        return mapped_;
+    }
+
+private:
+    // alignment of arena, it's the size of a huge page on x86-64
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    char *data_{nullptr};
+    // size of every frame
+    size_t page_size_;
+    // size of the region, rounded up
+    size_t size_{0};
+    // whether data_ is allocated by mmap
+    bool mapped_{false};
+};
+
+}
+
+#endif
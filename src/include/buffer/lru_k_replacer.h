@@ -0,0 +1,102 @@
+/**
+ * @file lru_k_replacer.h
+ * @author sheep
+ * @brief lru-k replacer used in buffer pool manager
+ * @version 0.1
+ * @date 2022-06-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LRU_K_REPLACER_H
+#define LRU_K_REPLACER_H
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+#include <mutex>
+#include <vector>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * lru-k evicts the frame whose k-th most recent access is the oldest, i.e. the one
+ * with largest backward k-distance. frames accessed less than k times have infinite
+ * distance and will be evicted first, in lru order. thus a large sequential scan,
+ * which touches every page only once, won't flush frequently used pages out of the pool.
+ *
+ * time is logical, it advances on every access to the replacer.
+ * Pin counts as an access, so does the first Unpin of a frame that has no history,
+ * since buffer pool brings a page in with pin count 1 without calling Pin.
+ */
+class LRUKReplacer: public Replacer {
+public:
+    /**
+     * @brief Construct a new LRUKReplacer object
+     *
+     * @param num_pages the number of frames, frame id should be less than it
+     * @param k number of accesses we remember for every frame
+     * @param correlated_period accesses within this period after the last access
+     * are considered correlated, e.g. fetching the same page several times in one operation.
+     * correlated accesses only refresh the last access time, and won't add new history.
+     * frames within this period won't be chosen as victim unless we have no choice
+     */
+    explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_K, size_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+    ~LRUKReplacer() override = default;
+
+    // inherited methods from Replacer
+
+    bool Evict(frame_id_t *victim) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    size_t Size() override;
+
+    std::vector<frame_id_t> GetHotFrames() override;
+
+private:
+    /**
+     * @brief
+     * record an access to the frame. should be called with mutex held
+     */
+    void RecordAccess(frame_id_t frame_id);
+
+    /**
+     * @brief
+     * the k-th most recent uncorrelated access of the frame.
+     * should be called with mutex held
+     * @return 0 when the frame has less than k accesses
+     */
+    uint64_t KthAccess(frame_id_t frame_id);
+
+    // number of frames
+    size_t num_pages_;
+    // k
+    size_t k_;
+    // correlated reference period
+    size_t correlated_period_;
+    // logical clock
+    uint64_t current_timestamp_{0};
+    // the most recent k uncorrelated accesses of every frame,
+    // k slots per frame and used as a ring buffer
+    std::vector<uint64_t> history_;
+    // number of uncorrelated accesses of every frame
+    std::vector<size_t> access_count_;
+    // time of the last access(including correlated ones) of every frame
+    std::vector<uint64_t> last_access_;
+    // whether frame could be chosen as victim
+    std::vector<bool> evictable_;
+    // number of evictable frames
+    size_t size_{0};
+
+    std::mutex mu_;
+};
+
+}
+
+#endif
@@ -49,6 +49,8 @@ public:
 
     size_t Size() override;
 
+    std::vector<frame_id_t> GetHotFrames() override;
+
 private:
     using list_t = std::list<frame_id_t>;
     list_t list_;
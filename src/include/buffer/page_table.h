@@ -0,0 +1,113 @@
+/**
+ * @file page_table.h
+ * @author sheep
+ * @brief open-addressing hash table mapping page id to frame id.
+ * lookup is latch-free, modifications should be serialized by the owner.
+ * @version 0.1
+ * @date 2022-06-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include "common/config.h"
+#include "common/macros.h"
+
+#include <atomic>
+#include <memory>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * Every slot is a single 64-bit word (page id in the high half, frame id in the low half),
+ * so readers can never see a torn entry. Readers may miss an entry that is being inserted
+ * or rebuilt concurrently, thus a miss is only a hint and caller should fall back
+ * to the latched path. Writers(Insert/Erase) must be serialized by the caller.
+ */
+class PageTable {
+public:
+    /**
+     * @brief Construct a new Page Table object
+     * @param capacity maximum number of live entries
+     */
+    explicit PageTable(size_t capacity);
+
+    ~PageTable() = default;
+
+    DISALLOW_COPY_AND_MOVE(PageTable);
+
+    /**
+     * @brief
+     * find the frame that holds the page. latch-free
+     * @param page_id
+     * @return frame id, or INVALID_FRAME_ID when we didn't find it
+     */
+    frame_id_t Find(page_id_t page_id) const;
+
+    /**
+     * @brief
+     * insert a new mapping. caller should make sure page id doesn't exist
+     * @param page_id
+     * @param frame_id
+     */
+    void Insert(page_id_t page_id, frame_id_t frame_id);
+
+    /**
+     * @brief
+     * remove the mapping of page id
+     * @param page_id
+     * @return true when we found and removed it
+     */
+    bool Erase(page_id_t page_id);
+
+    size_t Size() const {
+        return size_;
+    }
+
+private:
+    static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);
+    // page id should never be negative, so we use -2 as the key of tombstone
+    static constexpr uint64_t TOMBSTONE_SLOT = (static_cast<uint64_t>(static_cast<uint32_t>(-2)) << 32);
+
+    static inline uint64_t MakeSlot(page_id_t page_id, frame_id_t frame_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+    }
+
+    static inline page_id_t SlotKey(uint64_t slot) {
+        return static_cast<page_id_t>(slot >> 32);
+    }
+
+    static inline frame_id_t SlotValue(uint64_t slot) {
+        return static_cast<frame_id_t>(slot & 0xffffffff);
+    }
+
+    inline size_t Hash(page_id_t page_id) const {
+        // fibonacci hashing, sequential page ids will be spread out
+        return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 11400714819323198485ull) >> shift_;
+    }
+
+    /**
+     * @brief
+     * clear all the tombstones by re-inserting live entries
+     */
+    void Rebuild();
+
+    // number of slots, always power of 2
+    size_t slot_num_;
+    // shift used by hash function, 64 - log2(slot_num_)
+    uint32_t shift_;
+    // slot array
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    // number of live entries
+    size_t size_{0};
+    // number of tombstones
+    size_t tombstone_num_{0};
+};
+
+}
+
+#endif
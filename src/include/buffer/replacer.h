@@ -15,8 +15,20 @@
 
 #include "common/config.h"
 
+#include <vector>
+
 namespace TinyDB {
 
+/**
+ * @brief
+ * replacement policy used by buffer pool
+ */
+enum class ReplacerType {
+    LRU,
+    CLOCK,
+    LRUK,
+};
+
 /**
  * @brief 
  * whenever the page is not pinned, which means that page
@@ -59,6 +71,14 @@ public:
      * @return size_t 
      */
     virtual size_t Size() = 0;
+
+    /**
+     * @brief
+     * return evictable frames ordered by hotness, the hottest one first.
+     * i.e. roughly the reverse of eviction order
+     * @return std::vector<frame_id_t>
+     */
+    virtual std::vector<frame_id_t> GetHotFrames() = 0;
 };
 
 }
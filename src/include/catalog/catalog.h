@@ -20,6 +20,8 @@
 #include <memory>
 #include <atomic>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace TinyDB {
 
@@ -27,14 +29,36 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+// name of the buffer pool passed to the constructor of catalog
+static constexpr const char *DEFAULT_BUFFER_POOL = "default";
+
+/**
+ * @brief
+ * statistics of a named buffer pool
+ */
+struct BufferPoolStats {
+    std::string name_;
+    // number of frames
+    size_t pool_size_;
+    // fetches served from memory
+    size_t hit_count_;
+    // fetches that had to bring the page in
+    size_t miss_count_;
+};
+
 struct IndexInfo {
-    IndexInfo(std::unique_ptr<Index> &&index, index_oid_t index_oid)
+    IndexInfo(std::unique_ptr<Index> &&index, index_oid_t index_oid, std::string pool_name, BufferPoolManager *bpm)
         : index_(std::move(index)),
-          index_oid_(index_oid) {}
+          index_oid_(index_oid),
+          pool_name_(std::move(pool_name)),
+          bpm_(bpm) {}
 
     // index has the index metadata, so we don't need to store additional metadata
     std::unique_ptr<Index> index_;
     index_oid_t index_oid_;
+    // buffer pool holding pages of this index
+    std::string pool_name_;
+    BufferPoolManager *bpm_;
 };
 
 /**
@@ -43,11 +67,14 @@ struct IndexInfo {
  */
 class TableInfo {
 public:
-    TableInfo(Schema schema, std::string name, std::unique_ptr<TableHeap> &&table, table_oid_t oid)
+    TableInfo(Schema schema, std::string name, std::unique_ptr<TableHeap> &&table, table_oid_t oid,
+              std::string pool_name, BufferPoolManager *bpm)
         : schema_(schema),
           name_(name),
           table_(std::move(table)),
-          oid_(oid) {}
+          oid_(oid),
+          pool_name_(std::move(pool_name)),
+          bpm_(bpm) {}
     
     // table schema
     Schema schema_;
@@ -57,6 +84,9 @@ public:
     std::unique_ptr<TableHeap> table_;
     // table oid
     table_oid_t oid_;
+    // buffer pool holding pages of this table
+    std::string pool_name_;
+    BufferPoolManager *bpm_;
     // index_oid -> index metadata
     std::unordered_map<index_oid_t, std::unique_ptr<IndexInfo>> indexes_;
     // index_name -> index_oid
@@ -81,11 +111,52 @@ public:
     /**
      * @brief 
      * Create in-memory catalog object
-     * @param bpm 
+     * @param bpm default buffer pool, registered as DEFAULT_BUFFER_POOL
      * @param log_manager
      */
     Catalog(BufferPoolManager *bpm, LogManager *log_manager = nullptr)
-        : bpm_(bpm), log_manager_(log_manager) {}
+        : bpm_(bpm), log_manager_(log_manager) {
+        buffer_pools_[DEFAULT_BUFFER_POOL] = bpm;
+    }
+
+    /**
+     * @brief
+     * register a named buffer pool, so that tables and indexes could be assigned to it.
+     * e.g. keep hot indexes in a dedicated pool, and bulk tables in another one.
+     * pools should share the same disk manager, and outlive the catalog
+     * @param pool_name
+     * @param bpm
+     */
+    void RegisterBufferPool(const std::string &pool_name, BufferPoolManager *bpm) {
+        std::lock_guard<std::mutex> guard(latch_);
+        TINYDB_ASSERT(buffer_pools_.count(pool_name) == 0, "Buffer pool name should be unique");
+        buffer_pools_[pool_name] = bpm;
+    }
+
+    /**
+     * @brief
+     * get the named buffer pool
+     * @param pool_name
+     * @return BufferPoolManager* nullptr when it's not registered
+     */
+    BufferPoolManager *GetBufferPool(const std::string &pool_name) {
+        std::lock_guard<std::mutex> guard(latch_);
+        return GetBufferPoolHelper(pool_name);
+    }
+
+    /**
+     * @brief
+     * get capacity and hit/miss statistics of every registered buffer pool
+     * @return std::vector<BufferPoolStats>
+     */
+    std::vector<BufferPoolStats> GetBufferPoolStats() {
+        std::lock_guard<std::mutex> guard(latch_);
+        std::vector<BufferPoolStats> res;
+        for (const auto &[name, bpm] : buffer_pools_) {
+            res.push_back({name, bpm->GetPoolSize(), bpm->GetHitCount(), bpm->GetMissCount()});
+        }
+        return res;
+    }
 
     /**
      * @brief 
@@ -93,20 +164,40 @@ public:
      * @param table_name 
      * @param schema 
      * @param context context for txn to create this table
-     * @return TableInfo* 
+     * @param pool_name buffer pool that pages of this table are cached in
+     * @return TableInfo* nullptr when buffer pool is not registered
      */
-    TableInfo *CreateTable(const std::string &table_name, const Schema &schema, TransactionContext *context = nullptr) {
+    TableInfo *CreateTable(const std::string &table_name, const Schema &schema, TransactionContext *context = nullptr,
+                           const std::string &pool_name = DEFAULT_BUFFER_POOL) {
         std::lock_guard<std::mutex> guard(latch_);
         TINYDB_ASSERT(table_names_.count(table_name) == 0, "Table name should be unique");
-        table_oid_t new_oid = next_table_oid_++;
-        table_names_[table_name] = new_oid;
-        auto new_table = 
-            std::make_unique<TableInfo>(schema,
-                                        table_name,
-                                        std::make_unique<TableHeap>(bpm_, context, log_manager_),
-                                        new_oid);
-        tables_[new_oid] = std::move(new_table);
-        return tables_[new_oid].get();
+        auto bpm = GetBufferPoolHelper(pool_name);
+        if (bpm == nullptr) {
+            return nullptr;
+        }
+        return AddTableHelper(table_name, schema, std::make_unique<TableHeap>(bpm, context, log_manager_), pool_name, bpm);
+    }
+
+    /**
+     * @brief
+     * register a table whose heap already exists on disk. catalog isn't persisted,
+     * so it's used to restore the tables after restart
+     * @param table_name
+     * @param schema
+     * @param first_page_id id of the first page of table heap
+     * @param pool_name buffer pool that pages of this table are cached in
+     * @return TableInfo* nullptr when buffer pool is not registered
+     */
+    TableInfo *OpenTable(const std::string &table_name, const Schema &schema, page_id_t first_page_id,
+                         const std::string &pool_name = DEFAULT_BUFFER_POOL) {
+        std::lock_guard<std::mutex> guard(latch_);
+        TINYDB_ASSERT(table_names_.count(table_name) == 0, "Table name should be unique");
+        auto bpm = GetBufferPoolHelper(pool_name);
+        if (bpm == nullptr) {
+            return nullptr;
+        }
+        return AddTableHelper(table_name, schema, std::make_unique<TableHeap>(first_page_id, bpm, log_manager_),
+                              pool_name, bpm);
     }
 
     TableInfo *GetTable(const std::string &table_name) {
@@ -129,11 +220,16 @@ public:
                            const Schema &tuple_schema,
                            const std::vector<uint32_t> &key_attrs,
                            IndexType type,
-                           size_t key_size) {
+                           size_t key_size,
+                           const std::string &pool_name = DEFAULT_BUFFER_POOL) {
         std::lock_guard<std::mutex> guard(latch_);
         if (table_names_.count(table_name) == 0) {
             return nullptr;
         }
+        auto bpm = GetBufferPoolHelper(pool_name);
+        if (bpm == nullptr) {
+            return nullptr;
+        }
 
         index_oid_t new_oid = next_index_oid_++;
 
@@ -145,7 +241,7 @@ public:
                                                                key_size);
         // use index builder to build the index based on index metadata
         // the metadata will be stored in index
-        auto index = IndexBuilder::Build(std::move(index_metadata), bpm_);
+        auto index = IndexBuilder::Build(std::move(index_metadata), bpm);
 
         // then we populate the data into index
         // TODO: should we use another abstraction layer to do the population?
@@ -156,7 +252,7 @@ public:
         }
 
         auto index_info =
-            std::make_unique<IndexInfo>(std::move(index), new_oid);
+            std::make_unique<IndexInfo>(std::move(index), new_oid, pool_name, bpm);
         table->indexes_[new_oid] = std::move(index_info);
         table->index_names_[index_name] = new_oid;
         return table->indexes_[new_oid].get();
@@ -194,6 +290,14 @@ public:
     }
 
 private:
+    TableInfo *AddTableHelper(const std::string &table_name, const Schema &schema, std::unique_ptr<TableHeap> &&table,
+                              const std::string &pool_name, BufferPoolManager *bpm) {
+        table_oid_t new_oid = next_table_oid_++;
+        table_names_[table_name] = new_oid;
+        tables_[new_oid] = std::make_unique<TableInfo>(schema, table_name, std::move(table), new_oid, pool_name, bpm);
+        return tables_[new_oid].get();
+    }
+
     TableInfo *GetTableHelper(table_oid_t table_oid) {
         if (tables_.count(table_oid) == 0) {
             return nullptr;
@@ -202,9 +306,17 @@ private:
         return tables_[table_oid].get();
     }
 
-    // bpm
+    BufferPoolManager *GetBufferPoolHelper(const std::string &pool_name) {
+        auto it = buffer_pools_.find(pool_name);
+        return it == buffer_pools_.end() ? nullptr : it->second;
+    }
+
+    // default bpm
     BufferPoolManager *bpm_;
 
+    // pool_name -> bpm
+    std::unordered_map<std::string, BufferPoolManager *> buffer_pools_;
+
     // table_oid -> table metadata
     std::unordered_map<table_oid_t, std::unique_ptr<TableInfo>> tables_;
 
@@ -18,17 +18,23 @@
 
 namespace TinyDB {
 
-// size of a page, which is the basic unit of our database
+// size of a page, which is the basic unit of our database. it's the default and also the
+// smallest page size, a db could choose a larger one when it's created, see DISK_PAGE_SIZE
 static constexpr uint32_t PAGE_SIZE = 4096;
 
-// size of buffer pool, should be configured based on your memory
-static constexpr uint32_t BUFFER_POOL_SIZE = 10;
+// largest page size supported
+static constexpr uint32_t MAX_PAGE_SIZE = 32 * 1024;
 
-// size of log buffer
-static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);
+// minimum size of buffer pool. buffer pool is sized to the host's memory at runtime
+// unless a size is given, check BufferPoolManager::GetDefaultPoolSize for more details
+static constexpr uint32_t MIN_BUFFER_POOL_SIZE = 10;
+
+// size of log buffer, it's independent of buffer pool size
+static constexpr int LOG_BUFFER_SIZE = 11 * PAGE_SIZE;
 
 // special values
 static constexpr int INVALID_PAGE_ID = -1;
+static constexpr int INVALID_FRAME_ID = -1;
 static constexpr int INVALID_TXN_ID = -1;
 static constexpr int INVALID_LSN = -1;
 
@@ -47,6 +53,81 @@ extern std::chrono::milliseconds CYCLE_DETECTION_INTERVAL;
 // interval for flushing the log
 extern std::chrono::milliseconds LOG_TIMEOUT;
 
+// whether committers sleep until flush thread wakes them up. otherwise they spin on persistent lsn,
+// which is kept for comparison
+extern bool LOG_GROUP_COMMIT;
+
+// number of accesses remembered by lru-k replacer
+extern size_t LRUK_K;
+
+// accesses to the same frame within this period (counted in accesses to the replacer)
+// are considered correlated, and count as a single access in lru-k replacer
+extern size_t LRUK_CORRELATED_PERIOD;
+
+// maximum number of frames a bulk read(e.g. sequential scan) could occupy in every buffer pool instance.
+// it's also limited to 1/8 of the instance
+extern size_t BULKREAD_RING_SIZE;
+
+// sequential scan only uses the bulk read ring when table has more pages than this fraction of the buffer pool,
+// smaller tables are cached as usual
+extern double BULKREAD_TABLE_RATIO;
+
+// interval for running page cleaner
+extern std::chrono::milliseconds PAGE_CLEANER_INTERVAL;
+
+// fraction of evictable frames page cleaner tries to keep clean
+extern double PAGE_CLEANER_CLEAN_RATIO;
+
+// maximum number of pages page cleaner writes in one instance per round
+extern size_t PAGE_CLEANER_BATCH_SIZE;
+
+// fraction of physical memory used by buffer pool by default
+extern double BUFFER_POOL_MEMORY_RATIO;
+
+// interval for dumping the resident page ids of buffer pool, used for warm restart
+extern std::chrono::milliseconds BUFFER_POOL_DUMP_INTERVAL;
+
+// whether buffer pool should ask kernel to back frames with huge pages
+extern bool BUFFER_POOL_HUGE_PAGE;
+
+// how long FetchPage/NewPage wait for an evictable frame when every frame is pinned.
+// 0 means returning nullptr immediately
+extern std::chrono::milliseconds FRAME_WAIT_TIMEOUT;
+
+// number of pages read ahead along the page chain by heap and index scans, 0 to disable read-ahead
+extern size_t READ_AHEAD_DEPTH;
+
+// maximum number of pending read-ahead requests, new requests are dropped when queue is full
+extern size_t PREFETCH_QUEUE_SIZE;
+
+// open db file with O_DIRECT, so that pages bypass kernel page cache and buffer pool
+// owns all of the caching. it's ignored when file system doesn't support it
+extern bool DISK_DIRECT_IO;
+
+// depth of io_uring used by disk manager to submit page I/O batches.
+// 0 to disable it, then batches are performed synchronously
+extern size_t IO_URING_QUEUE_DEPTH;
+
+// compress pages on writeback and decompress them on fetch. pages are stored in variable-size
+// slots of a side file, O_DIRECT and io_uring are not used with it
+extern bool DISK_PAGE_COMPRESSION;
+
+// size of segment file of db in bytes. db is split into segment files which are
+// created on demand. it can't be changed once db is created
+extern size_t DISK_SEGMENT_SIZE;
+
+// page size of db created from now on, one of 4/8/16/32KB. it's stored in the header of db file,
+// so an existing db keeps it's own page size
+extern size_t DISK_PAGE_SIZE;
+
+// number of log partitions. every partition has it's own log buffer and log file, appenders
+// are spread over them so that they won't contend on a single log tail. 1 means a single log
+extern size_t LOG_PARTITION_NUM;
+
+// number of pages db file is extended by when allocation reaches the end of file.
+// extents are preallocated, so that allocating a page doesn't write it
+extern size_t DISK_EXTENSION_PAGES;
+
 constexpr bool ENABLE_LOGGING = false;
 
 };
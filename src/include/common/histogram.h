@@ -0,0 +1,102 @@
+/**
+ * @file histogram.h
+ * @author sheep
+ * @brief latency histogram
+ * @version 0.1
+ * @date 2022-07-08
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "common/macros.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * histogram of latencies in microseconds. bucket i holds the samples in [2^(i-1), 2^i),
+ * so it's cheap enough to be recorded concurrently on hot path, with error within 2x
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKET_NUM = 32;
+
+    LatencyHistogram() = default;
+
+    DISALLOW_COPY_AND_MOVE(LatencyHistogram);
+
+    void Record(std::chrono::nanoseconds latency) {
+        auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+        size_t bucket = 0;
+        while (bucket + 1 < BUCKET_NUM && (us >> bucket) != 0) {
+            bucket++;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    uint64_t GetCount() const {
+        return count_.load();
+    }
+
+    /**
+     * @brief
+     * upper bound of the bucket where the percentile falls in
+     * @param percentile in (0, 100]
+     * @return uint64_t latency in microseconds
+     */
+    uint64_t GetPercentile(double percentile) const {
+        uint64_t count = count_.load();
+        if (count == 0) {
+            return 0;
+        }
+        auto target = static_cast<uint64_t>(count * percentile / 100);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_NUM; i++) {
+            seen += buckets_[i].load();
+            if (seen >= target && seen != 0) {
+                return static_cast<uint64_t>(1) << i;
+            }
+        }
+        return static_cast<uint64_t>(1) << (BUCKET_NUM - 1);
+    }
+
+    void Reset() {
+        for (auto &bucket : buckets_) {
+            bucket.store(0);
+        }
+        count_.store(0);
+        sum_.store(0);
+    }
+
+    std::string ToString() const {
+        auto count = count_.load();
+        std::stringstream os;
+        os << "Count: " << count << ", "
+           << "Avg: " << (count == 0 ? 0 : sum_.load() / count) << "us, "
+           << "P50: " << GetPercentile(50) << "us, "
+           << "P99: " << GetPercentile(99) << "us, "
+           << "P999: " << GetPercentile(99.9) << "us";
+        return os.str();
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKET_NUM]{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+};
+
+}
+
+#endif
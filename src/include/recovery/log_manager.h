@@ -14,40 +14,65 @@
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
+#include "common/histogram.h"
 
 #include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 #include <chrono>
+#include <vector>
 
 namespace TinyDB {
 
 /**
  * @brief 
  * LogManager that will flush the log to disk.
+ * log buffer is a ring addressed by the position of log in the log stream. appenders reserve
+ * lsn together with the space by a single fetch-and-add, then serialize their records into the
+ * ring in parallel. a record is published by advancing the completion watermark, which is done
+ * in the order of reservation, so that everything before the watermark is filled contiguously
+ * and could be written by flush thread while others keep appending.
+ * position and lsn are packed into a 64-bit word:
+ * --------------------------------------
+ * | position (32 bits) | lsn (32 bits) |
+ * --------------------------------------
+ * position wraps around, which is fine since ring size divides 2^32
+ *
+ * with more than one log partition(LOG_PARTITION_NUM), every partition has it's own ring and
+ * log file, and threads are spread over them so that they won't contend on a single log tail.
+ * lsn is still drawn from a global counter, it's taken with the space of partition under the
+ * latch of partition, so that log in every partition is ordered by lsn, and recovery could
+ * merge them back into the global order. log is persisted up to the smallest lsn that might
+ * still be in memory of any partition.
+ *
+ * lsn continues from the log left on disk, so that it keeps increasing across restarts.
  */
 class LogManager {
 public:
     explicit LogManager(DiskManager *disk_manager)
-        : next_lsn_(0), persistent_lsn_(INVALID_LSN), enable_flushing_(false), disk_manager_(disk_manager) {
-        log_size_ = 0;
-        flush_size_ = 0;
-        log_buffer_ = new char[LOG_BUFFER_SIZE];
-        flush_buffer_ = new char[LOG_BUFFER_SIZE];
+        : persistent_lsn_(INVALID_LSN), enable_flushing_(false), disk_manager_(disk_manager) {
+        // partitions left on disk are reused as well
+        for (size_t i = 0; i < disk_manager_->GetLogPartitionNum(); i++) {
+            partitions_.push_back(std::make_unique<LogPartition>());
+        }
+        RestoreLogTail();
         // start running background flush thread
         RunFlushThread();
+        // page allocation is logged as well
+        disk_manager_->SetLogManager(this);
     }
 
     ~LogManager() {
+        disk_manager_->SetLogManager(nullptr);
         StopFlushThread();
-        delete[] log_buffer_;
-        delete[] flush_buffer_;
     }
 
     /**
      * @brief 
-     * Append a log record to log buffer
+     * Append a log record to log buffer, it could be called concurrently
      * @param log_record 
      * @return lsn_t 
      */
@@ -56,7 +81,8 @@ public:
 
     /**
      * @brief 
-     * Flush all the log which lsn is smaller than "lsn"
+     * Flush all the log which lsn is smaller than "lsn". caller sleeps until flush thread
+     * has persisted it, so that concurrent committers share a single write(group commit)
      * @param lsn 
      * @param force whether we need to perform flush immediately, or we just wait until log has been flushed to disk
      */
@@ -66,48 +92,155 @@ public:
         std::stringstream os;
 
         os << "LogManagerTimeConsumption: "
-           << "OperationTime: " << operation_time_.count() << "ms";
+           << "OperationTime: " << operation_time_.load() / 1000000 << "ms, "
+           << "FlushWait: {" << flush_latency_.ToString() << "}, "
+           << "FlushCount: " << flush_count_.load();
         
         return os.str();
     }
 
     /**
      * @brief
-     * used to reset the max lsn
+     * latency of Flush, i.e. how long committers wait for their log
+     */
+    const LatencyHistogram &GetFlushLatency() const {
+        return flush_latency_;
+    }
+
+    /**
+     * @brief
+     * number of batches written by flush thread
+     */
+    size_t GetFlushCount() const {
+        return flush_count_.load();
+    }
+
+    /**
+     * @brief
+     * used to reset the max lsn, there should be no concurrent appender
      * @param lsn 
      */
     void SetNextLsn(lsn_t lsn) {
-        next_lsn_ = lsn;
+        next_lsn_.store(lsn);
+        for (auto &partition : partitions_) {
+            auto state = partition->reserve_state_.load();
+            TINYDB_ASSERT(state == partition->filled_state_.load(), "there are appenders in flight");
+            state = Pack(GetPosition(state), lsn);
+            partition->reserve_state_.store(state);
+            partition->filled_state_.store(state);
+        }
+    }
+
+    size_t GetPartitionNum() const {
+        return partitions_.size();
     }
 
 private:
+    /**
+     * @brief
+     * a thread waiting for it's log to be persisted
+     */
+    struct FlushWaiter {
+        std::condition_variable cv_;
+        bool done_{false};
+    };
+
+    // size of log ring, it should be power of 2
+    static constexpr uint32_t RING_SIZE = 128 * 1024;
+    static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "ring size should be power of 2");
+    static_assert(RING_SIZE >= 2 * LOG_BUFFER_SIZE, "ring should hold two batches at least");
+
+    static uint64_t Pack(uint32_t position, lsn_t lsn) {
+        return (static_cast<uint64_t>(position) << 32) | static_cast<uint32_t>(lsn);
+    }
+
+    static uint32_t GetPosition(uint64_t state) {
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    static lsn_t GetLSN(uint64_t state) {
+        return static_cast<lsn_t>(static_cast<uint32_t>(state));
+    }
+
+    /**
+     * @brief
+     * log ring of a partition, it's flushed to the log file of the same index
+     */
+    struct LogPartition {
+        // records crossing the end of ring are serialized contiguously into the tail, then
+        // the overflowed part is moved to the head
+        LogPartition() : buffer_(new char[RING_SIZE + LOG_BUFFER_SIZE]) {}
+
+        ~LogPartition() {
+            delete[] buffer_;
+        }
+
+        DISALLOW_COPY_AND_MOVE(LogPartition);
+
+        // position and lsn of next record, appenders reserve space from it
+        alignas(64) std::atomic<uint64_t> reserve_state_{0};
+        // completion watermark, i.e. position and lsn after the last published record
+        alignas(64) std::atomic<uint64_t> filled_state_{0};
+        // log before it has been written to disk, and it's space could be reused
+        std::atomic<uint32_t> flushed_position_{0};
+        // serializes reservation when there are many partitions, since lsn comes from next_lsn_
+        std::mutex reserve_latch_;
+        // log ring
+        char *buffer_;
+    };
+
+    /**
+     * @brief
+     * partition used by current thread. threads are assigned round robin on their first append
+     */
+    LogPartition &GetPartition();
+
+    /**
+     * @brief
+     * block until the log before "end" fits in the ring, i.e. older log has been flushed
+     * @param partition
+     * @param end end position of reserved space
+     */
+    void WaitForSpace(LogPartition &partition, uint32_t end);
+
+    /**
+     * @brief
+     * write the published log of a partition to disk
+     * @param partition
+     * @param index index of partition
+     * @return lsn_t all log of this partition before it has been persisted
+     */
+    lsn_t FlushPartition(LogPartition &partition, size_t index);
+
+    /**
+     * @brief
+     * find the end of log left on disk, and continue lsn from it. log after a hole of lsn
+     * is discarded, since it has never been persisted as a whole
+     */
+    void RestoreLogTail();
+
     // helper function
     void FlushThread();
+
     /**
-     * @brief 
-     * Swap the flush buffer and log buffer
+     * @brief
+     * advance persistent lsn, and wake up the waiters whose log is persisted
+     * @param lsn
      */
-    void SwapBuffer();
-
+    void NotifyWaiters(lsn_t lsn);
     void RunFlushThread();
 
     void StopFlushThread();
 
-    // next lsn to be used
-    lsn_t next_lsn_;
+    // log partitions, there is only one by default
+    std::vector<std::unique_ptr<LogPartition>> partitions_;
+    // next lsn when there are many partitions. with a single one, lsn is reserved in it's state
+    alignas(64) std::atomic<lsn_t> next_lsn_{0};
     // all log with lsn less that persistent_lsn_ has been flushed to disk
     std::atomic<lsn_t> persistent_lsn_;
     // whether background flush thread is enabled
     std::atomic<bool> enable_flushing_;
-    // log buffer
-    char *log_buffer_;
-    // log size
-    uint32_t log_size_;
-    // flush buffer
-    char *flush_buffer_;
-    // size of log that is flushing
-    uint32_t flush_size_;
-    // global latch
+    // protects flush_requested_, and used to block appenders waiting for space
     std::mutex latch_;
     // flush thread
     std::thread *flush_thread_;
@@ -115,11 +248,20 @@ private:
     DiskManager *disk_manager_;
     // cv used to wakeup the background thread
     std::condition_variable flush_cv_;
-    // cv used to block normal operation
+    // cv used to block appenders until there is enough space
     std::condition_variable operation_cv_;
+    // whether someone is forcing the log, protected by latch_
+    bool flush_requested_{false};
+    // protects waiters_ and the update of persistent_lsn_
+    std::mutex waiter_latch_;
+    // threads waiting in Flush, keyed by the lsn they are waiting for
+    std::multimap<lsn_t, FlushWaiter *> waiters_;
 
     // for analyse
-    std::chrono::milliseconds operation_time_{0};
+    // in nanoseconds
+    std::atomic<uint64_t> operation_time_{0};
+    LatencyHistogram flush_latency_;
+    std::atomic<size_t> flush_count_{0};
 };
     
 } // namespace TinyDB
@@ -0,0 +1,85 @@
+/**
+ * @file log_reader.h
+ * @author sheep
+ * @brief sequential reader of a log partition
+ * @version 0.1
+ * @date 2022-07-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LOG_READER_H
+#define LOG_READER_H
+
+#include "storage/disk/disk_manager.h"
+#include "common/config.h"
+
+#include <memory>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * reading position in a log partition. log file is read chunk by chunk,
+ * every record starts with it's size followed by the lsn
+ */
+class LogReader {
+public:
+    LogReader(DiskManager *disk_manager, size_t partition);
+
+    /**
+     * @brief
+     * size of the record under the reader, reading next chunk of log if necessary
+     * @return uint32_t size of the record, 0 means we are reaching the end
+     */
+    uint32_t Peek();
+
+    /**
+     * @brief
+     * lsn of the record under the reader, Peek should have returned non-zero
+     */
+    lsn_t GetLSN() const;
+
+    /**
+     * @brief
+     * data of the record under the reader, Peek should have returned non-zero
+     */
+    const char *GetData() const {
+        return buffer_.get() + inner_offset_;
+    }
+
+    /**
+     * @brief
+     * offset of the record under the reader in log file
+     */
+    int GetOffset() const {
+        return offset_ + inner_offset_;
+    }
+
+    /**
+     * @brief
+     * move to the next record
+     * @param size size of the current record, returned by Peek
+     */
+    void Next(uint32_t size) {
+        inner_offset_ += size;
+    }
+
+    size_t GetPartition() const {
+        return partition_;
+    }
+
+private:
+    DiskManager *disk_manager_;
+    size_t partition_;
+    // log data starting from offset_
+    std::unique_ptr<char[]> buffer_;
+    int offset_{0};
+    // offset of next record in buffer
+    int inner_offset_{0};
+};
+
+}
+
+#endif
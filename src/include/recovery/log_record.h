@@ -32,7 +32,11 @@ enum class LogRecordType {
     // txn related
     BEGIN,
     COMMIT,
-    ABORT,  // always keep abort the last one
+    ABORT,
+    // storage related, they don't belong to any txn.
+    // new types go to the end, so that type of the log written before won't change
+    ALLOCATEPAGE,
+    DEALLOCATEPAGE,  // always keep the newest one the last one
 };
 
 /**
@@ -61,6 +65,10 @@ enum class LogRecordType {
  * ---------------------------------------
  * | HEADER | cur_page_id | prev_page_id |
  * ---------------------------------------
+ * For allocate/deallocate page type log record, they are redo-only and txn id is INVALID_TXN_ID
+ * -----------------------
+ * | HEADER | cur_page_id |
+ * -----------------------
  * 
  * sheep: i wonder do we need to store tuple size? for insert and delete type log since we can
  * simply derive it from total size
@@ -101,6 +109,21 @@ public:
         TINYDB_ASSERT(type == LogRecordType::INITPAGE, "Invalid Log Type");
         size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
     }
+
+    /**
+     * @brief
+     * Constructor for allocate/deallocate page log record
+     * @param txn_id 
+     * @param prev_lsn 
+     * @param type 
+     * @param page_id 
+     */
+    LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type, page_id_t page_id)
+        : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type), cur_page_id_(page_id) {
+        TINYDB_ASSERT(type == LogRecordType::ALLOCATEPAGE ||
+                      type == LogRecordType::DEALLOCATEPAGE, "Invalid Log Type");
+        size_ = HEADER_SIZE + sizeof(page_id_t);
+    }
     
     /**
      * @brief 
@@ -141,20 +164,64 @@ public:
         size_ = HEADER_SIZE + sizeof(RID) + sizeof(uint32_t) * 2 + old_tuple.GetSize() + new_tuple.GetSize();
     }
 
+    /**
+     * @brief
+     * Constructor for insert/delete log record that borrows the tuple instead of copying it.
+     * it's used on the write path, tuple should outlive the log record
+     * @param txn_id 
+     * @param prev_lsn 
+     * @param type 
+     * @param rid 
+     * @param tuple 
+     */
+    LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type, const RID &rid, const Tuple *tuple)
+        : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type), rid_(rid) {
+        TINYDB_ASSERT(type == LogRecordType::INSERT ||
+                      type == LogRecordType::APPLYDELETE ||
+                      type == LogRecordType::ROLLBACKDELETE ||
+                      type == LogRecordType::MARKDELETE, "Invalid Log Type");
+        if (type == LogRecordType::INSERT) {
+            new_tuple_ref_ = tuple;
+        } else {
+            old_tuple_ref_ = tuple;
+        }
+        size_ = HEADER_SIZE + sizeof(RID) + sizeof(uint32_t) + tuple->GetSize();
+    }
+
+    /**
+     * @brief 
+     * Constructor for update log record that borrows the tuples instead of copying them
+     * @param txn_id 
+     * @param prev_lsn 
+     * @param type 
+     * @param rid 
+     * @param old_tuple 
+     * @param new_tuple 
+     */
+    LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type, const RID &rid, const Tuple *old_tuple, const Tuple *new_tuple)
+        : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type), old_tuple_ref_(old_tuple), new_tuple_ref_(new_tuple), rid_(rid) {
+        TINYDB_ASSERT(type == LogRecordType::UPDATE, "Invalid Log Type");
+        size_ = HEADER_SIZE + sizeof(RID) + sizeof(uint32_t) * 2 + old_tuple->GetSize() + new_tuple->GetSize();
+    }
+
     ~LogRecord() = default;
 
-    const Tuple &GetNewTuple() {
-        return new_tuple_;
+    const Tuple &GetNewTuple() const {
+        return new_tuple_ref_ != nullptr ? *new_tuple_ref_ : new_tuple_;
     }
 
-    const Tuple &GetOldTuple() {
-        return old_tuple_;
+    const Tuple &GetOldTuple() const {
+        return old_tuple_ref_ != nullptr ? *old_tuple_ref_ : old_tuple_;
     }
 
     const RID &GetRID() {
         return rid_;
     }
 
+    page_id_t GetPageId() {
+        return cur_page_id_;
+    }
+
     LogRecordType GetType() {
         return type_;
     }
@@ -208,22 +275,22 @@ public:
                    txn_id_ == rhs.txn_id_ &&
                    lsn_ == rhs.lsn_ &&
                    rid_ == rhs.rid_ &&
-                   old_tuple_ == rhs.old_tuple_;
+                   GetOldTuple() == rhs.GetOldTuple();
         case LogRecordType::INSERT:
             return size_ == rhs.size_ &&
                    prev_lsn_ == rhs.prev_lsn_ &&
                    txn_id_ == rhs.txn_id_ &&
                    lsn_ == rhs.lsn_ &&
                    rid_ == rhs.rid_ &&
-                   new_tuple_ == rhs.new_tuple_;
+                   GetNewTuple() == rhs.GetNewTuple();
         case LogRecordType::UPDATE:
             return size_ == rhs.size_ &&
                    prev_lsn_ == rhs.prev_lsn_ &&
                    txn_id_ == rhs.txn_id_ &&
                    lsn_ == rhs.lsn_ &&
                    rid_ == rhs.rid_ &&
-                   old_tuple_ == rhs.old_tuple_ &&
-                   new_tuple_ == rhs.new_tuple_;
+                   GetOldTuple() == rhs.GetOldTuple() &&
+                   GetNewTuple() == rhs.GetNewTuple();
         case LogRecordType::INITPAGE:
             return size_ == rhs.size_ &&
                    prev_lsn_ == rhs.prev_lsn_ &&
@@ -231,6 +298,13 @@ public:
                    lsn_ == rhs.lsn_ &&
                    prev_page_id_ == rhs.prev_page_id_ &&
                    cur_page_id_ == rhs.cur_page_id_;
+        case LogRecordType::ALLOCATEPAGE:
+        case LogRecordType::DEALLOCATEPAGE:
+            return size_ == rhs.size_ &&
+                   prev_lsn_ == rhs.prev_lsn_ &&
+                   txn_id_ == rhs.txn_id_ &&
+                   lsn_ == rhs.lsn_ &&
+                   cur_page_id_ == rhs.cur_page_id_;
         case LogRecordType::INVALID:
             return true;
         default:
@@ -268,20 +342,20 @@ public:
         case LogRecordType::MARKDELETE: {
             serialize_header();
             auto size = rid_.SerializeTo(storage);
-            old_tuple_.SerializeToWithSize(storage + size);
+            GetOldTuple().SerializeToWithSize(storage + size);
             break;
         }
         case LogRecordType::INSERT: {
             serialize_header();
             auto size = rid_.SerializeTo(storage);
-            new_tuple_.SerializeToWithSize(storage + size);
+            GetNewTuple().SerializeToWithSize(storage + size);
             break;
         }
         case LogRecordType::UPDATE: {
             serialize_header();
             storage += rid_.SerializeTo(storage);
-            storage += old_tuple_.SerializeToWithSize(storage);
-            new_tuple_.SerializeToWithSize(storage);
+            storage += GetOldTuple().SerializeToWithSize(storage);
+            GetNewTuple().SerializeToWithSize(storage);
             break;
         }
         case LogRecordType::INITPAGE: {
@@ -291,6 +365,12 @@ public:
             memcpy(storage, &prev_page_id_, sizeof(page_id_t));
             break;
         }
+        case LogRecordType::ALLOCATEPAGE:
+        case LogRecordType::DEALLOCATEPAGE: {
+            serialize_header();
+            memcpy(storage, &cur_page_id_, sizeof(page_id_t));
+            break;
+        }
         default:
             TINYDB_ASSERT(false, "Invalid Log Type");
         }
@@ -349,6 +429,12 @@ public:
             res = LogRecord(txn_id, prev_lsn, type, cur_page_id, prev_page_id);
             break;
         }
+        case LogRecordType::ALLOCATEPAGE:
+        case LogRecordType::DEALLOCATEPAGE: {
+            auto page_id = *reinterpret_cast<const page_id_t *>(storage);
+            res = LogRecord(txn_id, prev_lsn, type, page_id);
+            break;
+        }
         default:
             TINYDB_ASSERT(false, "Invalid Log Type");
         }
@@ -384,6 +470,9 @@ private:
     // RID update_rid_;
     Tuple old_tuple_;
     Tuple new_tuple_;
+    // borrowed tuples, they take precedence over the owned ones
+    const Tuple *old_tuple_ref_{nullptr};
+    const Tuple *new_tuple_ref_{nullptr};
     
     // coallpse insert_rid_, delete_rid_ and update_rid_ to rid_;
     RID rid_;
@@ -16,14 +16,21 @@
 #include "storage/disk/disk_manager.h"
 #include "recovery/log_manager.h"
 #include "recovery/log_record.h"
+#include "recovery/log_reader.h"
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace TinyDB {
 
 /**
  * @brief 
  * Just ARIES
+ * log partitions are merged by lsn while redoing. lsn keeps increasing across restarts, and log
+ * that was never persisted as a whole has been cut by log manager, see LogManager::RestoreLogTail.
+ * pages are recovered through the pool caching them, or through our own pool otherwise,
+ * which is flushed at the end when there are other pools. so every pool should share the same disk manager
  */
 class RecoveryManager {
 public:
@@ -42,7 +49,40 @@ public:
      */
     void ARIES();
 
+    /**
+     * @brief
+     * register another buffer pool, e.g. a named pool of catalog. page it's caching is
+     * recovered in place, so that it won't keep a stale copy
+     * @param bpm
+     */
+    void AddBufferPool(BufferPoolManager *bpm) {
+        buffer_pools_.push_back(bpm);
+    }
+
 private:
+    /**
+     * @brief
+     * location of a log record
+     */
+    struct LogLocation {
+        size_t partition_;
+        int offset_;
+        int size_;
+    };
+
+    /**
+     * @brief
+     * redo the record reader is pointing to, and move to the next one
+     * @param reader
+     */
+    void RedoNext(LogReader &reader);
+
+    /**
+     * @brief
+     * pool the page should be recovered through
+     */
+    BufferPoolManager *GetBufferPool(page_id_t page_id);
+
     // helper function
     void Scan();
     void Redo();
@@ -55,13 +95,15 @@ private:
 
     DiskManager *disk_manager_;
     BufferPoolManager *buffer_pool_manager_;
+    // other pools sharing the disk manager
+    std::vector<BufferPoolManager *> buffer_pools_;
     LogManager *log_manager_;
     // we need to keep track of what txn we need to undo
     // txn -> last lsn
     std::unordered_map<txn_id_t, lsn_t> active_txn_;
     // remember the offset of a log record
-    // lsn -> (offset in disk, size of log)
-    std::unordered_map<lsn_t, std::pair<int, int>> lsn_mapping_;
+    // lsn -> (partition, offset in disk, size of log)
+    std::unordered_map<lsn_t, LogLocation> lsn_mapping_;
 };
 
 }
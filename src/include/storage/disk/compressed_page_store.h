@@ -0,0 +1,161 @@
+/**
+ * @file compressed_page_store.h
+ * @author sheep
+ * @brief store pages compressed in variable-size slots
+ * @version 0.1
+ * @date 2022-07-04
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef COMPRESSED_PAGE_STORE_H
+#define COMPRESSED_PAGE_STORE_H
+
+#include "common/config.h"
+#include "common/macros.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * pages are compressed on write and stored in slots of a data file. slots are made of
+ * sectors, page translation table maps every page to it's slot.
+ * table is written back in Sync after the data it's pointing to. slots released
+ * by rewritten pages are reused only after that, so the table on disk always points
+ * to valid, though maybe older, versions of pages.
+ *
+ * Page translation table entry:
+ * -------------------------------------------
+ * | offset (8 bytes) | length | reserved |
+ * -------------------------------------------
+ * length is 0 when page is not stored, page size when it's stored raw
+ */
+class CompressedPageStore {
+public:
+    static constexpr size_t SECTOR_SIZE = 512;
+
+    /**
+     * @brief Construct a new Compressed Page Store object
+     * @param data_name file name of slots, it will be created if it doesn't exist
+     * @param table_name file name of page translation table
+     * @param page_size size of pages
+     */
+    CompressedPageStore(const std::string &data_name, const std::string &table_name, size_t page_size);
+
+    ~CompressedPageStore();
+
+    DISALLOW_COPY_AND_MOVE(CompressedPageStore);
+
+    /**
+     * @brief
+     * read and decompress the page
+     * @param page_id
+     * @param data
+     * @return false if page is not stored here
+     */
+    bool ReadPage(page_id_t page_id, char *data);
+
+    /**
+     * @brief
+     * compress the page and write it into a new slot, the old slot is released after next Sync.
+     * writes of the same page should be serialized by caller
+     * @param page_id
+     * @param data
+     */
+    void WritePage(page_id_t page_id, const char *data);
+
+    bool Contains(page_id_t page_id);
+
+    /**
+     * @brief
+     * whether no page is stored
+     */
+    bool IsEmpty();
+
+    /**
+     * @brief
+     * make written pages durable, and release the slots that are no longer referenced
+     */
+    void Sync();
+
+    /**
+     * @brief
+     * bytes written to slots divided by bytes of pages written
+     */
+    double GetCompressionRatio() const;
+
+    /**
+     * @brief
+     * compression ratio and CPU cost per page
+     */
+    std::string GetCompressionReport() const;
+
+private:
+    struct Entry {
+        uint64_t offset_;
+        uint32_t length_;
+        uint32_t reserved_;
+    };
+
+    static constexpr size_t ENTRIES_PER_CHUNK = PAGE_SIZE / sizeof(Entry);
+
+    static size_t GetSectorCount(size_t length) {
+        return (length + SECTOR_SIZE - 1) / SECTOR_SIZE;
+    }
+
+    /**
+     * @brief
+     * read the table and rebuild free slots from the gaps between used ones
+     */
+    void LoadTable();
+
+    /**
+     * @brief
+     * take a slot of the given number of sectors. called with latch held
+     * @return uint64_t offset of the slot
+     */
+    uint64_t AllocateSlot(size_t sectors);
+
+    // size of pages before compression
+    size_t page_size_;
+    // file name for slots
+    std::string data_name_;
+    // file name for page translation table
+    std::string table_name_;
+    int data_fd_{-1};
+    int table_fd_{-1};
+    // protects everything below
+    std::mutex latch_;
+    // page translation table, indexed by page id
+    std::vector<Entry> table_;
+    // whether a chunk of table is modified since last Sync
+    std::vector<bool> dirty_chunks_;
+    // free slots, indexed by number of sectors
+    std::vector<std::vector<uint64_t>> free_slots_;
+    // slots released since last Sync, table on disk may still point to them
+    std::vector<std::pair<uint64_t, size_t>> pending_slots_;
+    // end of data file
+    uint64_t data_end_{0};
+    // number of pages stored
+    size_t page_count_{0};
+    // serializes Sync
+    std::mutex sync_latch_;
+
+    // for analysis
+    std::atomic<uint64_t> raw_bytes_{0};
+    std::atomic<uint64_t> stored_bytes_{0};
+    std::atomic<uint64_t> compress_count_{0};
+    std::atomic<uint64_t> compress_time_{0};
+    std::atomic<uint64_t> decompress_count_{0};
+    std::atomic<uint64_t> decompress_time_{0};
+};
+
+}
+
+#endif
@@ -16,11 +16,70 @@
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
 
 #include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/compressed_page_store.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/io_uring.h"
 
 namespace TinyDB {
 
+class DiskManager;
+class LogManager;
+
+/**
+ * @brief
+ * a batch of page reads and writes that are submitted together. requests shouldn't be
+ * added after the batch is submitted, and buffers should stay valid until it's completed
+ */
+class IOBatch {
+    friend class DiskManager;
+public:
+    IOBatch() = default;
+
+    DISALLOW_COPY_AND_MOVE(IOBatch);
+
+    void AddRead(page_id_t page_id, char *data, bool outbound_is_error = false) {
+        requests_.push_back({this, page_id, data, false, outbound_is_error});
+    }
+
+    void AddWrite(page_id_t page_id, const char *data) {
+        requests_.push_back({this, page_id, const_cast<char *>(data), true, false});
+    }
+
+    size_t Size() const {
+        return requests_.size();
+    }
+
+    bool IsCompleted() const {
+        return pending_.load() == 0;
+    }
+
+private:
+    struct Request {
+        IOBatch *batch_;
+        page_id_t page_id_;
+        char *data_;
+        bool is_write_;
+        bool outbound_is_error_;
+        // aligned copy of data_ used by direct I/O, nullptr when data_ is aligned
+        char *bounce_{nullptr};
+    };
+
+    std::vector<Request> requests_;
+    // requests that are still in flight
+    std::atomic<size_t> pending_{0};
+};
+
 class DiskManager {
 public:
     /**
@@ -37,7 +96,8 @@ public:
     ~DiskManager();
 
     /**
-     * @brief flush the data to the page
+     * @brief write the data to the page. it's a positional write and could be issued concurrently,
+     * page is not forced to disk until Sync is called
      * 
      * @param pageId id of the page you want to write
      * @param data corresponding data you want to write
@@ -45,7 +105,7 @@ public:
     void WritePage(page_id_t pageId, const char *data);
 
     /**
-     * @brief read the page from disk
+     * @brief read the page from disk. it's a positional read and could be issued concurrently
      * 
      * @param pageId id of the page you want to read
      * @param data buffer which will store the result
@@ -55,7 +115,92 @@ public:
     void ReadPage(page_id_t pageId, char *data, bool outbound_is_error = true);
 
     /**
-     * @brief allocate a new page
+     * @brief
+     * submit a batch of page I/O without waiting for it. with io_uring, requests are
+     * handed to kernel together, otherwise they are performed synchronously right now
+     * @param batch
+     */
+    void SubmitBatch(IOBatch *batch);
+
+    /**
+     * @brief
+     * wait until every request of the batch is completed
+     * @param batch
+     */
+    void WaitBatch(IOBatch *batch);
+
+    /**
+     * @brief
+     * submit the batch and wait for it
+     * @param batch
+     */
+    void ExecuteBatch(IOBatch *batch) {
+        SubmitBatch(batch);
+        WaitBatch(batch);
+    }
+
+    /**
+     * @brief
+     * whether page I/O batches are performed through io_uring
+     */
+    bool IsAsyncIOEnabled() const {
+        return ring_ != nullptr;
+    }
+
+    /**
+     * @brief
+     * whether db file is opened with O_DIRECT. buffers that aren't aligned
+     * to DIRECT_IO_ALIGNMENT are bounced through an aligned copy
+     */
+    bool IsDirectIOEnabled() const {
+        return direct_io_;
+    }
+
+    // alignment of buffer, offset and size required by direct I/O
+    static constexpr size_t DIRECT_IO_ALIGNMENT = PAGE_SIZE;
+    // number of pages taken by the header of db file, pages are stored after it.
+    // db file without header is opened as a legacy one, with default page size and no header page
+    static constexpr size_t HEADER_PAGE_COUNT = 1;
+
+    /**
+     * @brief
+     * size of pages of this db, it's fixed when db is created
+     */
+    size_t GetPageSize() const {
+        return page_size_;
+    }
+
+    /**
+     * @brief
+     * whether page size is supported, i.e. a power of 2 between PAGE_SIZE and MAX_PAGE_SIZE
+     */
+    static bool IsValidPageSize(size_t page_size);
+
+    /**
+     * @brief
+     * remove the db file and every file derived from it, i.e. segments, log partitions,
+     * free space map and compressed page store. database should be closed
+     * @param filename the file name of the database
+     */
+    static void RemoveFiles(const std::string &filename);
+
+    /**
+     * @brief
+     * number of page I/O completed through io_uring
+     */
+    size_t GetAsyncIOCount() const {
+        return async_io_count_.load();
+    }
+
+    /**
+     * @brief
+     * force the written pages and free space map to disk. it's expensive, so it should
+     * only be called at durability boundaries, e.g. checkpoint
+     */
+    void Sync();
+
+    /**
+     * @brief allocate a new page, pages deallocated before are reused first
      * 
      * @return page_id_t the id of allocated page
      */
@@ -63,11 +208,46 @@ public:
 
     /**
      * @brief 
-     * Deallocate a page on disk
+     * Deallocate a page on disk, it will be handed out by AllocatePage again.
+     * caller should make sure nobody is using it
      * @param page_id 
      */
     void DeallocatePage(page_id_t page_id);
 
+    /**
+     * @brief
+     * redo an allocation logged before, called by recovery manager
+     * @param page_id
+     * @param allocated whether page is allocated or deallocated
+     * @param lsn lsn of the log record
+     */
+    void RedoAllocation(page_id_t page_id, bool allocated, lsn_t lsn);
+
+    /**
+     * @brief
+     * changes of free space map will be logged through it, and free space map
+     * won't be written back before the log. set by log manager
+     * @param log_manager could be nullptr, then changes are not logged
+     */
+    void SetLogManager(LogManager *log_manager) {
+        std::lock_guard<std::mutex> guard(db_latch_);
+        log_manager_ = log_manager;
+    }
+
+    bool IsAllocated(page_id_t page_id) {
+        std::lock_guard<std::mutex> guard(db_latch_);
+        return free_space_map_.IsAllocated(page_id);
+    }
+
+    /**
+     * @brief
+     * number of deallocated pages waiting to be reused
+     */
+    size_t GetFreePageCount() {
+        std::lock_guard<std::mutex> guard(db_latch_);
+        return free_space_map_.GetFreeCount();
+    }
+
     inline int GetAllocateCount() {
         return allocate_count_;
     }
@@ -82,17 +262,36 @@ public:
      * @param log_data 
      * @param size 
      * @param offset 
+     * @param partition log partition to read from
      * @return return false means we are reaching the end
      */
-    bool ReadLog(char *log_data, int size, int offset);
+    bool ReadLog(char *log_data, int size, int offset, size_t partition = 0);
 
     /**
      * @brief 
      * Flush the log buffer into disk
      * @param log_data 
      * @param size 
+     * @param partition log partition to append to
+     */
+    void WriteLog(char *log_data, int size, size_t partition = 0);
+
+    /**
+     * @brief
+     * number of log partitions, i.e. max(LOG_PARTITION_NUM, partitions left on disk)
      */
-    void WriteLog(char *log_data, int size);
+    size_t GetLogPartitionNum() const {
+        return log_files_.size();
+    }
+
+    /**
+     * @brief
+     * discard the log of a partition after "size", it's used by recovery to drop the log
+     * beyond the durable point
+     * @param partition
+     * @param size
+     */
+    void TruncateLog(size_t partition, int size);
 
     std::string GetTimeConsumption() {
         std::stringstream os;
@@ -100,11 +299,36 @@ public:
         os << "DiskManagerTimeConsumption: "
            << "LogWrite: " << log_write_time_.count() << "ms, "
            << "LogRead: " << log_read_time_.count() << "ms, "
-           << "DataWrite: " << data_write_time_.count() << "ms, "
-           << "DataRead: " << data_read_time_.count() << "ms";
+           << "DataWrite: " << data_write_time_.load() << "ms, "
+           << "DataRead: " << data_read_time_.load() << "ms, "
+           << "DataSync: " << data_sync_time_.load() << "ms";
 
         return os.str();
     }
+
+    /**
+     * @brief
+     * whether pages are compressed on disk
+     */
+    bool IsCompressionEnabled() const {
+        return compressed_store_ != nullptr;
+    }
+
+    /**
+     * @brief
+     * bytes written divided by bytes of pages written, 1 if compression is disabled
+     */
+    double GetCompressionRatio() const {
+        return compressed_store_ == nullptr ? 1.0 : compressed_store_->GetCompressionRatio();
+    }
+
+    /**
+     * @brief
+     * compression ratio and CPU cost per page, empty if compression is disabled
+     */
+    std::string GetCompressionReport() const {
+        return compressed_store_ == nullptr ? std::string() : compressed_store_->GetCompressionReport();
+    }
     
 private:
     /**
@@ -115,17 +339,201 @@ private:
      */
     int GetFileSize(const std::string &filename);
 
+    /**
+     * @brief
+     * helper function to open segment files of db, the first one will be created if it doesn't exist
+     */
+    void OpenDBFile();
+
+    /**
+     * @brief
+     * open the file of a log partition, it will be created if it doesn't exist
+     * @param partition
+     */
+    void OpenLogFile(size_t partition);
+
+    std::string GetLogName(size_t partition) const {
+        return GetLogName(log_name_, partition);
+    }
+
+    static std::string GetLogName(const std::string &log_name, size_t partition) {
+        return partition == 0 ? log_name : log_name + "." + std::to_string(partition);
+    }
+
+    /**
+     * @brief
+     * name of a file derived from the db file, e.g. "test.db" and ".fsm" gives "test.fsm"
+     * @param filename the file name of the database
+     * @param extension
+     */
+    static std::string GetSidecarName(const std::string &filename, const std::string &extension);
+
+    /**
+     * @brief
+     * helper function to read the header of db file, or write it when db file is empty
+     * @param fd descriptor of the first segment
+     */
+    void LoadHeader(int fd);
+
+    /**
+     * @brief
+     * find where the page is stored
+     * @param page_id
+     * @param[out] segment segment number
+     * @param[out] offset offset in the segment
+     */
+    void GetPageLocation(page_id_t page_id, size_t *segment, off_t *offset) const;
+
+    /**
+     * @brief
+     * name of segment file. the first segment is the db file itself, the others are suffixed
+     * by segment number, e.g. test.db.1
+     * @param segment
+     */
+    std::string GetSegmentName(size_t segment) const;
+
+    /**
+     * @brief
+     * get descriptor of segment file, it's opened on first use
+     * @param segment
+     * @param create whether to create the segment (and those before it) if it doesn't exist
+     * @return int descriptor, -1 if segment doesn't exist
+     */
+    int GetSegmentFd(size_t segment, bool create);
+
+    /**
+     * @brief
+     * helper function to open the free space map and read it into memory.
+     * map is discarded when db file is empty, since it's left by a removed db file
+     */
+    void OpenFreeSpaceMap();
+
+    /**
+     * @brief
+     * preallocate an extent at the end of db file which covers the page. pages of the extent
+     * read as zero, so they could be handed out without being written. called with db_latch_ held
+     * @param page_id
+     * @return whether the extent is preallocated
+     */
+    bool ExtendFile(page_id_t page_id);
+
+    /**
+     * @brief
+     * remember that db file has grown to cover the page
+     */
+    void UpdateFileSize(page_id_t page_id);
+
+    /**
+     * @brief
+     * reap completions until the condition is satisfied. only one thread reaps at a time,
+     * others wait for it
+     * @param condition
+     */
+    void ReapUntil(const std::function<bool()> &condition);
+
+    /**
+     * @brief
+     * wait until kernel could take more submissions, called without sq_latch_ held
+     * @param completed number of completions seen before releasing sq_latch_
+     * @param in_kernel whether there are submitted requests not completed yet
+     */
+    void WaitSubmitRoom(size_t completed, bool in_kernel);
+
+    /**
+     * @brief
+     * handle a completion of io_uring, called by the reaper
+     * @param request
+     * @param res result of the request
+     */
+    void CompleteRequest(IOBatch::Request *request, int res);
+
+    /**
+     * @brief
+     * whether the buffer could be used by direct I/O as it is
+     */
+    bool IsAligned(const char *data) const {
+        return !direct_io_ || reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0;
+    }
+
 private:
+    /**
+     * @brief
+     * header of db file, it takes the first page of db file
+     */
+    struct DBFileHeader {
+        char magic_[8];
+        uint32_t version_;
+        uint32_t page_size_;
+    };
+
+    static constexpr char DB_FILE_MAGIC[8] = {'T', 'i', 'n', 'y', 'D', 'B', '\0', '\0'};
+    static constexpr uint32_t DB_FILE_VERSION = 1;
+
     // file name for db file
     std::string db_name_;
-    // file stream for db file
-    std::fstream db_file_;
+    // size of pages, read from header
+    size_t page_size_{PAGE_SIZE};
+    // number of pages taken by header, it's 0 for legacy db file created before header is introduced
+    size_t header_page_count_{HEADER_PAGE_COUNT};
+    // descriptors of segment files, -1 if it's not opened. data I/O is positional,
+    // thus buffer pool instances could issue it concurrently
+    std::unique_ptr<std::atomic<int>[]> segment_fds_;
+    // maximum number of segments to cover every page id
+    size_t segment_limit_;
+    // number of pages per segment
+    size_t segment_pages_;
+    // number of segment files, they are created in order
+    std::atomic<size_t> segment_count_{0};
+    // protects opening and creating segment files
+    std::mutex segment_latch_;
+    // whether segment files are opened with O_DIRECT
+    bool direct_io_{false};
+    // file name for free space map
+    std::string fsm_name_;
+    // file descriptor of free space map, it's written back in Sync only
+    int fsm_fd_{-1};
+    // protects page allocation, i.e. free space map and log manager
+    std::mutex db_latch_;
+    // serializes Sync, so that nobody returns before the map it dirtied is written
+    std::mutex sync_latch_;
+    // pages are stored through it when compression is enabled, nullptr otherwise
+    std::unique_ptr<CompressedPageStore> compressed_store_;
+    // in-memory copy of free space map
+    FreeSpaceMap free_space_map_;
+    // number of pages covered by segment files, including preallocated extents. reads beyond it
+    // are past the end of file
+    std::atomic<size_t> file_page_count_{0};
+    // pages in [extent_begin_, extent_end_) are preallocated by us and never handed out,
+    // thus they are known to be zero. protected by db_latch_
+    size_t extent_begin_{0};
+    size_t extent_end_{0};
+    // used to log changes of free space map, nullptr if logging is disabled
+    LogManager *log_manager_{nullptr};
+    // io_uring used to perform page I/O batches, nullptr when it's disabled or unavailable
+    std::unique_ptr<IOUring> ring_;
+    // protects submission queue of ring
+    std::mutex sq_latch_;
+    // protects completion queue of ring. threads wait on cq_cv_ while other is reaping
+    std::mutex cq_latch_;
+    std::condition_variable cq_cv_;
+    bool reaping_{false};
+    // requests submitted to ring and not reaped yet, bounded by size of completion queue
+    std::atomic<size_t> inflight_{0};
+    std::atomic<size_t> async_io_count_{0};
+    /**
+     * @brief
+     * file of a log partition. partition 0 is the log file itself, partition i is stored in <log file>.i
+     */
+    struct LogFile {
+        std::fstream file_;
+        // size of log file, log is only appended through us
+        std::atomic<int> size_{0};
+    };
+
     // file name for log file
     std::string log_name_;
-    // file stream for log file
-    std::fstream log_file_;
-    // id for next page
-    page_id_t next_page_id_;
+    // files of log partitions
+    std::vector<std::unique_ptr<LogFile>> log_files_;
     // record the previous buffer we used to enforce
     // swapping buffer
     char *buffer_used_;
@@ -136,11 +544,12 @@ private:
     int allocate_count_;
     int deallocate_count_;
 
-    // for analysis
+    // for analysis. data I/O is concurrent, so it's counted in milliseconds atomically
     std::chrono::milliseconds log_write_time_{0};
     std::chrono::milliseconds log_read_time_{0};
-    std::chrono::milliseconds data_write_time_{0};
-    std::chrono::milliseconds data_read_time_{0};
+    std::atomic<std::chrono::milliseconds::rep> data_write_time_{0};
+    std::atomic<std::chrono::milliseconds::rep> data_read_time_{0};
+    std::atomic<std::chrono::milliseconds::rep> data_sync_time_{0};
 
 };
 
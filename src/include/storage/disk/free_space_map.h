@@ -0,0 +1,125 @@
+/**
+ * @file free_space_map.h
+ * @author sheep
+ * @brief bitmap tracking which pages of db file are in use
+ * @version 0.1
+ * @date 2022-07-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef FREE_SPACE_MAP_H
+#define FREE_SPACE_MAP_H
+
+#include "common/config.h"
+#include "common/macros.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * bitmap of allocated pages, a set bit means the page is in use. bitmap is split into pages,
+ * so it could be written back page by page. every bitmap page remembers the lsn of the last
+ * change applied to it, which is used to enforce WAL and to skip redone changes.
+ * it's not thread-safe, disk manager protects it with it's latch
+ *
+ * Bitmap page format:
+ * ------------------
+ * | LSN | bits ... |
+ * ------------------
+ */
+class FreeSpaceMap {
+public:
+    static constexpr size_t HEADER_SIZE = sizeof(lsn_t);
+    // number of pages tracked by a single bitmap page
+    static constexpr size_t PAGES_PER_BITMAP_PAGE = (PAGE_SIZE - HEADER_SIZE) * 8;
+
+    FreeSpaceMap() = default;
+
+    DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+    /**
+     * @brief
+     * find the lowest page that isn't in use. it's not marked as allocated,
+     * caller should call SetAllocated after the change is logged
+     * @return page_id_t page id, could be beyond the end of file
+     */
+    page_id_t FindFreePage();
+
+    bool IsAllocated(page_id_t page_id) const;
+
+    /**
+     * @brief
+     * mark the page as allocated or free
+     * @param page_id
+     * @param allocated
+     * @param lsn lsn of the log record describing this change, INVALID_LSN if it's not logged
+     */
+    void SetAllocated(page_id_t page_id, bool allocated, lsn_t lsn);
+
+    /**
+     * @brief
+     * lsn of the bitmap page tracking this page
+     */
+    lsn_t GetLSN(page_id_t page_id) const;
+
+    /**
+     * @brief
+     * high water mark of allocation, pages below it have been handed out at least once
+     */
+    size_t GetPageCount() const {
+        return page_count_;
+    }
+
+    /**
+     * @brief
+     * number of pages below page count that could be reused
+     */
+    size_t GetFreeCount() const {
+        return page_count_ - allocated_count_;
+    }
+
+    /**
+     * @brief
+     * install a bitmap page read from disk
+     * @param index index of the bitmap page
+     * @param data content of the bitmap page
+     */
+    void LoadBitmapPage(size_t index, const char *data);
+
+    /**
+     * @brief
+     * copy the bitmap pages modified since last call, and mark them as clean
+     * @param[out] pages index and content of dirty bitmap pages
+     * @return lsn_t the largest lsn of them, log should be flushed up to it before
+     * the pages are written. INVALID_LSN if none of the changes is logged
+     */
+    lsn_t CollectDirtyPages(std::vector<std::pair<size_t, std::unique_ptr<char[]>>> *pages);
+
+private:
+    /**
+     * @brief
+     * make sure the bitmap page tracking this page exists
+     */
+    void Extend(page_id_t page_id);
+
+    // bitmap pages, each of them is PAGE_SIZE bytes
+    std::vector<std::unique_ptr<char[]>> bitmap_pages_;
+    // whether bitmap page is modified since last CollectDirtyPages
+    std::vector<bool> dirty_;
+    // pages below it are all allocated
+    size_t first_free_{0};
+    // high water mark of allocation
+    size_t page_count_{0};
+    // number of set bits
+    size_t allocated_count_{0};
+};
+
+}
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file io_uring.h
+ * @author sheep
+ * @brief minimal io_uring wrapper built on raw system calls
+ * @version 0.1
+ * @date 2022-06-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef IO_URING_H
+#define IO_URING_H
+
+#include "common/macros.h"
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * a single submission/completion queue pair. it only supports plain reads and writes,
+ * which is all we need for page I/O. it's not thread-safe: submission side and completion
+ * side should be serialized by caller respectively
+ */
+class IOUring {
+public:
+    /**
+     * @brief Construct a new IOUring object
+     * @param entries number of submission queue entries.
+     * kernel may not support io_uring, check IsValid before using it
+     */
+    explicit IOUring(unsigned entries);
+
+    ~IOUring();
+
+    DISALLOW_COPY_AND_MOVE(IOUring);
+
+    bool IsValid() const {
+        return ring_fd_ >= 0;
+    }
+
+    unsigned GetSQEntries() const {
+        return sq_entries_;
+    }
+
+    unsigned GetCQEntries() const {
+        return cq_entries_;
+    }
+
+    /**
+     * @brief
+     * queue a read, it won't be seen by kernel until Submit is called
+     * @return false when submission queue is full
+     */
+    bool PrepareRead(int fd, void *buf, unsigned len, uint64_t offset, uint64_t user_data) {
+        return Prepare(IORING_OP_READ, fd, buf, len, offset, user_data);
+    }
+
+    /**
+     * @brief
+     * queue a write, it won't be seen by kernel until Submit is called
+     * @return false when submission queue is full
+     */
+    bool PrepareWrite(int fd, const void *buf, unsigned len, uint64_t offset, uint64_t user_data) {
+        return Prepare(IORING_OP_WRITE, fd, const_cast<void *>(buf), len, offset, user_data);
+    }
+
+    /**
+     * @brief
+     * hand the prepared entries to kernel. it may take only part of them,
+     * the rest stay in the queue and are submitted by the next call
+     * @return int number of entries submitted, or -errno. -EAGAIN and -EBUSY mean
+     * kernel can't take more for now, caller should reap completions and retry
+     */
+    int Submit();
+
+    /**
+     * @brief
+     * number of entries prepared but not taken by kernel yet
+     */
+    unsigned GetPendingCount() const {
+        return to_submit_;
+    }
+
+    /**
+     * @brief
+     * block until there is at least one completion
+     * @return int 0 or -errno
+     */
+    int Wait();
+
+    /**
+     * @brief
+     * consume every available completion
+     * @param handler called with user data and result of the request
+     * @return size_t number of completions consumed
+     */
+    size_t Reap(const std::function<void(uint64_t, int)> &handler);
+
+private:
+    bool Prepare(uint8_t opcode, int fd, void *buf, unsigned len, uint64_t offset, uint64_t user_data);
+
+    int ring_fd_{-1};
+    unsigned sq_entries_{0};
+    unsigned cq_entries_{0};
+    // entries prepared but not submitted yet
+    unsigned to_submit_{0};
+
+    // mapped regions
+    void *sq_ring_{nullptr};
+    size_t sq_ring_size_{0};
+    void *cq_ring_{nullptr};
+    size_t cq_ring_size_{0};
+    io_uring_sqe *sqes_{nullptr};
+    size_t sqes_size_{0};
+
+    // pointers into submission queue
+    unsigned *sq_head_{nullptr};
+    unsigned *sq_tail_{nullptr};
+    unsigned *sq_mask_{nullptr};
+    unsigned *sq_array_{nullptr};
+    // pointers into completion queue
+    unsigned *cq_head_{nullptr};
+    unsigned *cq_tail_{nullptr};
+    unsigned *cq_mask_{nullptr};
+    io_uring_cqe *cqes_{nullptr};
+};
+
+}
+
+#endif
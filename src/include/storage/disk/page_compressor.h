@@ -0,0 +1,66 @@
+/**
+ * @file page_compressor.h
+ * @author sheep
+ * @brief self-contained LZ77 codec for pages
+ * @version 0.1
+ * @date 2022-07-04
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef PAGE_COMPRESSOR_H
+#define PAGE_COMPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace TinyDB {
+
+/**
+ * @brief
+ * LZ77 codec in the spirit of LZ4 block format. it favors speed over ratio,
+ * since it runs on every page writeback and fetch.
+ *
+ * Compressed data is a sequence of:
+ * -----------------------------------------------------------------------------------
+ * | token | literal length... | literals | offset (2 bytes) | match length... |
+ * -----------------------------------------------------------------------------------
+ * high 4 bits of token is the literal length, low 4 bits is the match length minus MIN_MATCH.
+ * value 15 means the length continues in the following bytes, each of them is added
+ * until one is less than 255. the last sequence only has literals
+ */
+class PageCompressor {
+public:
+    static constexpr size_t MIN_MATCH = 4;
+
+    /**
+     * @brief
+     * compress src into dst
+     * @param src
+     * @param src_size
+     * @param dst
+     * @param dst_capacity
+     * @return size_t size of compressed data, 0 if it doesn't fit in dst
+     */
+    static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+    /**
+     * @brief
+     * decompress src into dst
+     * @param src
+     * @param src_size
+     * @param dst
+     * @param dst_size expected size of decompressed data
+     * @return false if data is corrupted
+     */
+    static bool Decompress(const char *src, size_t src_size, char *dst, size_t dst_size);
+
+private:
+    static constexpr size_t HASH_BITS = 12;
+    static constexpr size_t MAX_OFFSET = 65535;
+};
+
+}
+
+#endif
@@ -94,8 +94,12 @@ class BPlusTree {
     friend class BPlusTreeIterator<KeyType, ValueType, KeyComparator>;
 
 public:
+    /**
+     * @brief Construct a new BPlusTree object
+     * max sizes of nodes are decided by the page size of buffer pool when they are 0
+     */
     explicit BPlusTree(std::string index_name, BufferPoolManager *buffer_pool_manager, KeyComparator comparator,
-                        uint32_t leaf_max_size = LeafPage::LEAF_PAGE_SIZE, uint32_t internal_max_size = InternalPage::INTERNAL_PAGE_SIZE);
+                        uint32_t leaf_max_size = 0, uint32_t internal_max_size = 0);
     
     /**
      * @brief 
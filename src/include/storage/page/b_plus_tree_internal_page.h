@@ -157,6 +157,11 @@ public:
 
     static constexpr uint32_t INTERNAL_PAGE_SIZE = (PAGE_SIZE - BPLUSTREE_HEADER_SIZE) / sizeof(MappingType);
 
+    // max size of internal node that fits in a page of page_size
+    static constexpr uint32_t MaxSizeOf(size_t page_size) {
+        return (page_size - BPLUSTREE_HEADER_SIZE) / sizeof(MappingType);
+    }
+
     void PrintAsBigint() {
         LOG_DEBUG("pageid: %d parent: %d size: %d", GetPageId(), GetParentPageId(), GetSize());
         for (int i = 0; i < GetSize(); i++) {
@@ -150,6 +150,11 @@ public:
     static constexpr uint32_t LEAF_PAGE_HEADER_SIZE = BPLUSTREE_HEADER_SIZE + sizeof(page_id_t);
     static constexpr uint32_t LEAF_PAGE_SIZE = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType);
 
+    // max size of leaf node that fits in a page of page_size
+    static constexpr uint32_t MaxSizeOf(size_t page_size) {
+        return (page_size - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType);
+    }
+
     // for debug purpose
     void PrintAsBigint() {
         LOG_DEBUG("pageid: %d parent: %d size: %d", GetPageId(), GetParentPageId(), GetSize());
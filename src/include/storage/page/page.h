@@ -15,6 +15,7 @@
 
 #include <cstring>
 #include <assert.h>
+#include <atomic>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -26,12 +27,14 @@ namespace TinyDB {
  * in memory representation of a single page,
  * we stored 8 byte metadata in the header,
  * first 4 byte is page id,
- * second 4 byte is lsn. i.e. last sequence number, used for crash recovery
+ * second 4 byte is lsn. i.e. last sequence number, used for crash recovery.
+ * Page is only the descriptor of a frame, data is stored in the frame arena of buffer pool.
+ * it's aligned to cache line, so that pinning different frames won't cause false sharing
  */
-class Page {
-    friend class BufferPoolManager;
+class alignas(64) Page {
+    friend class BufferPoolInstance;
 public:
-    Page() { ZeroData(); }
+    Page() = default;
     ~Page() = default;
 
     /**
@@ -47,7 +50,7 @@ public:
      * @return page_id_t 
      */
     inline page_id_t GetPageId() {
-        return page_id_;
+        return page_id_.load(std::memory_order_acquire);
     }
 
     /**
@@ -55,7 +58,7 @@ public:
      * @return int
      */
     inline int GetPinCount() {
-        return pin_count_;
+        return pin_count_.load(std::memory_order_acquire);
     }
 
     /**
@@ -65,7 +68,7 @@ public:
      * @return bool
      */
     inline bool IsDirty() {
-        return is_dirty_;
+        return is_dirty_.load(std::memory_order_acquire);
     }
 
     inline void WLatch() {
@@ -94,22 +97,25 @@ public:
 
 private:
     // zero out the data
-    inline void ZeroData() {
-        memset(data_, 0, PAGE_SIZE);
+    inline void ZeroData(size_t page_size) {
+        memset(data_, 0, page_size);
     }
 
-    // the actual data stored in a page
-    // normally, we will reinterpret this data
-    char data_[PAGE_SIZE]{};
-    // the unique identifier of this page
-    page_id_t page_id_{INVALID_PAGE_ID};
-    // pin count of this page, used in buffer pool manager
-    int pin_count_{0};
+    // the unique identifier of this page.
+    // it's atomic since buffer pool will validate it without holding latch
+    std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+    // pin count of this page, used in buffer pool manager.
+    // negative value means the frame is owned exclusively by buffer pool,
+    // i.e. it's free or being evicted, and nobody could pin it.
+    std::atomic<int> pin_count_{0};
     // whether we have modified this page after
     // we bring it from disk to memory
     // if it's true, then we need to flush the data to disk
     // before eviciting this page
-    bool is_dirty_{false};
+    std::atomic<bool> is_dirty_{false};
+    // the actual data stored in a page, pointing into the frame arena.
+    // normally, we will reinterpret this data
+    char *data_{nullptr};
     // page latch. used to protect the content
     ReaderWriterLatch rwlatch_;
 };
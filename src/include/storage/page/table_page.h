@@ -50,8 +50,8 @@ static constexpr uint32_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
 
 /**
  * @brief 
- * TablePage is the page that stores the real data. And since it's inherited from
- * page, we can use TablePage directly by using reinterpret_cast.
+ * TablePage is the page that stores the real data. We can use TablePage directly
+ * by reinterpret_cast the data of a page.
  * TablePage provided the interface that will store tuple in page. So you can regard this
  * class as a set of manipulating functions that is related to tuple storage.
  * Again, the key idea here is to provide a set of functions that can help us to store tuple in page.
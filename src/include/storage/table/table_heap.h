@@ -20,6 +20,8 @@
 #include "recovery/log_manager.h"
 #include "concurrency/transaction_context.h"
 
+#include <atomic>
+
 namespace TinyDB {
 
 /**
@@ -55,14 +57,16 @@ public:
      */
     TableHeap(BufferPoolManager *buffer_pool_manager, TransactionContext *txn = nullptr, LogManager *log_manager = nullptr) {
         page_id_t first_page_id = INVALID_PAGE_ID;
-        auto new_page = reinterpret_cast<TablePage *> (buffer_pool_manager->NewPage(&first_page_id));
-        TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(new_page != nullptr, "");
+        auto page = buffer_pool_manager->NewPage(&first_page_id);
+        TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
+        auto new_page = reinterpret_cast<TablePage *> (page->GetData());
 
-        new_page->Init(first_page_id, PAGE_SIZE, INVALID_PAGE_ID, txn, log_manager);
+        new_page->Init(first_page_id, buffer_pool_manager->GetPageSize(), INVALID_PAGE_ID, txn, log_manager);
         buffer_pool_manager->UnpinPage(first_page_id, true);
         buffer_pool_manager_ = buffer_pool_manager;
         log_manager_ = log_manager;
         first_page_id_ = first_page_id;
+        page_count_ = 1;
 
         if (log_manager != nullptr) {
             LOG_INFO("Initialize TableHeap with Logging Enabled");
@@ -81,13 +85,16 @@ public:
      */
     static TableHeap *CreateNewTableHeap(BufferPoolManager *buffer_pool_manager, TransactionContext *txn = nullptr, LogManager *log_manager = nullptr) {
         page_id_t first_page_id = INVALID_PAGE_ID;
-        auto new_page = reinterpret_cast<TablePage *> (buffer_pool_manager->NewPage(&first_page_id));
-        TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(new_page != nullptr, "");
+        auto page = buffer_pool_manager->NewPage(&first_page_id);
+        TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
+        auto new_page = reinterpret_cast<TablePage *> (page->GetData());
         
-        new_page->Init(first_page_id, PAGE_SIZE, INVALID_PAGE_ID, txn, log_manager);
+        new_page->Init(first_page_id, buffer_pool_manager->GetPageSize(), INVALID_PAGE_ID, txn, log_manager);
         buffer_pool_manager->UnpinPage(first_page_id, true);
 
-        return new TableHeap(first_page_id, buffer_pool_manager, log_manager);
+        auto table_heap = new TableHeap(first_page_id, buffer_pool_manager, log_manager);
+        table_heap->page_count_ = 1;
+        return table_heap;
     }
 
     /**
@@ -154,12 +161,24 @@ public:
         return first_page_id_;
     }
 
+    /**
+     * @brief
+     * number of pages in this table heap, counted since it's created.
+     * we don't walk the page chain when opening an existing table heap,
+     * so 0 means it's unknown
+     */
+    inline size_t GetPageCount() const {
+        return page_count_;
+    }
+
     /**
      * @brief 
      * get the begin iterator of this table
+     * @param strategy access strategy used by the iterator. scanning the whole table
+     * should use a bulk read strategy, so that it won't pollute the buffer pool
      * @return TableIterator 
      */
-    TableIterator Begin();
+    TableIterator Begin(std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
     
     /**
      * @brief 
@@ -169,9 +188,19 @@ public:
     TableIterator End();
 
 private:
+    /**
+     * @brief
+     * read ahead pages following the given one, called when iterator steps onto a new page
+     * @param table_page page iterator just stepped onto, we are holding it's read latch
+     * @param strategy access strategy of the iterator
+     */
+    void ReadAhead(TablePage *table_page, const std::shared_ptr<BufferAccessStrategy> &strategy);
+
     BufferPoolManager *buffer_pool_manager_;
     LogManager *log_manager_{nullptr};
     page_id_t first_page_id_{INVALID_PAGE_ID};
+    // number of pages, 0 if unknown
+    std::atomic<size_t> page_count_{0};
 };
 
 }
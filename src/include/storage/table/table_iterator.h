@@ -36,28 +36,33 @@ public:
     TableIterator()
         : table_heap_(nullptr),
           rid_(RID()),
-          tuple_(Tuple()) {}
+          tuple_(Tuple()),
+          strategy_(nullptr) {}
 
     /**
      * @brief
      * Initialize table iterator based on table heap
      * @param table_heap 
      * @param rid 
+     * @param strategy access strategy used when advancing the iterator, could be nullptr
      */
-    TableIterator(TableHeap *table_heap, RID rid)
+    TableIterator(TableHeap *table_heap, RID rid, std::shared_ptr<BufferAccessStrategy> strategy = nullptr)
         : table_heap_(table_heap),
           rid_(rid),
-          tuple_(Tuple()) {}
+          tuple_(Tuple()),
+          strategy_(std::move(strategy)) {}
 
     TableIterator(const TableIterator &other)
         : table_heap_(other.table_heap_),
           rid_(other.rid_),
-          tuple_(other.tuple_) {}
+          tuple_(other.tuple_),
+          strategy_(other.strategy_) {}
 
     inline void Swap(TableIterator &iter) {
         std::swap(iter.rid_, rid_);
         std::swap(iter.table_heap_, table_heap_);
         std::swap(iter.tuple_, tuple_);
+        std::swap(iter.strategy_, strategy_);
     }
 
     inline bool operator==(const TableIterator &iter) const {
@@ -80,6 +85,7 @@ public:
         table_heap_ = other.table_heap_;
         rid_ = other.rid_;
         tuple_ = other.tuple_;
+        strategy_ = other.strategy_;
         return *this;
     }
 
@@ -116,6 +122,8 @@ private:
     TableHeap *table_heap_;
     RID rid_;
     Tuple tuple_;
+    // shared with the read-ahead requests issued by iterator
+    std::shared_ptr<BufferAccessStrategy> strategy_;
 };
 
 }
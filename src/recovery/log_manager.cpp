@@ -10,62 +10,187 @@
  */
 
 #include "recovery/log_manager.h"
+#include "recovery/log_reader.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
 
 namespace TinyDB {
 
 
 lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
-    std::unique_lock<std::mutex> latch(latch_);
-    while (log_record.GetSize() + log_size_ > LOG_BUFFER_SIZE) {
-        // wakeup flush thread
-        flush_cv_.notify_one();
-        // wait until we have some space to insert the log
-        // operation_cv_.wait(latch, [&]() { return log_record.GetSize() + log_size_ <= LOG_BUFFER_SIZE; });
-        // since i want to keep waking up flush thread, so i choose to mimic "wait" logic and notify flush thread
-        // every time we wakeup
-        operation_cv_.wait(latch);
+    uint32_t size = log_record.GetSize();
+    TINYDB_ASSERT(size <= LOG_BUFFER_SIZE, "log record is too large");
+    auto &partition = GetPartition();
+    lsn_t lsn;
+    uint32_t begin;
+    if (partitions_.size() == 1) {
+        // reserve lsn and space at once, so that lsn order is the same as the order in log file
+        uint64_t state = partition.reserve_state_.fetch_add((static_cast<uint64_t>(size) << 32) + 1);
+        lsn = GetLSN(state);
+        begin = GetPosition(state);
+    } else {
+        // lsn is global, take it together with the space so that partition is ordered by lsn
+        std::lock_guard<std::mutex> guard(partition.reserve_latch_);
+        lsn = next_lsn_.fetch_add(1);
+        begin = GetPosition(partition.reserve_state_.load());
+        partition.reserve_state_.store(Pack(begin + size, lsn + 1));
     }
+    uint32_t end = begin + size;
+    WaitForSpace(partition, end);
 
     auto t1 = std::chrono::steady_clock::now();
-    // fetch new lsn
-    lsn_t lsn = next_lsn_++;
+    // serialize the record into the reserved slot directly
     log_record.SetLSN(lsn);
-    log_record.SerializeTo(log_buffer_ + log_size_);
-    log_size_ += log_record.GetSize();
+    size_t offset = begin % RING_SIZE;
+    log_record.SerializeTo(partition.buffer_ + offset);
+    if (offset + size > RING_SIZE) {
+        // the overflowed part belongs to the head of ring
+        memcpy(partition.buffer_, partition.buffer_ + RING_SIZE, offset + size - RING_SIZE);
+    }
+
+    // publish it after the records reserved before us
+    for (int spin = 0; GetPosition(partition.filled_state_.load(std::memory_order_acquire)) != begin; spin++) {
+        if (spin >= 64) {
+            std::this_thread::yield();
+        }
+    }
+    partition.filled_state_.store(Pack(end, lsn + 1), std::memory_order_release);
 
     auto t2 = std::chrono::steady_clock::now();
-    auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
-    operation_time_ += interval;
+    operation_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
 
     // LOG_INFO("Appending Log %s", log_record.ToString().c_str());
 
     return lsn;
 }
 
+void LogManager::RestoreLogTail() {
+    // every partition is ordered by lsn, merge them to find the end of log
+    std::vector<LogReader> readers;
+    // (lsn, partition) of next record of every partition
+    std::priority_queue<std::pair<lsn_t, size_t>, std::vector<std::pair<lsn_t, size_t>>, std::greater<>> heads;
+    for (size_t i = 0; i < partitions_.size(); i++) {
+        readers.emplace_back(disk_manager_, i);
+        if (readers[i].Peek() != 0) {
+            heads.emplace(readers[i].GetLSN(), i);
+        }
+    }
+
+    lsn_t last_lsn = INVALID_LSN;
+    while (!heads.empty()) {
+        auto [lsn, partition] = heads.top();
+        // lsn is dense. a hole could only be left by partitions persisted at different pace, nobody
+        // has been told the log after it is durable. cut it, so that new log won't follow it
+        if (partitions_.size() > 1 && last_lsn != INVALID_LSN && lsn != last_lsn + 1) {
+            LOG_INFO("log after lsn %d is not persisted, discarding it", last_lsn);
+            for (auto &reader : readers) {
+                reader.Peek();
+                disk_manager_->TruncateLog(reader.GetPartition(), reader.GetOffset());
+            }
+            break;
+        }
+        heads.pop();
+        auto &reader = readers[partition];
+        reader.Next(reader.Peek());
+        if (reader.Peek() != 0) {
+            heads.emplace(reader.GetLSN(), partition);
+        }
+        last_lsn = lsn;
+    }
+
+    SetNextLsn(last_lsn + 1);
+    persistent_lsn_.store(last_lsn);
+}
+
+LogManager::LogPartition &LogManager::GetPartition() {
+    static std::atomic<size_t> thread_count{0};
+    static thread_local size_t thread_index = thread_count.fetch_add(1);
+    return *partitions_[thread_index % partitions_.size()];
+}
+
+void LogManager::WaitForSpace(LogPartition &partition, uint32_t end) {
+    if (end - partition.flushed_position_.load() <= RING_SIZE) {
+        return;
+    }
+    std::unique_lock<std::mutex> latch(latch_);
+    while (end - partition.flushed_position_.load() > RING_SIZE) {
+        // wakeup flush thread
+        flush_requested_ = true;
+        flush_cv_.notify_one();
+        // since i want to keep waking up flush thread, so i choose to mimic "wait" logic and notify flush thread
+        // every time we wakeup
+        operation_cv_.wait(latch);
+    }
+}
+
 void LogManager::FlushThread() {
     while (enable_flushing_.load()) {
-        std::unique_lock<std::mutex> latch(latch_);
-        // wait until log timeout or buffer is full or forcing log is needed
-        flush_cv_.wait_for(latch, LOG_TIMEOUT);
-        // swap buffer
-        SwapBuffer();
-        // remember the biggest lsn in buffer
-        lsn_t lsn = next_lsn_ - 1;
-        // save the buffer pointer and buffer size
-        uint32_t flush_size = flush_size_;
-        char *flush_buffer = flush_buffer_;
-        // unlock the latch since we don't want to flush the disk while holding the lock
-        latch.unlock();
-        // resume the append log record operation 
-        operation_cv_.notify_all();
-        // start flushing log
-        disk_manager_->WriteLog(flush_buffer, flush_size);
-        // store persistent_lsn
-        persistent_lsn_.store(lsn);
-        // i think we should use lsn to determine it
-        // a good way to handle this would be to register future/promise into a map
-        // currently, i chose to use busy waiting
+        {
+            std::unique_lock<std::mutex> latch(latch_);
+            // wait until log timeout or buffer is full or forcing log is needed
+            flush_cv_.wait_for(latch, LOG_TIMEOUT, [&]() { return flush_requested_; });
+            flush_requested_ = false;
+        }
+        // committers arriving meanwhile are batched into the next write
+        size_t flushed_count = flush_count_.load();
+        lsn_t persistent_lsn = std::numeric_limits<lsn_t>::max();
+        for (size_t i = 0; i < partitions_.size(); i++) {
+            persistent_lsn = std::min(persistent_lsn, FlushPartition(*partitions_[i], i));
+        }
+        if (flush_count_.load() != flushed_count) {
+            // resume the appenders waiting for space. taking latch makes sure
+            // they are either sleeping or going to see the new position
+            { std::lock_guard<std::mutex> guard(latch_); }
+            operation_cv_.notify_all();
+        }
+        // bound of a partition drops once it has log in memory again, but what has been persisted stays persisted
+        NotifyWaiters(std::max(persistent_lsn, persistent_lsn_.load()));
+    }
+}
+
+lsn_t LogManager::FlushPartition(LogPartition &partition, size_t index) {
+    // log before the watermark is complete, and nobody will modify it until we release it
+    uint64_t state = partition.filled_state_.load(std::memory_order_acquire);
+    uint32_t begin = partition.flushed_position_.load();
+    uint32_t end = GetPosition(state);
+    if (begin != end) {
+        size_t offset = begin % RING_SIZE;
+        size_t size = end - begin;
+        size_t head = std::min<size_t>(size, RING_SIZE - offset);
+        disk_manager_->WriteLog(partition.buffer_ + offset, head, index);
+        if (head < size) {
+            disk_manager_->WriteLog(partition.buffer_, size - head, index);
+        }
+        flush_count_++;
+        partition.flushed_position_.store(end);
+    }
+    if (partitions_.size() == 1) {
+        return GetLSN(state) - 1;
+    }
+    // a partition with nothing in memory holds back nobody. since lsn is taken under the latch,
+    // log reserved here later will be greater than any lsn handed out so far
+    std::lock_guard<std::mutex> guard(partition.reserve_latch_);
+    if (GetPosition(partition.reserve_state_.load()) == end) {
+        return next_lsn_.load() - 1;
+    }
+    return GetLSN(state) - 1;
+}
+
+void LogManager::NotifyWaiters(lsn_t lsn) {
+    std::lock_guard<std::mutex> guard(waiter_latch_);
+    // store persistent_lsn under the latch, so that waiters won't miss it
+    persistent_lsn_.store(lsn);
+    auto end = waiters_.upper_bound(lsn);
+    for (auto it = waiters_.begin(); it != end; ++it) {
+        it->second->done_ = true;
+        it->second->cv_.notify_one();
     }
+    waiters_.erase(waiters_.begin(), end);
 }
 
 void LogManager::RunFlushThread() {
@@ -80,25 +205,40 @@ void LogManager::StopFlushThread() {
 }
 
 void LogManager::Flush(lsn_t lsn, bool force) {
+    if (persistent_lsn_.load() >= lsn) {
+        return;
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
     if (force) {
         // notify flush thread to start flushing the log
+        {
+            std::lock_guard<std::mutex> guard(latch_);
+            flush_requested_ = true;
+        }
         flush_cv_.notify_one();
     }
-    // busy waiting
-    // sheep: a way to optimize busy waiting is to wait for sometime to prevent burning cpu while doing nothing,
-    // we can use some exponential stragety. e.g. wait for 1 time unit, 2 time unit, 4 time unit ...
-    while (persistent_lsn_.load() < lsn) {}
-    // sheep: a better way is to use something like concurrent map<lsn, future>
-    // then as long as flushing thread has updated persistent_lsn, we can simply notify all 
-    // blocking thread that has lsn smaller than persistent_lsn
-}
 
-void LogManager::SwapBuffer() {
-    // we are in the critical section, it's safe to exchange these two variable
-    std::swap(log_buffer_, flush_buffer_);
-    flush_size_ = log_size_;
-    // clear log size
-    log_size_ = 0;
+    if (!LOG_GROUP_COMMIT) {
+        // the old busy waiting, every committer burns cpu until it's log is persisted
+        while (persistent_lsn_.load() < lsn) {}
+        flush_latency_.Record(std::chrono::steady_clock::now() - t1);
+        return;
+    }
+
+    // sleep until flush thread wakes us up. only waiters whose lsn is persisted are woken up,
+    // so a flush won't cause thundering herd
+    FlushWaiter waiter;
+    {
+        std::unique_lock<std::mutex> guard(waiter_latch_);
+        if (persistent_lsn_.load() < lsn) {
+            waiters_.emplace(lsn, &waiter);
+            waiter.cv_.wait(guard, [&]() { return waiter.done_; });
+        }
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    flush_latency_.Record(t2 - t1);
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**
+ * @file log_reader.cpp
+ * @author sheep
+ * @brief sequential reader of a log partition
+ * @version 0.1
+ * @date 2022-07-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "recovery/log_reader.h"
+
+#include <cstring>
+
+namespace TinyDB {
+
+LogReader::LogReader(DiskManager *disk_manager, size_t partition)
+    : disk_manager_(disk_manager), partition_(partition), buffer_(new char[LOG_BUFFER_SIZE]) {
+    if (!disk_manager_->ReadLog(buffer_.get(), LOG_BUFFER_SIZE, 0, partition_)) {
+        memset(buffer_.get(), 0, LOG_BUFFER_SIZE);
+    }
+}
+
+uint32_t LogReader::Peek() {
+    while (true) {
+        // records may fill the buffer exactly
+        if (inner_offset_ + sizeof(uint32_t) <= LOG_BUFFER_SIZE) {
+            // first probe the size
+            uint32_t size = *reinterpret_cast<const uint32_t *>(buffer_.get() + inner_offset_);
+            if (size != 0 && size + inner_offset_ <= LOG_BUFFER_SIZE) {
+                return size;
+            }
+        }
+        // size = 0 at the beginning of buffer means there is no more log records
+        if (inner_offset_ == 0) {
+            return 0;
+        }
+        offset_ += inner_offset_;
+        inner_offset_ = 0;
+        if (!disk_manager_->ReadLog(buffer_.get(), LOG_BUFFER_SIZE, offset_, partition_)) {
+            memset(buffer_.get(), 0, LOG_BUFFER_SIZE);
+            return 0;
+        }
+    }
+}
+
+lsn_t LogReader::GetLSN() const {
+    // lsn follows size in header
+    lsn_t lsn;
+    memcpy(&lsn, buffer_.get() + inner_offset_ + sizeof(uint32_t), sizeof(lsn_t));
+    return lsn;
+}
+
+}
@@ -15,7 +15,11 @@
 #include "common/exception.h"
 #include "storage/page/table_page.h"
 
+#include <cstring>
+#include <functional>
+#include <queue>
 #include <set>
+#include <vector>
 
 namespace TinyDB {
 
@@ -23,6 +27,20 @@ void RecoveryManager::ARIES() {
     Scan();
     Redo();
     Undo();
+    // pages recovered through our own pool may be owned by another pool which reads them
+    // from disk, so write them out before anyone else fetches them
+    if (!buffer_pools_.empty()) {
+        buffer_pool_manager_->FlushAllPages();
+    }
+}
+
+BufferPoolManager *RecoveryManager::GetBufferPool(page_id_t page_id) {
+    for (auto bpm : buffer_pools_) {
+        if (bpm->IsResident(page_id)) {
+            return bpm;
+        }
+    }
+    return buffer_pool_manager_;
 }
 
 void RecoveryManager::Scan() {
@@ -31,36 +49,52 @@ void RecoveryManager::Scan() {
 
 void RecoveryManager::Redo() {
     // currently, we only support recovery from empty database, so there is no dirty page
-    int offset = 0;
-    int max_lsn = INVALID_LSN;
-    while (disk_manager_->ReadLog(buffer_, LOG_BUFFER_SIZE, offset)) {
-        int inner_offset = 0;
-        while (true) {
-            // first probe the size
-            uint32_t size = *reinterpret_cast<const uint32_t *>(buffer_ + inner_offset);
-            // size = 0 means there is no more log records
-            // we shall stop when buffer is empty or there is no more log records
-            if (size == 0 || size + inner_offset > LOG_BUFFER_SIZE) {
-                break;
-            }
-            auto log = LogRecord::DeserializeFrom(buffer_ + inner_offset);
-            // update max lsn
-            max_lsn = std::max(max_lsn, log.GetLSN());
-            // remember the necessary information to retrieve log based on lsn
-            lsn_mapping_[log.GetLSN()] = std::make_pair(offset + inner_offset, size);
-            // LOG_INFO("redo log %s", log.ToString().c_str());
-            // redo the log if necessary
-            RedoLog(log);
-
-            inner_offset += size;
+    // every partition is ordered by lsn, merge them to redo log in the global order.
+    // log manager has already cut the log that is not persisted as a whole
+    size_t partition_num = disk_manager_->GetLogPartitionNum();
+    std::vector<LogReader> readers;
+    // (lsn, partition) of next record of every partition
+    std::priority_queue<std::pair<lsn_t, size_t>, std::vector<std::pair<lsn_t, size_t>>, std::greater<>> heads;
+    for (size_t i = 0; i < partition_num; i++) {
+        readers.emplace_back(disk_manager_, i);
+        if (readers[i].Peek() != 0) {
+            heads.emplace(readers[i].GetLSN(), i);
+        }
+    }
+
+    while (!heads.empty()) {
+        auto partition = heads.top().second;
+        heads.pop();
+        auto &reader = readers[partition];
+        RedoNext(reader);
+        if (reader.Peek() != 0) {
+            heads.emplace(reader.GetLSN(), partition);
         }
-        offset += inner_offset;
     }
-    log_manager_->SetNextLsn(max_lsn + 1);
+}
+
+void RecoveryManager::RedoNext(LogReader &reader) {
+    uint32_t size = reader.Peek();
+    auto log = LogRecord::DeserializeFrom(reader.GetData());
+    // remember the necessary information to retrieve log based on lsn
+    lsn_mapping_[log.GetLSN()] = LogLocation{reader.GetPartition(), reader.GetOffset(), static_cast<int>(size)};
+    // LOG_INFO("redo log %s", log.ToString().c_str());
+    // redo the log if necessary
+    RedoLog(log);
+
+    reader.Next(size);
 }
 
 // should we inline this method inside LogRecord?
 void RecoveryManager::RedoLog(LogRecord &log_record) {
+    // allocation doesn't belong to any txn, and it's never undone
+    if (log_record.type_ == LogRecordType::ALLOCATEPAGE || log_record.type_ == LogRecordType::DEALLOCATEPAGE) {
+        disk_manager_->RedoAllocation(log_record.cur_page_id_, 
+                                      log_record.type_ == LogRecordType::ALLOCATEPAGE, 
+                                      log_record.GetLSN());
+        return;
+    }
+
     // record last lsn
     active_txn_[log_record.GetTxnId()] = log_record.GetLSN();
 
@@ -73,13 +107,14 @@ void RecoveryManager::RedoLog(LogRecord &log_record) {
         active_txn_[log_record.GetTxnId()] = log_record.GetLSN();
         break;
     case LogRecordType::INSERT: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
         // if this log has been persisted on disk, then we don't need to redo it
         if (table_page->GetLSN() >= log_record.GetLSN()) {
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+            bpm->UnpinPage(page->GetPageId(), false);
             break;
         }
 
@@ -91,17 +126,18 @@ void RecoveryManager::RedoLog(LogRecord &log_record) {
         TINYDB_ASSERT(rid == log_record.GetRID(), "Logic Error");
         // update in-memory lsn
         table_page->SetLSN(log_record.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         break;
     }
     case LogRecordType::MARKDELETE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
         // if this log has been persisted on disk, then we don't need to redo it
         if (table_page->GetLSN() >= log_record.GetLSN()) {
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+            bpm->UnpinPage(page->GetPageId(), false);
             break;
         }
         if (!table_page->MarkDelete(log_record.GetRID())) {
@@ -109,49 +145,52 @@ void RecoveryManager::RedoLog(LogRecord &log_record) {
         }
         // update lsn
         table_page->SetLSN(log_record.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         break;
     }
     case LogRecordType::APPLYDELETE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
         // if this log has been persisted on disk, then we don't need to redo it
         if (table_page->GetLSN() >= log_record.GetLSN()) {
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+            bpm->UnpinPage(page->GetPageId(), false);
             break;
         }
         table_page->ApplyDelete(log_record.GetRID());
         // update lsn
         table_page->SetLSN(log_record.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         break;
     }
     case LogRecordType::ROLLBACKDELETE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
         // if this log has been persisted on disk, then we don't need to redo it
         if (table_page->GetLSN() >= log_record.GetLSN()) {
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+            bpm->UnpinPage(page->GetPageId(), false);
             break;
         }
         table_page->RollbackDelete(log_record.GetRID());
         // update lsn
         table_page->SetLSN(log_record.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         break;
     }
     case LogRecordType::UPDATE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
         // if this log has been persisted on disk, then we don't need to redo it
         if (table_page->GetLSN() >= log_record.GetLSN()) {
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+            bpm->UnpinPage(page->GetPageId(), false);
             break;
         }
 
@@ -162,33 +201,35 @@ void RecoveryManager::RedoLog(LogRecord &log_record) {
 
         // update lsn
         table_page->SetLSN(log_record.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         break;
     }
     case LogRecordType::INITPAGE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.cur_page_id_, false);
+        auto bpm = GetBufferPool(log_record.cur_page_id_);
+        auto page = bpm->FetchPage(log_record.cur_page_id_, false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
         // if this log has been persisted on disk, then we don't need to redo it
         if (table_page->GetLSN() >= log_record.GetLSN()) {
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+            bpm->UnpinPage(page->GetPageId(), false);
             break;
         }
 
-        table_page->Init(page->GetPageId(), PAGE_SIZE, log_record.prev_page_id_);
+        table_page->Init(page->GetPageId(), buffer_pool_manager_->GetPageSize(), log_record.prev_page_id_);
         // if current page is not the first page, then we reset the link
         if (log_record.prev_page_id_ != INVALID_PAGE_ID) {
-            auto prev_page = buffer_pool_manager_->FetchPage(log_record.prev_page_id_, false);
+            auto prev_bpm = GetBufferPool(log_record.prev_page_id_);
+            auto prev_page = prev_bpm->FetchPage(log_record.prev_page_id_, false);
             TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(prev_page != nullptr, "");
             auto prev_table_page = reinterpret_cast<TablePage *> (prev_page->GetData());
             // overwrite next page id to make sure the link is set
             prev_table_page->SetNextPageId(page->GetPageId());
-            buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+            prev_bpm->UnpinPage(prev_page->GetPageId(), true);
         }
 
         table_page->SetLSN(log_record.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         break;
     }
     default:
@@ -210,8 +251,8 @@ void RecoveryManager::Undo() {
     while (!next_lsn.empty()) {
         auto lsn = *next_lsn.rbegin();
         // first fetch the offset and size
-        auto [offset, size] = lsn_mapping_[lsn];
-        disk_manager_->ReadLog(buffer_, size, offset);
+        auto location = lsn_mapping_[lsn];
+        disk_manager_->ReadLog(buffer_, location.size_, location.offset_, location.partition_);
         // deserialize the log
         auto log = LogRecord::DeserializeFrom(buffer_);
         // undo log
@@ -241,7 +282,8 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
         // do nothing
         break;
     case LogRecordType::INSERT: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
@@ -252,18 +294,19 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
                              log_record.GetPrevLSN(), 
                              LogRecordType::APPLYDELETE, 
                              log_record.GetRID(), 
-                             dummy_tuple);
+                             &dummy_tuple);
         log.SetCLR();
         log_manager_->AppendLogRecord(log);
         // update in-memory lsn
         table_page->SetLSN(log.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         // update last lsn
         active_txn_[log_record.GetTxnId()] = log.GetLSN();
         break;
     }
     case LogRecordType::MARKDELETE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
@@ -274,17 +317,18 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
                              log_record.GetPrevLSN(), 
                              LogRecordType::ROLLBACKDELETE, 
                              log_record.GetRID(), 
-                             dummy_tuple);
+                             &dummy_tuple);
         log.SetCLR();
         log_manager_->AppendLogRecord(log);
         // update lsn
         table_page->SetLSN(log.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         active_txn_[log_record.GetTxnId()] = log.GetLSN();
         break;
     }
     case LogRecordType::APPLYDELETE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
@@ -303,17 +347,18 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
                              log_record.GetPrevLSN(), 
                              LogRecordType::INSERT, 
                              log_record.GetRID(), 
-                             log_record.GetNewTuple());
+                             &log_record.GetNewTuple());
         log.SetCLR();
         log_manager_->AppendLogRecord(log);
         // update lsn
         table_page->SetLSN(log.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         active_txn_[log_record.GetTxnId()] = log.GetLSN();
         break;
     }
     case LogRecordType::ROLLBACKDELETE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
@@ -326,17 +371,18 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
                              log_record.GetPrevLSN(), 
                              LogRecordType::MARKDELETE, 
                              log_record.GetRID(), 
-                             dummy_tuple);
+                             &dummy_tuple);
         log.SetCLR();
         log_manager_->AppendLogRecord(log);
         // update lsn
         table_page->SetLSN(log.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         active_txn_[log_record.GetTxnId()] = log.GetLSN();
         break;
     }
     case LogRecordType::UPDATE: {
-        auto page = buffer_pool_manager_->FetchPage(log_record.GetRID().GetPageId(), false);
+        auto bpm = GetBufferPool(log_record.GetRID().GetPageId());
+        auto page = bpm->FetchPage(log_record.GetRID().GetPageId(), false);
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(page != nullptr, "");
         auto table_page = reinterpret_cast<TablePage *> (page->GetData());
 
@@ -352,13 +398,13 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
                              log_record.GetPrevLSN(), 
                              LogRecordType::UPDATE, 
                              log_record.GetRID(), 
-                             dummy_tuple, 
-                             log_record.GetOldTuple());
+                             &dummy_tuple, 
+                             &log_record.GetOldTuple());
         log.SetCLR();
         log_manager_->AppendLogRecord(log);
         // update lsn
         table_page->SetLSN(log.GetLSN());
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        bpm->UnpinPage(page->GetPageId(), true);
         active_txn_[log_record.GetTxnId()] = log.GetLSN();
         break;
     }
@@ -367,6 +413,10 @@ void RecoveryManager::UndoLog(LogRecord &log_record) {
         // do nothing
         break;
     }
+    case LogRecordType::ALLOCATEPAGE:
+    case LogRecordType::DEALLOCATEPAGE:
+        // redo only
+        break;
     default:
         TINYDB_ASSERT(false, "Invalid Log Type");
     }
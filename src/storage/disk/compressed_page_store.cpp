@@ -0,0 +1,308 @@
+/**
+ * @file compressed_page_store.cpp
+ * @author sheep
+ * @brief implementation of compressed page store
+ * @version 0.1
+ * @date 2022-07-04
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef COMPRESSED_PAGE_STORE_CPP
+#define COMPRESSED_PAGE_STORE_CPP
+
+#include "storage/disk/compressed_page_store.h"
+#include "storage/disk/page_compressor.h"
+#include "common/exception.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TinyDB {
+
+namespace {
+
+bool PWriteAll(int fd, const char *data, size_t size, off_t offset) {
+    size_t write_count = 0;
+    while (write_count < size) {
+        ssize_t rc = pwrite(fd, data + write_count, size - write_count, offset + write_count);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        write_count += rc;
+    }
+    return true;
+}
+
+bool PReadAll(int fd, char *data, size_t size, off_t offset) {
+    size_t read_count = 0;
+    while (read_count < size) {
+        ssize_t rc = pread(fd, data + read_count, size - read_count, offset + read_count);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (rc == 0) {
+            return false;
+        }
+        read_count += rc;
+    }
+    return true;
+}
+
+}
+
+CompressedPageStore::CompressedPageStore(const std::string &data_name, const std::string &table_name, size_t page_size)
+    : page_size_(page_size), data_name_(data_name), table_name_(table_name), free_slots_(page_size / SECTOR_SIZE + 1) {
+    data_fd_ = open(data_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (data_fd_ < 0) {
+        THROW_IO_EXCEPTION(
+            std::string("failed to open compressed page file, filename: ") + data_name_ + ", error: " + strerror(errno));
+    }
+    table_fd_ = open(table_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (table_fd_ < 0) {
+        close(data_fd_);
+        THROW_IO_EXCEPTION(
+            std::string("failed to open page translation table, filename: ") + table_name_ + ", error: " + strerror(errno));
+    }
+    LoadTable();
+}
+
+CompressedPageStore::~CompressedPageStore() {
+    close(data_fd_);
+    close(table_fd_);
+}
+
+void CompressedPageStore::LoadTable() {
+    struct stat stat_buf;
+    if (fstat(table_fd_, &stat_buf) != 0) {
+        THROW_IO_EXCEPTION(std::string("failed to stat page translation table, error: ") + strerror(errno));
+    }
+    // a torn entry at the end is ignored
+    size_t entry_count = static_cast<size_t>(stat_buf.st_size) / sizeof(Entry);
+    table_.resize(entry_count);
+    if (entry_count > 0 && !PReadAll(table_fd_, reinterpret_cast<char *>(table_.data()), entry_count * sizeof(Entry), 0)) {
+        THROW_IO_EXCEPTION(std::string("failed to read page translation table, error: ") + strerror(errno));
+    }
+    dirty_chunks_.assign((entry_count + ENTRIES_PER_CHUNK - 1) / ENTRIES_PER_CHUNK, false);
+
+    // slots that are not referenced are free
+    std::vector<std::pair<uint64_t, size_t>> used;
+    for (auto &entry : table_) {
+        if (entry.length_ != 0) {
+            used.emplace_back(entry.offset_, GetSectorCount(entry.length_));
+            page_count_++;
+        }
+    }
+    std::sort(used.begin(), used.end());
+    uint64_t cursor = 0;
+    auto release_gap = [&](uint64_t end) {
+        while (cursor < end) {
+            size_t sectors = std::min<uint64_t>((end - cursor) / SECTOR_SIZE, page_size_ / SECTOR_SIZE);
+            free_slots_[sectors].push_back(cursor);
+            cursor += sectors * SECTOR_SIZE;
+        }
+    };
+    for (auto &[offset, sectors] : used) {
+        release_gap(offset);
+        cursor = std::max<uint64_t>(cursor, offset + sectors * SECTOR_SIZE);
+    }
+    data_end_ = cursor;
+}
+
+uint64_t CompressedPageStore::AllocateSlot(size_t sectors) {
+    auto &free_slots = free_slots_[sectors];
+    if (!free_slots.empty()) {
+        auto offset = free_slots.back();
+        free_slots.pop_back();
+        return offset;
+    }
+    auto offset = data_end_;
+    data_end_ += sectors * SECTOR_SIZE;
+    return offset;
+}
+
+bool CompressedPageStore::ReadPage(page_id_t page_id, char *data) {
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        if (page_id < 0 || static_cast<size_t>(page_id) >= table_.size() || table_[page_id].length_ == 0) {
+            return false;
+        }
+        entry = table_[page_id];
+    }
+
+    if (entry.length_ == page_size_) {
+        if (!PReadAll(data_fd_, data, page_size_, static_cast<off_t>(entry.offset_))) {
+            LOG_ERROR("I/O error while reading compressed page %d, error: %s", page_id, strerror(errno));
+            memset(data, 0, page_size_);
+        }
+        return true;
+    }
+
+    char buffer[MAX_PAGE_SIZE];
+    if (!PReadAll(data_fd_, buffer, entry.length_, static_cast<off_t>(entry.offset_))) {
+        LOG_ERROR("I/O error while reading compressed page %d, error: %s", page_id, strerror(errno));
+        memset(data, 0, page_size_);
+        return true;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    if (!PageCompressor::Decompress(buffer, entry.length_, data, page_size_)) {
+        LOG_ERROR("compressed page %d is corrupted", page_id);
+        memset(data, 0, page_size_);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    decompress_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+    decompress_count_++;
+    return true;
+}
+
+void CompressedPageStore::WritePage(page_id_t page_id, const char *data) {
+    TINYDB_ASSERT(page_id >= 0, "Invalid page id");
+    char buffer[MAX_PAGE_SIZE];
+    auto t1 = std::chrono::steady_clock::now();
+    // compressed page should be smaller than a raw one, otherwise we store it raw
+    size_t length = PageCompressor::Compress(data, page_size_, buffer, page_size_ - SECTOR_SIZE);
+    auto t2 = std::chrono::steady_clock::now();
+    compress_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+    compress_count_++;
+    const char *payload = buffer;
+    if (length == 0) {
+        length = page_size_;
+        payload = data;
+    }
+    size_t sectors = GetSectorCount(length);
+
+    uint64_t offset;
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        offset = AllocateSlot(sectors);
+    }
+    // pad the slot, so that the tail of sector is deterministic
+    char slot[MAX_PAGE_SIZE];
+    memcpy(slot, payload, length);
+    memset(slot + length, 0, sectors * SECTOR_SIZE - length);
+    if (!PWriteAll(data_fd_, slot, sectors * SECTOR_SIZE, static_cast<off_t>(offset))) {
+        LOG_ERROR("I/O error while writing compressed page %d, error: %s", page_id, strerror(errno));
+        std::lock_guard<std::mutex> guard(latch_);
+        free_slots_[sectors].push_back(offset);
+        return;
+    }
+    raw_bytes_ += page_size_;
+    stored_bytes_ += sectors * SECTOR_SIZE;
+
+    std::lock_guard<std::mutex> guard(latch_);
+    if (static_cast<size_t>(page_id) >= table_.size()) {
+        table_.resize(page_id + 1, Entry{0, 0, 0});
+        dirty_chunks_.resize((table_.size() + ENTRIES_PER_CHUNK - 1) / ENTRIES_PER_CHUNK, true);
+    }
+    auto &entry = table_[page_id];
+    if (entry.length_ != 0) {
+        pending_slots_.emplace_back(entry.offset_, GetSectorCount(entry.length_));
+    } else {
+        page_count_++;
+    }
+    entry.offset_ = offset;
+    entry.length_ = static_cast<uint32_t>(length);
+    dirty_chunks_[page_id / ENTRIES_PER_CHUNK] = true;
+}
+
+bool CompressedPageStore::Contains(page_id_t page_id) {
+    std::lock_guard<std::mutex> guard(latch_);
+    return page_id >= 0 && static_cast<size_t>(page_id) < table_.size() && table_[page_id].length_ != 0;
+}
+
+bool CompressedPageStore::IsEmpty() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return page_count_ == 0;
+}
+
+void CompressedPageStore::Sync() {
+    std::lock_guard<std::mutex> sync_guard(sync_latch_);
+    // every entry we take is pointing to data written before
+    std::vector<std::pair<size_t, std::vector<Entry>>> chunks;
+    std::vector<std::pair<uint64_t, size_t>> pending_slots;
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        for (size_t i = 0; i < dirty_chunks_.size(); i++) {
+            if (!dirty_chunks_[i]) {
+                continue;
+            }
+            auto begin = table_.begin() + i * ENTRIES_PER_CHUNK;
+            auto end = table_.begin() + std::min(table_.size(), (i + 1) * ENTRIES_PER_CHUNK);
+            chunks.emplace_back(i, std::vector<Entry>(begin, end));
+            dirty_chunks_[i] = false;
+        }
+        pending_slots.swap(pending_slots_);
+    }
+    if (chunks.empty() && pending_slots.empty()) {
+        return;
+    }
+
+    auto restore = [&]() {
+        // retry them in next Sync
+        std::lock_guard<std::mutex> guard(latch_);
+        for (auto &chunk : chunks) {
+            dirty_chunks_[chunk.first] = true;
+        }
+        pending_slots_.insert(pending_slots_.end(), pending_slots.begin(), pending_slots.end());
+    };
+    // data goes first, then the table pointing to it
+    if (fdatasync(data_fd_) != 0) {
+        LOG_ERROR("I/O error while syncing compressed page file, error: %s", strerror(errno));
+        restore();
+        return;
+    }
+    for (auto &[index, entries] : chunks) {
+        auto offset = static_cast<off_t>(index * ENTRIES_PER_CHUNK * sizeof(Entry));
+        if (!PWriteAll(table_fd_, reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(Entry), offset)) {
+            LOG_ERROR("I/O error while writing page translation table, error: %s", strerror(errno));
+            restore();
+            return;
+        }
+    }
+    if (fdatasync(table_fd_) != 0) {
+        LOG_ERROR("I/O error while syncing page translation table, error: %s", strerror(errno));
+        restore();
+        return;
+    }
+
+    // nobody references them now
+    std::lock_guard<std::mutex> guard(latch_);
+    for (auto &[offset, sectors] : pending_slots) {
+        free_slots_[sectors].push_back(offset);
+    }
+}
+
+double CompressedPageStore::GetCompressionRatio() const {
+    auto raw_bytes = raw_bytes_.load();
+    return raw_bytes == 0 ? 1.0 : static_cast<double>(stored_bytes_.load()) / raw_bytes;
+}
+
+std::string CompressedPageStore::GetCompressionReport() const {
+    auto compress_count = std::max<uint64_t>(compress_count_.load(), 1);
+    auto decompress_count = std::max<uint64_t>(decompress_count_.load(), 1);
+    std::ostringstream os;
+    os << "PageCompression: "
+       << "Ratio: " << GetCompressionRatio() << ", "
+       << "Compress: " << compress_time_.load() / compress_count << "ns/page, "
+       << "Decompress: " << decompress_time_.load() / decompress_count << "ns/page";
+    return os.str();
+}
+
+}
+
+#endif
@@ -12,160 +12,746 @@
 #ifndef DISK_MANAGER_CPP
 #define DISK_MANAGER_CPP
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <exception>
 #include <sys/stat.h>
 #include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <assert.h>
+#include <fcntl.h>
+#include <limits>
+#include <thread>
+#include <unistd.h>
 
 #include "common/logger.h"
 #include "common/macros.h"
 #include "common/exception.h"
 #include "storage/disk/disk_manager.h"
+#include "recovery/log_manager.h"
 
 namespace TinyDB {
 
 DiskManager::DiskManager(const std::string &filename)
-    : db_name_(filename), next_page_id_(0) {
+    : db_name_(filename) {
     // generate log name
-    auto n = db_name_.rfind('.');
-    if (n == std::string::npos) {
+    if (db_name_.rfind('.') == std::string::npos) {
         THROW_IO_EXCEPTION("Wrong File Format");
         return;
     }
 
-    log_name_ = db_name_.substr(0, n) + ".log";
+    log_name_ = GetSidecarName(db_name_, ".log");
+    fsm_name_ = GetSidecarName(db_name_, ".fsm");
 
+    // open log files. partitions left by previous run are opened as well, so that they could be recovered
+    size_t partition_num = std::max<size_t>(LOG_PARTITION_NUM, 1);
+    while (GetFileSize(GetLogName(partition_num)) >= 0) {
+        partition_num++;
+    }
+    for (size_t i = 0; i < partition_num; i++) {
+        OpenLogFile(i);
+    }
+
+    // open db file
+    OpenDBFile();
+    if (DISK_PAGE_COMPRESSION) {
+        compressed_store_ = std::make_unique<CompressedPageStore>(
+            GetSidecarName(db_name_, ".cpg"), GetSidecarName(db_name_, ".ptt"), page_size_);
+    }
+    OpenFreeSpaceMap();
+
+    // fall back to synchronous I/O when io_uring is not supported.
+    // compressed pages are read and written synchronously
+    if (IO_URING_QUEUE_DEPTH > 0 && compressed_store_ == nullptr) {
+        ring_ = std::make_unique<IOUring>(IO_URING_QUEUE_DEPTH);
+        if (!ring_->IsValid()) {
+            ring_.reset();
+        }
+    }
+
+    // debug
+    allocate_count_ = 0;
+    deallocate_count_ = 0;
+
+    buffer_used_ = nullptr;
+}
+
+DiskManager::~DiskManager() {
+    // ring should be closed before the file it's operating on
+    ring_.reset();
+    for (size_t i = 0; i < segment_count_.load(); i++) {
+        if (segment_fds_[i].load() >= 0) {
+            close(segment_fds_[i].load());
+            segment_fds_[i] = -1;
+        }
+    }
+    if (fsm_fd_ >= 0) {
+        close(fsm_fd_);
+        fsm_fd_ = -1;
+    }
+}
+
+void DiskManager::OpenLogFile(size_t partition) {
+    auto name = GetLogName(partition);
+    auto log_file = std::make_unique<LogFile>();
+    auto &file = log_file->file_;
     // open log file stream
-    log_file_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_file_.is_open()) {
+    file.open(name, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+    if (!file.is_open()) {
         // log is not opended, which means the file doesn't exist
         // then we create it
-        log_file_.clear();
+        file.clear();
         // std::ios::in will fail us when the file is not exist 
-        log_file_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-        log_file_.close();
+        file.open(name, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
+        file.close();
         // reopen it with original mode
-        log_file_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-        if (!log_file_.is_open()) {
-            THROW_IO_EXCEPTION(
-                std::string("failed to open log file, filename: %s", filename.c_str()));
+        file.open(name, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+        if (!file.is_open()) {
+            THROW_IO_EXCEPTION(std::string("failed to open log file, filename: ") + name);
         }
     }
+    log_file->size_ = GetFileSize(name);
+    log_files_.push_back(std::move(log_file));
+}
 
-    // open db file stream
-    db_file_.open(db_name_, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_file_.is_open()) {
-        // is not opened, then we create it
-        db_file_.clear();
-        // std::ios::in will fail us when the file is not exist 
-        db_file_.open(db_name_, std::ios::binary | std::ios::trunc | std::ios::out);
-        db_file_.close();
+void DiskManager::OpenDBFile() {
+    // create it if it doesn't exist
+    int fd = -1;
+    // compressed pages are not aligned, so direct I/O is not used with compression
+    if (DISK_DIRECT_IO && !DISK_PAGE_COMPRESSION) {
+        fd = open(db_name_.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+        if (fd >= 0) {
+            direct_io_ = true;
+        } else {
+            // e.g. tmpfs doesn't support it
+            LOG_WARN("failed to open db file with O_DIRECT, fall back to buffered I/O, error: %s", strerror(errno));
+        }
+    }
+    if (fd < 0) {
+        fd = open(db_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    if (fd < 0) {
+        THROW_IO_EXCEPTION(
+            std::string("failed to open db file, filename: ") + db_name_ + ", error: " + strerror(errno));
+    }
+    try {
+        LoadHeader(fd);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
 
-        // open it again
-        db_file_.open(db_name_, std::ios::binary | std::ios::in | std::ios::out);
-        if (!db_file_.is_open()) {
-            THROW_IO_EXCEPTION(
-                std::string("failed to open db file, filename: %s", filename.c_str()));
+    segment_pages_ = std::max<size_t>(DISK_SEGMENT_SIZE / page_size_, header_page_count_ + 1);
+    if (header_page_count_ == 0) {
+        struct stat stat_buf;
+        if (fstat(fd, &stat_buf) != 0) {
+            close(fd);
+            THROW_IO_EXCEPTION(std::string("failed to stat db file, filename: ") + db_name_ + ", error: " + strerror(errno));
+        }
+        // db file created before segments are introduced could be larger than a segment,
+        // it keeps every page in a single file then
+        if (static_cast<size_t>(stat_buf.st_size) > segment_pages_ * page_size_) {
+            segment_pages_ = static_cast<size_t>(std::numeric_limits<page_id_t>::max()) + 1;
         }
     }
+    segment_limit_ =
+        (static_cast<size_t>(std::numeric_limits<page_id_t>::max()) + header_page_count_) / segment_pages_ + 1;
+    segment_fds_ = std::make_unique<std::atomic<int>[]>(segment_limit_);
+    for (size_t i = 0; i < segment_limit_; i++) {
+        segment_fds_[i] = -1;
+    }
+    segment_fds_[0] = fd;
+    segment_count_ = 1;
 
-    // debug
-    allocate_count_ = 0;
-    deallocate_count_ = 0;
+    // segments are created in order, so the last one tells where the file ends
+    size_t last = 0;
+    while (last + 1 < segment_limit_ && GetSegmentFd(last + 1, false) >= 0) {
+        last++;
+    }
+    struct stat stat_buf;
+    if (fstat(segment_fds_[last].load(), &stat_buf) != 0) {
+        THROW_IO_EXCEPTION(
+            std::string("failed to stat db file, filename: ") + GetSegmentName(last) + ", error: " + strerror(errno));
+    }
+    size_t physical_count = last * segment_pages_ + (static_cast<size_t>(stat_buf.st_size) + page_size_ - 1) / page_size_;
+    file_page_count_ = physical_count > header_page_count_ ? physical_count - header_page_count_ : 0;
+}
 
-    buffer_used_ = nullptr;
+void DiskManager::LoadHeader(int fd) {
+    alignas(DIRECT_IO_ALIGNMENT) char buffer[MAX_PAGE_SIZE];
+    DBFileHeader header;
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) != 0) {
+        THROW_IO_EXCEPTION(std::string("failed to stat db file, error: ") + strerror(errno));
+    }
+
+    if (stat_buf.st_size == 0) {
+        // a new db, page size is chosen now and fixed since then
+        if (!IsValidPageSize(DISK_PAGE_SIZE)) {
+            THROW_IO_EXCEPTION(std::string("invalid page size: ") + std::to_string(DISK_PAGE_SIZE));
+        }
+        page_size_ = DISK_PAGE_SIZE;
+        memset(buffer, 0, page_size_);
+        memcpy(header.magic_, DB_FILE_MAGIC, sizeof(header.magic_));
+        header.version_ = DB_FILE_VERSION;
+        header.page_size_ = page_size_;
+        memcpy(buffer, &header, sizeof(header));
+        // header takes a whole page, so that pages stay aligned
+        if (pwrite(fd, buffer, page_size_, 0) != static_cast<ssize_t>(page_size_) || fdatasync(fd) != 0) {
+            THROW_IO_EXCEPTION(std::string("failed to write db file header, error: ") + strerror(errno));
+        }
+        return;
+    }
+
+    // the smallest page is enough to hold header
+    if (pread(fd, buffer, PAGE_SIZE, 0) != static_cast<ssize_t>(PAGE_SIZE)) {
+        THROW_IO_EXCEPTION(std::string("failed to read db file header, error: ") + strerror(errno));
+    }
+    memcpy(&header, buffer, sizeof(header));
+    if (memcmp(header.magic_, DB_FILE_MAGIC, sizeof(header.magic_)) != 0) {
+        // db file created before header is introduced. it's made of default sized pages from the very beginning
+        LOG_WARN("db file %s has no header, opening it as a legacy db file", db_name_.c_str());
+        page_size_ = PAGE_SIZE;
+        header_page_count_ = 0;
+        return;
+    }
+    if (header.version_ != DB_FILE_VERSION) {
+        THROW_IO_EXCEPTION("db file is created by an incompatible version, filename: " + db_name_);
+    }
+    if (!IsValidPageSize(header.page_size_)) {
+        THROW_IO_EXCEPTION(std::string("db file header is corrupted, page size: ") + std::to_string(header.page_size_));
+    }
+    page_size_ = header.page_size_;
 }
 
-DiskManager::~DiskManager() {
-    if (db_file_.is_open()) {
-        db_file_.close();
+std::string DiskManager::GetSidecarName(const std::string &filename, const std::string &extension) {
+    return filename.substr(0, filename.rfind('.')) + extension;
+}
+
+void DiskManager::RemoveFiles(const std::string &filename) {
+    remove(filename.c_str());
+    // segments and log partitions are numbered contiguously
+    for (size_t i = 1; remove((filename + "." + std::to_string(i)).c_str()) == 0; i++) {}
+    auto log_name = GetSidecarName(filename, ".log");
+    remove(log_name.c_str());
+    for (size_t i = 1; remove(GetLogName(log_name, i).c_str()) == 0; i++) {}
+    for (auto extension : {".fsm", ".cpg", ".ptt"}) {
+        remove(GetSidecarName(filename, extension).c_str());
+    }
+}
+
+bool DiskManager::IsValidPageSize(size_t page_size) {
+    return page_size >= PAGE_SIZE && page_size <= MAX_PAGE_SIZE && (page_size & (page_size - 1)) == 0;
+}
+
+void DiskManager::GetPageLocation(page_id_t page_id, size_t *segment, off_t *offset) const {
+    auto index = static_cast<size_t>(page_id) + header_page_count_;
+    *segment = index / segment_pages_;
+    *offset = static_cast<off_t>(index % segment_pages_) * page_size_;
+}
+
+std::string DiskManager::GetSegmentName(size_t segment) const {
+    if (segment == 0) {
+        return db_name_;
+    }
+    return db_name_ + "." + std::to_string(segment);
+}
+
+int DiskManager::GetSegmentFd(size_t segment, bool create) {
+    if (segment >= segment_limit_) {
+        return -1;
+    }
+    int fd = segment_fds_[segment].load();
+    if (fd >= 0) {
+        return fd;
+    }
+
+    std::lock_guard<std::mutex> guard(segment_latch_);
+    if (segment < segment_count_.load()) {
+        return segment_fds_[segment].load();
+    }
+    // segments before it are created as well, so that they stay contiguous
+    int flags = O_RDWR | (create ? O_CREAT : 0) | (direct_io_ ? O_DIRECT : 0);
+    for (size_t i = segment_count_.load(); i <= segment; i++) {
+        fd = open(GetSegmentName(i).c_str(), flags, 0644);
+        if (fd < 0) {
+            if (create) {
+                LOG_ERROR("failed to open segment file %s, error: %s", GetSegmentName(i).c_str(), strerror(errno));
+            }
+            return -1;
+        }
+        segment_fds_[i] = fd;
+        segment_count_ = i + 1;
+    }
+    return fd;
+}
+
+void DiskManager::OpenFreeSpaceMap() {
+    fsm_fd_ = open(fsm_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fsm_fd_ < 0) {
+        THROW_IO_EXCEPTION(
+            std::string("failed to open free space map, filename: ") + fsm_name_ + ", error: " + strerror(errno));
+    }
+
+    if (file_page_count_.load() == 0 && (compressed_store_ == nullptr || compressed_store_->IsEmpty())) {
+        // map belongs to a db file that doesn't exist anymore
+        if (ftruncate(fsm_fd_, 0) != 0) {
+            LOG_ERROR("failed to truncate free space map, error: %s", strerror(errno));
+        }
+        return;
+    }
+
+    char data[PAGE_SIZE];
+    size_t index = 0;
+    while (true) {
+        auto rc = pread(fsm_fd_, data, PAGE_SIZE, static_cast<off_t>(index * PAGE_SIZE));
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+        if (rc != static_cast<ssize_t>(PAGE_SIZE)) {
+            // a torn page at the end is ignored, it will be rebuilt by recovery
+            break;
+        }
+        free_space_map_.LoadBitmapPage(index++, data);
+    }
+
+    if (index == 0 && header_page_count_ == 0) {
+        // legacy db file never had a map, pages were never reused then. treat all of them as allocated
+        for (size_t page = 0; page < file_page_count_.load(); page++) {
+            free_space_map_.SetAllocated(static_cast<page_id_t>(page), true, INVALID_LSN);
+        }
     }
 }
 
 page_id_t DiskManager::AllocatePage() {
-    // TODO: use bitmap to manage free pages
+    page_id_t new_page_id;
+    // whether the page is known to be zero on disk
+    bool is_zero;
+    {
+        std::lock_guard<std::mutex> guard(db_latch_);
+        // reuse the lowest free page, so that file stays compact
+        new_page_id = free_space_map_.FindFreePage();
+        lsn_t lsn = INVALID_LSN;
+        if (log_manager_ != nullptr) {
+            // bitmap page won't be written back before this record
+            auto log = LogRecord(INVALID_TXN_ID, INVALID_LSN, LogRecordType::ALLOCATEPAGE, new_page_id);
+            lsn = log_manager_->AppendLogRecord(log);
+        }
+        free_space_map_.SetAllocated(new_page_id, true, lsn);
 
-    // flush a empty page to disk
-    // to prevent reading past file
-    // or we can flush it lazily until we write something really
-    page_id_t new_page_id = next_page_id_++;
-    char data[PAGE_SIZE] = {0};
-    int offset = new_page_id * PAGE_SIZE;
-    db_file_.seekp(offset);
-    db_file_.write(data, PAGE_SIZE);
+        // debug purpose
+        allocate_count_++;
 
-    // debug purpose
-    allocate_count_++;
+        auto page_index = static_cast<size_t>(new_page_id);
+        if (compressed_store_ != nullptr) {
+            // pages are not preallocated, a page that is never written reads as zero
+            is_zero = page_index >= file_page_count_.load() && !compressed_store_->Contains(new_page_id);
+        } else if (page_index >= extent_end_ && page_index >= file_page_count_.load()) {
+            is_zero = ExtendFile(new_page_id);
+        } else {
+            is_zero = page_index >= extent_begin_ && page_index < extent_end_;
+        }
+        if (is_zero) {
+            // pages below it are all allocated, so they won't be handed out as zero page again
+            extent_begin_ = page_index + 1;
+        }
+    }
+
+    if (!is_zero) {
+        // page might be used before, flush a empty page to disk so that
+        // nobody reads the stale content
+        alignas(DIRECT_IO_ALIGNMENT) char data[MAX_PAGE_SIZE] = {0};
+        WritePage(new_page_id, data);
+    }
 
     return new_page_id;
 }
 
+bool DiskManager::ExtendFile(page_id_t page_id) {
+    size_t begin = file_page_count_.load();
+    size_t end = std::max(begin + std::max<size_t>(DISK_EXTENSION_PAGES, 1), static_cast<size_t>(page_id) + 1);
+
+    // extent may span several segments
+    for (size_t page = begin; page < end;) {
+        size_t segment;
+        off_t offset;
+        GetPageLocation(static_cast<page_id_t>(page), &segment, &offset);
+        size_t segment_end = std::min(end, (segment + 1) * segment_pages_ - header_page_count_);
+        int fd = GetSegmentFd(segment, true);
+        if (fd < 0) {
+            return false;
+        }
+        auto length = static_cast<off_t>(segment_end - page) * page_size_;
+
+        int rc;
+        do {
+            rc = fallocate(fd, 0, offset, length);
+        } while (rc != 0 && errno == EINTR);
+        if (rc != 0 && errno == EOPNOTSUPP) {
+            // file system doesn't support preallocation, extending it leaves a hole which reads as zero as well
+            rc = ftruncate(fd, offset + length);
+        }
+        if (rc != 0) {
+            LOG_ERROR("failed to extend db file, error: %s", strerror(errno));
+            return false;
+        }
+        page = segment_end;
+    }
+
+    UpdateFileSize(static_cast<page_id_t>(end - 1));
+    extent_begin_ = begin;
+    extent_end_ = end;
+    return true;
+}
+
+void DiskManager::UpdateFileSize(page_id_t page_id) {
+    size_t page_count = static_cast<size_t>(page_id) + 1;
+    size_t current = file_page_count_.load();
+    while (current < page_count && !file_page_count_.compare_exchange_weak(current, page_count)) {}
+}
+
 void DiskManager::DeallocatePage(page_id_t page_id) {
-    // same as above
+    std::lock_guard<std::mutex> guard(db_latch_);
+    if (!free_space_map_.IsAllocated(page_id)) {
+        LOG_WARN("deallocating page %d which is not allocated", page_id);
+        return;
+    }
+    lsn_t lsn = INVALID_LSN;
+    if (log_manager_ != nullptr) {
+        auto log = LogRecord(INVALID_TXN_ID, INVALID_LSN, LogRecordType::DEALLOCATEPAGE, page_id);
+        lsn = log_manager_->AppendLogRecord(log);
+    }
+    free_space_map_.SetAllocated(page_id, false, lsn);
 
     // debug purpose
     deallocate_count_++;
 }
 
+void DiskManager::RedoAllocation(page_id_t page_id, bool allocated, lsn_t lsn) {
+    std::lock_guard<std::mutex> guard(db_latch_);
+    // if this change has been persisted on disk, then we don't need to redo it
+    auto page_lsn = free_space_map_.GetLSN(page_id);
+    if (page_lsn != INVALID_LSN && page_lsn >= lsn) {
+        return;
+    }
+    free_space_map_.SetAllocated(page_id, allocated, lsn);
+}
+
 void DiskManager::ReadPage(page_id_t pageId, char *data, bool outbound_is_error) {
+    if (!IsAligned(data)) {
+        // direct I/O needs an aligned buffer
+        alignas(DIRECT_IO_ALIGNMENT) char buffer[MAX_PAGE_SIZE];
+        ReadPage(pageId, buffer, outbound_is_error);
+        memcpy(data, buffer, page_size_);
+        return;
+    }
     auto t1 = std::chrono::steady_clock::now();
+    // pages that are never written since compression is enabled are read from db file
+    if (compressed_store_ != nullptr && compressed_store_->ReadPage(pageId, data)) {
+        auto t2 = std::chrono::steady_clock::now();
+        data_read_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+        return;
+    }
     // disable this check for now, we shall add it back 
     // once we figured out how to store the metadata
-    // assert(pageId < next_page_id_);
+    // assert(free_space_map_.IsAllocated(pageId));
+
+    size_t segment;
+    off_t offset;
+    GetPageLocation(pageId, &segment, &offset);
+    int fd = -1;
+    // we know where the file ends, so don't bother reading past it
+    if (static_cast<size_t>(pageId) < file_page_count_.load()) {
+        fd = GetSegmentFd(segment, false);
+    }
+
+    // pread may return less than we asked, keep reading until we reach the end of file
+    size_t read_count = 0;
+    while (fd >= 0 && read_count < page_size_) {
+        ssize_t rc = pread(fd, data + read_count, page_size_ - read_count, offset + read_count);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("I/O error while reading page %d, error: %s", pageId, strerror(errno));
+            return;
+        }
+        if (rc == 0) {
+            break;
+        }
+        read_count += rc;
+        if (direct_io_) {
+            // the rest starts at an unaligned offset, it's the end of file anyway
+            break;
+        }
+    }
 
-    int offset = pageId * PAGE_SIZE;
-    
-    // getFileSize everytime, really?
-    // TODO: we need to cache it
-    if (offset > GetFileSize(db_name_)) {
+    if (read_count == 0) {
+        // reading past the end of file
         if (outbound_is_error) {
             LOG_ERROR("read past end of file, page_id: %d", pageId);
-        } else {
-            memset(data, 0, PAGE_SIZE);
         }
-        return;
+        memset(data, 0, page_size_);
+    } else if (read_count < page_size_) {
+        LOG_ERROR("read less than a page, page_id: %d", pageId);
+        // set those random data to 0
+        memset(data + read_count, 0, page_size_ - read_count);
     }
 
-    // seekp and seekg works the same in file stream, so don't worry here
-    db_file_.seekp(offset);
-    db_file_.read(data, PAGE_SIZE);
-    if (db_file_.bad()) {
-        LOG_ERROR("I/O error while reading page %d", pageId);
+    auto t2 = std::chrono::steady_clock::now();
+    data_read_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+}
+
+void DiskManager::WritePage(page_id_t pageId, const char *data) {
+    // assert(free_space_map_.IsAllocated(pageId));
+    if (!IsAligned(data)) {
+        // direct I/O needs an aligned buffer
+        alignas(DIRECT_IO_ALIGNMENT) char buffer[MAX_PAGE_SIZE];
+        memcpy(buffer, data, page_size_);
+        WritePage(pageId, buffer);
+        return;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    if (compressed_store_ != nullptr) {
+        compressed_store_->WritePage(pageId, data);
+        auto t2 = std::chrono::steady_clock::now();
+        data_write_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
         return;
     }
 
-    uint32_t readCount = db_file_.gcount();
-    if (readCount < PAGE_SIZE) {
-        LOG_ERROR("read less than a page, page_id: %d", pageId);
-        db_file_.clear();
-
-        // set those random data to 0
-        memset(data + readCount, 0, PAGE_SIZE - readCount);
+    size_t segment;
+    off_t offset;
+    GetPageLocation(pageId, &segment, &offset);
+    int fd = GetSegmentFd(segment, true);
+    if (fd < 0) {
+        LOG_ERROR("failed to write page %d, segment file is not available", pageId);
+        return;
     }
+    size_t write_count = 0;
+    while (write_count < page_size_) {
+        ssize_t rc = pwrite(fd, data + write_count, page_size_ - write_count, offset + write_count);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("I/O error while writing page %d, error: %s", pageId, strerror(errno));
+            return;
+        }
+        write_count += rc;
+    }
+    UpdateFileSize(pageId);
 
     auto t2 = std::chrono::steady_clock::now();
-    data_read_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+    data_write_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
 }
 
-void DiskManager::WritePage(page_id_t pageId, const char *data) {
-    // assert(pageId < next_page_id_);
-    auto t1 = std::chrono::steady_clock::now();
+void DiskManager::SubmitBatch(IOBatch *batch) {
+    batch->pending_.store(batch->requests_.size());
+    if (ring_ == nullptr) {
+        for (auto &request : batch->requests_) {
+            if (request.is_write_) {
+                WritePage(request.page_id_, request.data_);
+            } else {
+                ReadPage(request.page_id_, request.data_, request.outbound_is_error_);
+            }
+            batch->pending_--;
+        }
+        return;
+    }
+
+    auto limit = ring_->GetCQEntries();
+    size_t i = 0;
+    while (i < batch->requests_.size()) {
+        // make sure completions won't overflow
+        if (inflight_.load() >= limit) {
+            ReapUntil([&] { return inflight_.load() < limit; });
+        }
 
-    int offset = pageId * PAGE_SIZE;
-    db_file_.seekp(offset);
-    db_file_.write(data, PAGE_SIZE);
+        std::unique_lock<std::mutex> guard(sq_latch_);
+        for (; i < batch->requests_.size() && inflight_.load() < limit; i++) {
+            auto &request = batch->requests_[i];
+            size_t segment;
+            off_t offset;
+            GetPageLocation(request.page_id_, &segment, &offset);
+            int fd = GetSegmentFd(segment, request.is_write_);
+            if (fd < 0) {
+                // segment doesn't exist or can't be created, synchronous path knows how to deal with it
+                if (request.is_write_) {
+                    WritePage(request.page_id_, request.data_);
+                } else {
+                    ReadPage(request.page_id_, request.data_, request.outbound_is_error_);
+                }
+                batch->pending_--;
+                continue;
+            }
+            auto user_data = reinterpret_cast<uint64_t>(&request);
+            if (!IsAligned(request.data_) && request.bounce_ == nullptr) {
+                // direct I/O needs an aligned buffer, it's released on completion
+                request.bounce_ = static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, page_size_));
+                if (request.is_write_) {
+                    memcpy(request.bounce_, request.data_, page_size_);
+                }
+            }
+            auto buffer = request.bounce_ != nullptr ? request.bounce_ : request.data_;
+            bool prepared = request.is_write_
+                ? ring_->PrepareWrite(fd, buffer, page_size_, static_cast<uint64_t>(offset), user_data)
+                : ring_->PrepareRead(fd, buffer, page_size_, static_cast<uint64_t>(offset), user_data);
+            if (!prepared) {
+                // submission queue is full
+                break;
+            }
+            inflight_++;
+        }
+        // prepared entries are already counted as in flight, they must all reach kernel,
+        // otherwise waiting for their completions never ends
+        while (true) {
+            int rc = ring_->Submit();
+            if (rc < 0 && rc != -EAGAIN && rc != -EBUSY) {
+                THROW_IO_EXCEPTION(std::string("failed to submit io_uring requests, error: ") + strerror(-rc));
+            }
+            auto pending = ring_->GetPendingCount();
+            if (pending == 0) {
+                break;
+            }
+            // kernel can't take more for now. let completions drain without holding the latch,
+            // whoever holds it next submits what we've left in the queue.
+            // completion leaves inflight_ before it's counted, so the snapshot never misses one
+            auto completed = async_io_count_.load();
+            bool in_kernel = inflight_.load() > pending;
+            guard.unlock();
+            WaitSubmitRoom(completed, in_kernel);
+            guard.lock();
+        }
+    }
+}
 
-    if (db_file_.bad()) {
-        LOG_ERROR("I/O error while writing page %d", pageId);
+void DiskManager::WaitSubmitRoom(size_t completed, bool in_kernel) {
+    if (in_kernel) {
+        // wait until one of the submitted requests completes
+        ReapUntil([&] { return async_io_count_.load() > completed; });
         return;
     }
+    // nothing to reap, kernel is short of resources. back off for a while
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
 
-    db_file_.flush();
+void DiskManager::WaitBatch(IOBatch *batch) {
+    if (batch->IsCompleted()) {
+        return;
+    }
+    ReapUntil([&] { return batch->IsCompleted(); });
+}
+
+void DiskManager::ReapUntil(const std::function<bool()> &condition) {
+    std::unique_lock<std::mutex> guard(cq_latch_);
+    while (!condition()) {
+        if (reaping_) {
+            // someone else is reaping, it will wake us up after that
+            cq_cv_.wait(guard);
+            continue;
+        }
+        reaping_ = true;
+        guard.unlock();
+
+        auto handler = [&](uint64_t user_data, int res) {
+            CompleteRequest(reinterpret_cast<IOBatch::Request *>(user_data), res);
+        };
+        if (ring_->Reap(handler) == 0) {
+            // we are waiting for something in flight, so there will be a completion
+            int rc = ring_->Wait();
+            if (rc < 0) {
+                LOG_ERROR("failed to wait for io_uring, error: %s", strerror(-rc));
+            }
+            ring_->Reap(handler);
+        }
+
+        guard.lock();
+        reaping_ = false;
+        cq_cv_.notify_all();
+    }
+}
+
+void DiskManager::CompleteRequest(IOBatch::Request *request, int res) {
+    if (res != static_cast<int>(page_size_)) {
+        // error, short I/O or reading past the end of file.
+        // synchronous path knows how to deal with them
+        if (res < 0) {
+            LOG_WARN("io_uring request of page %d failed, retry it synchronously, error: %s", request->page_id_,
+                     strerror(-res));
+        }
+        if (request->is_write_) {
+            WritePage(request->page_id_, request->data_);
+        } else {
+            ReadPage(request->page_id_, request->data_, request->outbound_is_error_);
+        }
+    } else if (request->is_write_) {
+        UpdateFileSize(request->page_id_);
+    } else if (request->bounce_ != nullptr) {
+        memcpy(request->data_, request->bounce_, page_size_);
+    }
+    if (request->bounce_ != nullptr) {
+        free(request->bounce_);
+        request->bounce_ = nullptr;
+    }
+    inflight_--;
+    async_io_count_++;
+    request->batch_->pending_--;
+}
+
+void DiskManager::Sync() {
+    std::lock_guard<std::mutex> sync_guard(sync_latch_);
+    auto t1 = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < segment_count_.load(); i++) {
+        if (fdatasync(segment_fds_[i].load()) != 0) {
+            LOG_ERROR("I/O error while syncing db file %s, error: %s", GetSegmentName(i).c_str(), strerror(errno));
+            return;
+        }
+    }
+    if (compressed_store_ != nullptr) {
+        compressed_store_->Sync();
+    }
+
+    // write back free space map after the pages it's describing
+    std::vector<std::pair<size_t, std::unique_ptr<char[]>>> pages;
+    lsn_t max_lsn;
+    LogManager *log_manager;
+    {
+        std::lock_guard<std::mutex> guard(db_latch_);
+        max_lsn = free_space_map_.CollectDirtyPages(&pages);
+        log_manager = log_manager_;
+    }
+    if (!pages.empty()) {
+        // enforce WAL
+        if (log_manager != nullptr && max_lsn != INVALID_LSN) {
+            log_manager->Flush(max_lsn, true);
+        }
+        for (auto &[index, data] : pages) {
+            off_t offset = static_cast<off_t>(index * PAGE_SIZE);
+            size_t write_count = 0;
+            while (write_count < PAGE_SIZE) {
+                ssize_t rc = pwrite(fsm_fd_, data.get() + write_count, PAGE_SIZE - write_count, offset + write_count);
+                if (rc < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    LOG_ERROR("I/O error while writing free space map, error: %s", strerror(errno));
+                    return;
+                }
+                write_count += rc;
+            }
+        }
+        if (fdatasync(fsm_fd_) != 0) {
+            LOG_ERROR("I/O error while syncing free space map, error: %s", strerror(errno));
+            return;
+        }
+    }
 
     auto t2 = std::chrono::steady_clock::now();
-    data_write_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+    data_sync_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
 }
 
 int DiskManager::GetFileSize(const std::string &filename) {
@@ -174,26 +760,29 @@ int DiskManager::GetFileSize(const std::string &filename) {
     return rc == 0 ? static_cast<int> (stat_buf.st_size) : -1;
 }
 
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
+bool DiskManager::ReadLog(char *log_data, int size, int offset, size_t partition) {
     auto t1 = std::chrono::steady_clock::now();
+    if (partition >= log_files_.size()) {
+        return false;
+    }
+    auto &log_file = *log_files_[partition];
 
-    // this is stupid. we should cache the log size then read it till end
-    // since log file won't change while performing recovery protocol.
-    if (offset >= GetFileSize(log_name_)) {
+    // log is only appended through us, so cached size is accurate
+    if (offset >= log_file.size_.load()) {
         return false;
     }
 
-    log_file_.seekp(offset);
-    log_file_.read(log_data, size);
+    log_file.file_.seekp(offset);
+    log_file.file_.read(log_data, size);
 
-    if (log_file_.bad()) {
+    if (log_file.file_.bad()) {
         LOG_ERROR("I/O error while reading log");
         return false;
     }
 
-    int read_count = log_file_.gcount();
+    int read_count = log_file.file_.gcount();
     if (read_count < size) {
-        log_file_.clear();
+        log_file.file_.clear();
         // pad with zero
         memset(log_data + read_count, 0, size - read_count);
     }
@@ -203,7 +792,7 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
     return true;
 }
 
-void DiskManager::WriteLog(char *log_data, int size) {
+void DiskManager::WriteLog(char *log_data, int size, size_t partition) {
     // count time
     auto t1 = std::chrono::steady_clock::now();
 
@@ -215,18 +804,21 @@ void DiskManager::WriteLog(char *log_data, int size) {
     if (size == 0) {
         return;
     }
+    TINYDB_ASSERT(partition < log_files_.size(), "invalid log partition");
+    auto &log_file = *log_files_[partition];
 
     // append the log
-    log_file_.write(log_data, size);
+    log_file.file_.write(log_data, size);
 
     // check for IO-error
-    if (log_file_.bad()) {
+    if (log_file.file_.bad()) {
         LOG_ERROR("I/O error while writing log");
         return;
     }
 
     // flush to disk
-    log_file_.flush();
+    log_file.file_.flush();
+    log_file.size_ += size;
 
     auto t2 = std::chrono::steady_clock::now();
     log_write_time_ += std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
@@ -235,6 +827,23 @@ void DiskManager::WriteLog(char *log_data, int size) {
     // LOG_INFO("%f", fp_ms.count());
 }
 
+void DiskManager::TruncateLog(size_t partition, int size) {
+    auto &log_file = *log_files_[partition];
+    if (size >= log_file.size_.load()) {
+        return;
+    }
+    auto name = GetLogName(partition);
+    log_file.file_.close();
+    if (truncate(name.c_str(), size) != 0) {
+        LOG_ERROR("failed to truncate log file %s, error: %s", name.c_str(), strerror(errno));
+    }
+    log_file.file_.open(name, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+    if (!log_file.file_.is_open()) {
+        THROW_IO_EXCEPTION(std::string("failed to open log file, filename: ") + name);
+    }
+    log_file.size_ = GetFileSize(name);
+}
+
 }
 
 
@@ -0,0 +1,138 @@
+/**
+ * @file free_space_map.cpp
+ * @author sheep
+ * @brief implementation of free space map
+ * @version 0.1
+ * @date 2022-07-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef FREE_SPACE_MAP_CPP
+#define FREE_SPACE_MAP_CPP
+
+#include "storage/disk/free_space_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace TinyDB {
+
+page_id_t FreeSpaceMap::FindFreePage() {
+    size_t limit = bitmap_pages_.size() * PAGES_PER_BITMAP_PAGE;
+    while (first_free_ < limit) {
+        auto bits = bitmap_pages_[first_free_ / PAGES_PER_BITMAP_PAGE].get() + HEADER_SIZE;
+        size_t offset = first_free_ % PAGES_PER_BITMAP_PAGE;
+        // skip the bytes that are full
+        if (offset % 8 == 0 && static_cast<uint8_t>(bits[offset / 8]) == 0xff) {
+            first_free_ += 8;
+            continue;
+        }
+        if ((bits[offset / 8] & (1 << (offset % 8))) == 0) {
+            break;
+        }
+        first_free_++;
+    }
+    // pages beyond the bitmap are free as well
+    return static_cast<page_id_t>(first_free_);
+}
+
+bool FreeSpaceMap::IsAllocated(page_id_t page_id) const {
+    size_t index = page_id / PAGES_PER_BITMAP_PAGE;
+    if (page_id < 0 || index >= bitmap_pages_.size()) {
+        return false;
+    }
+    size_t offset = page_id % PAGES_PER_BITMAP_PAGE;
+    auto bits = bitmap_pages_[index].get() + HEADER_SIZE;
+    return (bits[offset / 8] & (1 << (offset % 8))) != 0;
+}
+
+void FreeSpaceMap::SetAllocated(page_id_t page_id, bool allocated, lsn_t lsn) {
+    TINYDB_ASSERT(page_id >= 0, "Invalid page id");
+    Extend(page_id);
+    size_t index = page_id / PAGES_PER_BITMAP_PAGE;
+    size_t offset = page_id % PAGES_PER_BITMAP_PAGE;
+    auto data = bitmap_pages_[index].get();
+    if (lsn != INVALID_LSN) {
+        memcpy(data, &lsn, sizeof(lsn_t));
+    }
+    dirty_[index] = true;
+
+    auto &byte = data[HEADER_SIZE + offset / 8];
+    bool was_allocated = (byte & (1 << (offset % 8))) != 0;
+    if (was_allocated == allocated) {
+        return;
+    }
+    if (allocated) {
+        byte |= (1 << (offset % 8));
+        allocated_count_++;
+        page_count_ = std::max(page_count_, static_cast<size_t>(page_id) + 1);
+    } else {
+        byte &= ~(1 << (offset % 8));
+        allocated_count_--;
+        first_free_ = std::min(first_free_, static_cast<size_t>(page_id));
+    }
+}
+
+lsn_t FreeSpaceMap::GetLSN(page_id_t page_id) const {
+    size_t index = page_id / PAGES_PER_BITMAP_PAGE;
+    if (index >= bitmap_pages_.size()) {
+        return INVALID_LSN;
+    }
+    lsn_t lsn;
+    memcpy(&lsn, bitmap_pages_[index].get(), sizeof(lsn_t));
+    return lsn;
+}
+
+void FreeSpaceMap::LoadBitmapPage(size_t index, const char *data) {
+    Extend(static_cast<page_id_t>(index * PAGES_PER_BITMAP_PAGE));
+    auto page = bitmap_pages_[index].get();
+    // drop the previous content before counting the new one
+    for (size_t i = 0; i < PAGES_PER_BITMAP_PAGE; i++) {
+        if ((page[HEADER_SIZE + i / 8] & (1 << (i % 8))) != 0) {
+            allocated_count_--;
+        }
+    }
+    memcpy(page, data, PAGE_SIZE);
+    for (size_t i = 0; i < PAGES_PER_BITMAP_PAGE; i++) {
+        if ((page[HEADER_SIZE + i / 8] & (1 << (i % 8))) != 0) {
+            allocated_count_++;
+            page_count_ = std::max(page_count_, index * PAGES_PER_BITMAP_PAGE + i + 1);
+        }
+    }
+    dirty_[index] = false;
+    // rescan from the beginning
+    first_free_ = 0;
+}
+
+lsn_t FreeSpaceMap::CollectDirtyPages(std::vector<std::pair<size_t, std::unique_ptr<char[]>>> *pages) {
+    lsn_t max_lsn = INVALID_LSN;
+    for (size_t i = 0; i < bitmap_pages_.size(); i++) {
+        if (!dirty_[i]) {
+            continue;
+        }
+        auto copy = std::make_unique<char[]>(PAGE_SIZE);
+        memcpy(copy.get(), bitmap_pages_[i].get(), PAGE_SIZE);
+        max_lsn = std::max(max_lsn, GetLSN(static_cast<page_id_t>(i * PAGES_PER_BITMAP_PAGE)));
+        pages->emplace_back(i, std::move(copy));
+        dirty_[i] = false;
+    }
+    return max_lsn;
+}
+
+void FreeSpaceMap::Extend(page_id_t page_id) {
+    size_t index = page_id / PAGES_PER_BITMAP_PAGE;
+    while (bitmap_pages_.size() <= index) {
+        auto page = std::make_unique<char[]>(PAGE_SIZE);
+        memset(page.get(), 0, PAGE_SIZE);
+        lsn_t lsn = INVALID_LSN;
+        memcpy(page.get(), &lsn, sizeof(lsn_t));
+        bitmap_pages_.push_back(std::move(page));
+        dirty_.push_back(true);
+    }
+}
+
+}
+
+#endif
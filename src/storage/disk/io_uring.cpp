@@ -0,0 +1,188 @@
+/**
+ * @file io_uring.cpp
+ * @author sheep
+ * @brief implementation of io_uring wrapper
+ * @version 0.1
+ * @date 2022-06-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef IO_URING_CPP
+#define IO_URING_CPP
+
+#include "storage/disk/io_uring.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace TinyDB {
+
+static int SysIOUringSetup(unsigned entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int SysIOUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+IOUring::IOUring(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = SysIOUringSetup(entries, &params);
+    if (fd < 0) {
+        // kernel is too old, or io_uring is forbidden
+        LOG_INFO("io_uring is not available, error: %s", strerror(errno));
+        return;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        cq_ring_size_ = sq_ring_size_;
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        close(fd);
+        return;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                        IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            munmap(sq_ring_, sq_ring_size_);
+            sq_ring_ = nullptr;
+            close(fd);
+            return;
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = cq_ring_ = nullptr;
+        close(fd);
+        return;
+    }
+    sqes_ = reinterpret_cast<io_uring_sqe *>(sqes);
+
+    auto sq = reinterpret_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto cq = reinterpret_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    sq_entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+    ring_fd_ = fd;
+}
+
+IOUring::~IOUring() {
+    if (!IsValid()) {
+        return;
+    }
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+bool IOUring::Prepare(uint8_t opcode, int fd, void *buf, unsigned len, uint64_t offset, uint64_t user_data) {
+    // we are the only producer, kernel moves the head
+    unsigned tail = *sq_tail_;
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (tail - head >= sq_entries_) {
+        return false;
+    }
+
+    unsigned index = tail & *sq_mask_;
+    auto sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    // entry should be visible before kernel sees the new tail
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit_++;
+    return true;
+}
+
+int IOUring::Submit() {
+    int submitted = 0;
+    while (to_submit_ > 0) {
+        int rc = SysIOUringEnter(ring_fd_, to_submit_, 0, 0);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // report what we've submitted so far, caller will retry the rest
+            return submitted > 0 ? submitted : -errno;
+        }
+        if (rc == 0) {
+            break;
+        }
+        to_submit_ -= rc;
+        submitted += rc;
+    }
+    return submitted;
+}
+
+int IOUring::Wait() {
+    while (true) {
+        int rc = SysIOUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        if (rc >= 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+size_t IOUring::Reap(const std::function<void(uint64_t, int)> &handler) {
+    // we are the only consumer, kernel moves the tail
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    size_t count = 0;
+    while (head != tail) {
+        auto cqe = &cqes_[head & *cq_mask_];
+        handler(cqe->user_data, cqe->res);
+        head++;
+        count++;
+    }
+    // release the entries back to kernel
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+}
+
+#endif
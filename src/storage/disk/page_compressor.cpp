@@ -0,0 +1,173 @@
+/**
+ * @file page_compressor.cpp
+ * @author sheep
+ * @brief implementation of page compressor
+ * @version 0.1
+ * @date 2022-07-04
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef PAGE_COMPRESSOR_CPP
+#define PAGE_COMPRESSOR_CPP
+
+#include "storage/disk/page_compressor.h"
+
+#include <cstring>
+
+namespace TinyDB {
+
+namespace {
+
+inline uint32_t Load32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// write a length in 255-run form, return false if it doesn't fit
+inline bool WriteLength(size_t length, char *dst, size_t dst_capacity, size_t *dp) {
+    while (length >= 255) {
+        if (*dp >= dst_capacity) {
+            return false;
+        }
+        dst[(*dp)++] = static_cast<char>(255);
+        length -= 255;
+    }
+    if (*dp >= dst_capacity) {
+        return false;
+    }
+    dst[(*dp)++] = static_cast<char>(length);
+    return true;
+}
+
+inline bool ReadLength(const char *src, size_t src_size, size_t *sp, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*sp >= src_size) {
+            return false;
+        }
+        byte = static_cast<uint8_t>(src[(*sp)++]);
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// emit a sequence, match_length is 0 for the last one
+bool WriteSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length,
+                   char *dst, size_t dst_capacity, size_t *dp) {
+    if (*dp >= dst_capacity) {
+        return false;
+    }
+    size_t token_pos = (*dp)++;
+    uint8_t token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+    if (literal_length >= 15 && !WriteLength(literal_length - 15, dst, dst_capacity, dp)) {
+        return false;
+    }
+    if (*dp + literal_length > dst_capacity) {
+        return false;
+    }
+    memcpy(dst + *dp, literals, literal_length);
+    *dp += literal_length;
+
+    if (match_length != 0) {
+        if (*dp + 2 > dst_capacity) {
+            return false;
+        }
+        dst[(*dp)++] = static_cast<char>(offset & 0xff);
+        dst[(*dp)++] = static_cast<char>(offset >> 8);
+        size_t length = match_length - PageCompressor::MIN_MATCH;
+        token |= static_cast<uint8_t>(length < 15 ? length : 15);
+        if (length >= 15 && !WriteLength(length - 15, dst, dst_capacity, dp)) {
+            return false;
+        }
+    }
+    dst[token_pos] = static_cast<char>(token);
+    return true;
+}
+
+}
+
+size_t PageCompressor::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+    // position of the last occurrence of every hashed 4-byte sequence
+    int32_t table[1 << HASH_BITS];
+    for (auto &position : table) {
+        position = -1;
+    }
+
+    size_t ip = 0;
+    size_t anchor = 0;
+    size_t dp = 0;
+    while (ip + MIN_MATCH <= src_size) {
+        uint32_t sequence = Load32(src + ip);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+        int32_t ref = table[hash];
+        table[hash] = static_cast<int32_t>(ip);
+        if (ref < 0 || ip - ref > MAX_OFFSET || Load32(src + ref) != sequence) {
+            ip++;
+            continue;
+        }
+
+        size_t match_length = MIN_MATCH;
+        while (ip + match_length < src_size && src[ref + match_length] == src[ip + match_length]) {
+            match_length++;
+        }
+        if (!WriteSequence(src + anchor, ip - anchor, ip - ref, match_length, dst, dst_capacity, &dp)) {
+            return 0;
+        }
+        ip += match_length;
+        anchor = ip;
+    }
+
+    if (!WriteSequence(src + anchor, src_size - anchor, 0, 0, dst, dst_capacity, &dp)) {
+        return 0;
+    }
+    return dp;
+}
+
+bool PageCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) {
+    size_t sp = 0;
+    size_t dp = 0;
+    while (sp < src_size) {
+        uint8_t token = static_cast<uint8_t>(src[sp++]);
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !ReadLength(src, src_size, &sp, &literal_length)) {
+            return false;
+        }
+        if (sp + literal_length > src_size || dp + literal_length > dst_size) {
+            return false;
+        }
+        memcpy(dst + dp, src + sp, literal_length);
+        sp += literal_length;
+        dp += literal_length;
+        if (sp == src_size) {
+            // the last sequence
+            break;
+        }
+
+        if (sp + 2 > src_size) {
+            return false;
+        }
+        size_t offset = static_cast<uint8_t>(src[sp]) | (static_cast<size_t>(static_cast<uint8_t>(src[sp + 1])) << 8);
+        sp += 2;
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !ReadLength(src, src_size, &sp, &match_length)) {
+            return false;
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > dp || dp + match_length > dst_size) {
+            return false;
+        }
+        // match may overlap with the output, copy it byte by byte
+        for (size_t i = 0; i < match_length; i++) {
+            dst[dp + i] = dst[dp - offset + i];
+        }
+        dp += match_length;
+    }
+    return dp == dst_size;
+}
+
+}
+
+#endif
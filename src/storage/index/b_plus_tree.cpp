@@ -23,8 +23,9 @@ BPLUSTREE_TYPE::BPlusTree(std::string index_name, BufferPoolManager *buffer_pool
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      leaf_max_size_(leaf_max_size != 0 ? leaf_max_size : LeafPage::MaxSizeOf(buffer_pool_manager->GetPageSize())),
+      internal_max_size_(internal_max_size != 0 ? internal_max_size
+                                                : InternalPage::MaxSizeOf(buffer_pool_manager->GetPageSize())) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::IsEmpty() const {
@@ -65,7 +66,7 @@ bool BPLUSTREE_TYPE::Remove(const KeyType &key, BPlusTreeExecutionContext *conte
         TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(next_page != nullptr, "");
         next_page->WLatch();
 
-        BPlusTreePage *next_node = reinterpret_cast<BPlusTreePage *>(next_page);
+        BPlusTreePage *next_node = reinterpret_cast<BPlusTreePage *>(next_page->GetData());
         // both internal node and leaf node will coalesce when size < minSize
         if (next_node->GetSize() > next_node->GetMinSize()) {
             // safe, release all of the previous pages
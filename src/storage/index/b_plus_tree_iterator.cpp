@@ -78,6 +78,10 @@ bool BPLUSTREE_ITERATOR_TYPE::AdvanceHelper() {
             page_ = next_page;
             index_ = 0;
             key_ = leaf_page_->KeyAt(index_);
+            // read ahead along the sibling pointers, prefetcher only holds a single latch at a time
+            buffer_pool_manager_->PrefetchChain(leaf_page_->GetNextPageId(), READ_AHEAD_DEPTH, [](Page *page) {
+                return reinterpret_cast<LeafPage *> (page->GetData())->GetNextPageId();
+            });
             return true;
         }
         // !!! if we failed to acquire the latch, then we need to unpin next_page
@@ -98,6 +102,10 @@ bool BPLUSTREE_ITERATOR_TYPE::AdvanceHelper() {
         // transfer the ownership from FindHelper to me, which means i'm responsible to
         // release the lock on that page and unpin that page
         auto [page, index] = tree_->FindHelper(key_);
+        if (page == nullptr) {
+            // tree is emptied while we were not holding any latch, so we are reaching the end
+            return true;
+        }
         page_ = page;
         index_ = index;
         leaf_page_ = reinterpret_cast<LeafPage *> (page->GetData());
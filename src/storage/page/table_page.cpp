@@ -89,7 +89,7 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, std::function<bool(con
 
     if (log_manager != nullptr) {
         TINYDB_ASSERT(txn != nullptr, "txn context is null");
-        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::INSERT, RID(GetPageId(), slot_id), tuple);
+        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::INSERT, RID(GetPageId(), slot_id), &tuple);
         auto lsn = log_manager->AppendLogRecord(log);
         SetLSN(lsn);
         txn->SetPrevLSN(lsn);
@@ -147,7 +147,7 @@ bool TablePage::MarkDelete(const RID &rid, TransactionContext *txn, LogManager *
     if (log_manager != nullptr) {
         TINYDB_ASSERT(txn != nullptr, "txn context is null");
         Tuple dummy_tuple;
-        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, &dummy_tuple);
         auto lsn = log_manager->AppendLogRecord(log);
         SetLSN(lsn);
         txn->SetPrevLSN(lsn);
@@ -217,7 +217,7 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
 
     if (log_manager != nullptr) {
         TINYDB_ASSERT(txn != nullptr, "txn context is null");
-        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
+        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, old_tuple, &new_tuple);
         auto lsn = log_manager->AppendLogRecord(log);
         SetLSN(lsn);
         txn->SetPrevLSN(lsn);
@@ -245,7 +245,7 @@ void TablePage::ApplyDelete(const RID &rid, TransactionContext *txn, LogManager
     if (log_manager != nullptr) {
         TINYDB_ASSERT(txn != nullptr, "txn context is null");
         Tuple deleted_tuple = Tuple::DeserializeFrom(GetRawPointer() + tuple_offset, tuple_size);
-        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, deleted_tuple);
+        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, &deleted_tuple);
         auto lsn = log_manager->AppendLogRecord(log);
         SetLSN(lsn);
         txn->SetPrevLSN(lsn);
@@ -280,7 +280,7 @@ void TablePage::RollbackDelete(const RID &rid, TransactionContext *txn, LogManag
     if (log_manager != nullptr) {
         TINYDB_ASSERT(txn != nullptr, "txn context is null");
         Tuple dummy_tuple;
-        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+        auto log = LogRecord(txn->GetTxnId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, &dummy_tuple);
         auto lsn = log_manager->AppendLogRecord(log);
         SetLSN(lsn);
         txn->SetPrevLSN(lsn);
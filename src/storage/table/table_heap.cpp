@@ -18,7 +18,7 @@ namespace TinyDB {
 
 Result<> TableHeap::InsertTuple(const Tuple &tuple, RID *rid, TransactionContext *txn, const std::function<bool(const RID &)> &condition) {
     // we couldn't store it anyway
-    if (tuple.GetSize() + TablePage::SIZE_TABLE_PAGE_HEADER + TablePage::SIZE_SLOT > PAGE_SIZE) {
+    if (tuple.GetSize() + TablePage::SIZE_TABLE_PAGE_HEADER + TablePage::SIZE_SLOT > buffer_pool_manager_->GetPageSize()) {
         THROW_NOT_IMPLEMENTED_EXCEPTION("TinyDB Couldn't support very large tuple");
     }
 
@@ -56,7 +56,10 @@ Result<> TableHeap::InsertTuple(const Tuple &tuple, RID *rid, TransactionContext
             // initialize the new page
             new_page->WLatch();
             table_page->SetNextPageId(new_page->GetPageId());
-            new_table_page->Init(new_page->GetPageId(), PAGE_SIZE, cur_page->GetPageId(), txn, log_manager_);
+            new_table_page->Init(new_page->GetPageId(), buffer_pool_manager_->GetPageSize(), cur_page->GetPageId(), txn, log_manager_);
+            if (page_count_ != 0) {
+                page_count_++;
+            }
             // release the previous page
             cur_page->WUnlatch();
             // since we've modified the next page id, we need to flush it back to disk
@@ -167,20 +170,21 @@ Result<> TableHeap::GetTuple(const RID &rid, Tuple *tuple) {
     }
 }
 
-TableIterator TableHeap::Begin() {
+TableIterator TableHeap::Begin(std::shared_ptr<BufferAccessStrategy> strategy) {
     TINYDB_ASSERT(first_page_id_ != INVALID_PAGE_ID, "invalid table heap");
     // default is invalid RID
     RID rid;
-    auto cur_page = buffer_pool_manager_->FetchPage(first_page_id_);
+    auto cur_page = buffer_pool_manager_->FetchPage(first_page_id_, false, strategy.get());
     TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(cur_page != nullptr, "");
     // same logic as operator++ for table iterator
     cur_page->RLatch();
 
     auto table_page = reinterpret_cast<TablePage *> (cur_page->GetData());
+    ReadAhead(table_page, strategy);
 
     if (!table_page->GetFirstTupleRid(&rid)) {
         while (table_page->GetNextPageId() != INVALID_PAGE_ID) {
-            auto next_page = buffer_pool_manager_->FetchPage(table_page->GetNextPageId());
+            auto next_page = buffer_pool_manager_->FetchPage(table_page->GetNextPageId(), false, strategy.get());
             TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(next_page != nullptr, "");
 
             cur_page->RUnlatch();
@@ -189,6 +193,7 @@ TableIterator TableHeap::Begin() {
             cur_page->RLatch();
 
             table_page = reinterpret_cast<TablePage *> (cur_page->GetData());
+            ReadAhead(table_page, strategy);
             if (table_page->GetFirstTupleRid(&rid)) {
                 break;
             }
@@ -198,7 +203,15 @@ TableIterator TableHeap::Begin() {
 
     cur_page->RUnlatch();
     buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
-    return TableIterator(this, rid);
+    return TableIterator(this, rid, strategy);
+}
+
+void TableHeap::ReadAhead(TablePage *table_page, const std::shared_ptr<BufferAccessStrategy> &strategy) {
+    // pages after the next one are most likely in the pool already, since we've
+    // requested them when stepping onto previous pages. they are just pinned and unpinned
+    buffer_pool_manager_->PrefetchChain(table_page->GetNextPageId(), READ_AHEAD_DEPTH, [](Page *page) {
+        return reinterpret_cast<TablePage *> (page->GetData())->GetNextPageId();
+    }, strategy);
 }
 
 TableIterator TableHeap::End() {
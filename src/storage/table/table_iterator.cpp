@@ -47,7 +47,7 @@ TableIterator &TableIterator::operator++() {
     TINYDB_ASSERT(rid_.GetPageId() != INVALID_PAGE_ID, "logic error");
 
     BufferPoolManager *bpm = table_heap_->buffer_pool_manager_;
-    auto cur_page = bpm->FetchPage(rid_.GetPageId());
+    auto cur_page = bpm->FetchPage(rid_.GetPageId(), false, strategy_.get());
     // we should find a good way to handle out of memory issue here
     TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(cur_page != nullptr, "");
     cur_page->RLatch();
@@ -60,7 +60,7 @@ TableIterator &TableIterator::operator++() {
     if (!table_page->GetNextTupleRid(rid_, &next_tuple_rid)) {
         // if we at the end of this page, try to fetch next page
         while (table_page->GetNextPageId() != INVALID_PAGE_ID) {
-            auto next_page = bpm->FetchPage(table_page->GetNextPageId());
+            auto next_page = bpm->FetchPage(table_page->GetNextPageId(), false, strategy_.get());
             TINYDB_CHECK_OR_THROW_OUT_OF_MEMORY_EXCEPTION(cur_page != nullptr, "");
 
             cur_page->RUnlatch();
@@ -69,6 +69,7 @@ TableIterator &TableIterator::operator++() {
             cur_page->RLatch();
 
             table_page = reinterpret_cast<TablePage *> (cur_page->GetData());
+            table_heap_->ReadAhead(table_page, strategy_);
             if (table_page->GetFirstTupleRid(&next_tuple_rid)) {
                 break;
             }
@@ -1,5 +1,8 @@
 #include "storage/disk/disk_manager.h"
 #include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/page/page_header.h"
+#include "common/logger.h"
 
 #include <gtest/gtest.h>
 #include <string>
@@ -8,6 +11,9 @@
 #include <mutex>
 #include <thread>
 #include <vector>
+#include <set>
+#include <chrono>
+#include <algorithm>
 
 namespace TinyDB {
 
@@ -73,7 +79,7 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
     delete bpm;
     delete disk_manager;
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(BufferPoolManagerTest, ConcurrentTest) {
@@ -149,7 +155,763 @@ TEST(BufferPoolManagerTest, ConcurrentTest) {
     delete bpm;
     delete disk_manager;
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
-}
\ No newline at end of file
+TEST(BufferPoolManagerTest, ShardedConcurrentTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 32;
+    const size_t num_instances = 4;
+    const size_t worker_size = 6;
+    const size_t total_page_size = 40;
+    const size_t iteration_num = 10;
+    DiskManager::RemoveFiles(filename);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, num_instances);
+    EXPECT_EQ(bpm->GetPoolSize(), buffer_pool_size);
+    EXPECT_EQ(bpm->GetInstanceNum(), num_instances);
+
+    std::vector<page_id_t> page_list(total_page_size);
+    for (size_t i = 0; i < total_page_size; i++) {
+        EXPECT_NE(bpm->NewPage(&page_list[i]), nullptr);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+
+    std::vector<std::thread> worker_list;
+    for (size_t i = 0; i < worker_size; i++) {
+        worker_list.emplace_back(std::thread([&]() {
+            std::random_device rd;
+            std::mt19937 mt(rd());
+            std::vector<page_id_t> access_list = page_list;
+
+            for (size_t i = 0; i < iteration_num; i++) {
+                std::shuffle(access_list.begin(), access_list.end(), mt);
+                for (auto page_id : access_list) {
+                    auto page = bpm->FetchPage(page_id);
+                    ASSERT_NE(page, nullptr);
+                    ASSERT_EQ(page->GetPageId(), page_id);
+                    page->WLatch();
+                    int *counter = reinterpret_cast<int *> (page->GetData());
+                    *counter = *counter + 1;
+                    page->WUnlatch();
+                    bpm->UnpinPage(page_id, true);
+                }
+            }
+        }));
+    }
+
+    for (auto &worker : worker_list) {
+        worker.join();
+    }
+
+    for (auto page_id : page_list) {
+        auto page = bpm->FetchPage(page_id);
+        EXPECT_NE(page, nullptr);
+        EXPECT_EQ(*reinterpret_cast<int *> (page->GetData()), iteration_num * worker_size);
+        bpm->UnpinPage(page_id, false);
+    }
+    EXPECT_TRUE(bpm->CheckPinCount());
+
+    delete bpm;
+    delete disk_manager;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * a tiny pool with lots of misses. dirty victims are written back and
+ * pages are read without holding the latch, modification should never be lost
+ */
+TEST(BufferPoolManagerTest, ConcurrentMissTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 8;
+    const size_t worker_size = 4;
+    const size_t total_page_size = 32;
+    const size_t iteration_num = 10;
+    DiskManager::RemoveFiles(filename);
+
+    for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRUK}) {
+        auto disk_manager = new DiskManager(filename);
+        auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 1, replacer_type);
+
+        std::vector<page_id_t> page_list(total_page_size);
+        for (size_t i = 0; i < total_page_size; i++) {
+            EXPECT_NE(bpm->NewPage(&page_list[i]), nullptr);
+            EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+        }
+
+        std::vector<std::thread> worker_list;
+        for (size_t i = 0; i < worker_size; i++) {
+            worker_list.emplace_back(std::thread([&]() {
+                std::random_device rd;
+                std::mt19937 mt(rd());
+                std::vector<page_id_t> access_list = page_list;
+
+                for (size_t i = 0; i < iteration_num; i++) {
+                    std::shuffle(access_list.begin(), access_list.end(), mt);
+                    for (auto page_id : access_list) {
+                        auto page = bpm->FetchPage(page_id);
+                        ASSERT_NE(page, nullptr);
+                        ASSERT_EQ(page->GetPageId(), page_id);
+                        page->WLatch();
+                        int *counter = reinterpret_cast<int *> (page->GetData());
+                        *counter = *counter + 1;
+                        page->WUnlatch();
+                        bpm->UnpinPage(page_id, true);
+                    }
+                }
+            }));
+        }
+
+        for (auto &worker : worker_list) {
+            worker.join();
+        }
+
+        for (auto page_id : page_list) {
+            auto page = bpm->FetchPage(page_id);
+            EXPECT_NE(page, nullptr);
+            EXPECT_EQ(*reinterpret_cast<int *> (page->GetData()), iteration_num * worker_size);
+            bpm->UnpinPage(page_id, false);
+        }
+        EXPECT_TRUE(bpm->CheckPinCount());
+
+        delete bpm;
+        delete disk_manager;
+        DiskManager::RemoveFiles(filename);
+    }
+}
+
+/**
+ * @brief
+ * a bulk read should only recycle frames of it's own ring, and
+ * pages cached before the scan should stay in the same frames
+ */
+TEST(BufferPoolManagerTest, BulkReadStrategyTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 64;
+    const size_t hot_page_size = 16;
+    const size_t scan_page_size = 256;
+    DiskManager::RemoveFiles(filename);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+    std::vector<page_id_t> page_list(hot_page_size + scan_page_size);
+    for (size_t i = 0; i < page_list.size(); i++) {
+        auto page = bpm->NewPage(&page_list[i]);
+        ASSERT_NE(page, nullptr);
+        *reinterpret_cast<page_id_t *> (page->GetData()) = page_list[i];
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+    }
+    // start with an empty pool
+    bpm->FlushAllPages();
+    delete bpm;
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+    // bring hot pages in
+    std::vector<Page *> hot_frames;
+    for (size_t i = 0; i < hot_page_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        hot_frames.push_back(page);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+
+    // ring size is limited to 1/8 of the pool
+    BufferAccessStrategy strategy;
+    std::set<Page *> scan_frames;
+    for (size_t i = hot_page_size; i < page_list.size(); i++) {
+        auto page = bpm->FetchPage(page_list[i], false, &strategy);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(*reinterpret_cast<page_id_t *> (page->GetData()), page_list[i]);
+        scan_frames.insert(page);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_LE(scan_frames.size(), buffer_pool_size / 8);
+
+    for (size_t i = 0; i < hot_page_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        EXPECT_EQ(page, hot_frames[i]);
+        EXPECT_EQ(*reinterpret_cast<page_id_t *> (page->GetData()), page_list[i]);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_TRUE(bpm->CheckPinCount());
+
+    delete bpm;
+    delete disk_manager;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * page cleaner should write back dirty pages in background, so that misses
+ * can evict clean victims. modification should never be lost
+ */
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 16;
+    const size_t total_page_size = 64;
+    const size_t worker_size = 4;
+    const size_t iteration_num = 5;
+    DiskManager::RemoveFiles(filename);
+
+    // keep every evictable frame clean
+    auto old_ratio = PAGE_CLEANER_CLEAN_RATIO;
+    PAGE_CLEANER_CLEAN_RATIO = 1.0;
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+    std::vector<page_id_t> page_list(total_page_size);
+    for (size_t i = 0; i < total_page_size; i++) {
+        EXPECT_NE(bpm->NewPage(&page_list[i]), nullptr);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+    }
+
+    // dirty the last few pages, then wait for cleaner
+    for (size_t i = total_page_size - buffer_pool_size; i < total_page_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        *reinterpret_cast<int *> (page->GetData()) = 1;
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+    }
+    bpm->RunPageCleaner();
+    for (int retry = 0; retry < 200 && bpm->GetCleanerWriteCount() < buffer_pool_size; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GE(bpm->GetCleanerWriteCount(), buffer_pool_size);
+
+    // misses should evict clean pages now
+    auto foreground_write = bpm->GetForegroundWriteCount();
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_EQ(bpm->GetForegroundWriteCount(), foreground_write);
+    EXPECT_GE(bpm->GetAvoidedWriteCount(), buffer_pool_size);
+
+    // concurrent modification while cleaner is running
+    std::vector<std::thread> worker_list;
+    for (size_t i = 0; i < worker_size; i++) {
+        worker_list.emplace_back(std::thread([&]() {
+            std::random_device rd;
+            std::mt19937 mt(rd());
+            std::vector<page_id_t> access_list = page_list;
+
+            for (size_t i = 0; i < iteration_num; i++) {
+                std::shuffle(access_list.begin(), access_list.end(), mt);
+                for (auto page_id : access_list) {
+                    auto page = bpm->FetchPage(page_id);
+                    ASSERT_NE(page, nullptr);
+                    page->WLatch();
+                    int *counter = reinterpret_cast<int *> (page->GetData());
+                    *counter = *counter + 1;
+                    page->WUnlatch();
+                    bpm->UnpinPage(page_id, true);
+                }
+            }
+        }));
+    }
+    for (auto &worker : worker_list) {
+        worker.join();
+    }
+    bpm->StopPageCleaner();
+
+    for (size_t i = 0; i < total_page_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        int expected = iteration_num * worker_size + (i >= total_page_size - buffer_pool_size ? 1 : 0);
+        EXPECT_EQ(*reinterpret_cast<int *> (page->GetData()), expected);
+        bpm->UnpinPage(page_list[i], false);
+    }
+    EXPECT_TRUE(bpm->CheckPinCount());
+    LOG_INFO("%s", bpm->GetTimeConsumption().c_str());
+
+    delete bpm;
+    delete disk_manager;
+    PAGE_CLEANER_CLEAN_RATIO = old_ratio;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * page ids are reused after deletion, page cleaner should never write a deleted page
+ * over the next owner of it's id
+ */
+TEST(BufferPoolManagerTest, PageCleanerDeleteTest) {
+    const std::string filename = "test.db";
+    // stamp is placed after page header
+    const size_t stamp_offset = 64;
+    DiskManager::RemoveFiles(filename);
+
+    auto old_ratio = PAGE_CLEANER_CLEAN_RATIO;
+    auto old_interval = PAGE_CLEANER_INTERVAL;
+    PAGE_CLEANER_CLEAN_RATIO = 1.0;
+    PAGE_CLEANER_INTERVAL = std::chrono::milliseconds(1);
+
+    auto disk_manager = new DiskManager(filename);
+    auto log_manager = new LogManager(disk_manager);
+    auto bpm = new BufferPoolManager(2, disk_manager, log_manager);
+
+    auto append_log = [&]() {
+        auto log = LogRecord(0, INVALID_LSN, LogRecordType::BEGIN);
+        return log_manager->AppendLogRecord(log);
+    };
+    auto write_stamp = [&](Page *page, int version, lsn_t lsn) {
+        page->WLatch();
+        reinterpret_cast<PageHeader *>(page->GetData())->SetLSN(lsn);
+        *reinterpret_cast<int *>(page->GetData() + stamp_offset) = version;
+        page->WUnlatch();
+    };
+    // pages written with lsn 0 could be flushed right away
+    log_manager->Flush(append_log(), true);
+
+    // a page that lives on disk only
+    page_id_t disk_page_id;
+    auto page = bpm->NewPage(&disk_page_id);
+    ASSERT_NE(page, nullptr);
+    ASSERT_TRUE(bpm->UnpinPage(disk_page_id, true));
+    ASSERT_TRUE(bpm->FlushPage(disk_page_id));
+
+    // cleaner will block on log of this page after taking the snapshot
+    page_id_t page_id;
+    auto deleted_page = bpm->NewPage(&page_id);
+    ASSERT_NE(deleted_page, nullptr);
+    lsn_t future_lsn = append_log() + 4;
+    write_stamp(deleted_page, 1, future_lsn);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+
+    // evicts the disk page
+    page_id_t clean_page_id;
+    page = bpm->NewPage(&clean_page_id);
+    ASSERT_NE(page, nullptr);
+    ASSERT_TRUE(bpm->UnpinPage(clean_page_id, true));
+    ASSERT_TRUE(bpm->FlushPage(clean_page_id));
+
+    bpm->RunPageCleaner();
+    for (int retry = 0; retry < 1000 && deleted_page->IsDirty(); retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_FALSE(deleted_page->IsDirty());
+
+    // delete the page, then hand it's id to a page in another frame and write it back
+    while (!bpm->DeletePage(page_id)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_NE(bpm->FetchPage(disk_page_id), nullptr);
+    page_id_t new_page_id;
+    page = bpm->NewPage(&new_page_id);
+    ASSERT_NE(page, nullptr);
+    ASSERT_EQ(new_page_id, page_id);
+    write_stamp(page, 2, 0);
+    ASSERT_TRUE(bpm->UnpinPage(new_page_id, true));
+    ASSERT_TRUE(bpm->FlushPage(new_page_id));
+    ASSERT_TRUE(bpm->UnpinPage(disk_page_id, false));
+
+    // resume cleaner
+    while (append_log() < future_lsn) {}
+    log_manager->Flush(future_lsn, true);
+    bpm->StopPageCleaner();
+
+    std::vector<char> data(bpm->GetPageSize());
+    disk_manager->ReadPage(page_id, data.data());
+    EXPECT_EQ(*reinterpret_cast<int *>(data.data() + stamp_offset), 2);
+    EXPECT_TRUE(bpm->CheckPinCount());
+
+    // keep the other frame busy, so that frame of the deleted page is the only one to reuse
+    ASSERT_NE(bpm->FetchPage(disk_page_id), nullptr);
+    page_id_t held_page_id;
+    page = bpm->NewPage(&held_page_id);
+    ASSERT_NE(page, nullptr);
+    write_stamp(page, 3, 0);
+    page->WLatch();
+    ASSERT_TRUE(bpm->UnpinPage(held_page_id, true));
+
+    // cleaner pins the page and waits for the latch, then page is deleted under it.
+    // cleaner becomes the last user, it should carry out the deletion
+    bpm->RunPageCleaner();
+    for (int retry = 0; retry < 1000 && page->GetPinCount() == 0; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(page->GetPinCount(), 1);
+    EXPECT_FALSE(bpm->DeletePage(held_page_id));
+    page->WUnlatch();
+    bpm->StopPageCleaner();
+    EXPECT_FALSE(disk_manager->IsAllocated(held_page_id));
+
+    // the next page in that frame survives it's first unpin
+    page_id_t reused_page_id;
+    page = bpm->NewPage(&reused_page_id);
+    ASSERT_NE(page, nullptr);
+    write_stamp(page, 4, 0);
+    ASSERT_TRUE(bpm->UnpinPage(reused_page_id, true));
+    EXPECT_TRUE(disk_manager->IsAllocated(reused_page_id));
+    EXPECT_TRUE(bpm->FlushPage(reused_page_id));
+    ASSERT_TRUE(bpm->UnpinPage(disk_page_id, false));
+    EXPECT_TRUE(bpm->CheckPinCount());
+
+    delete bpm;
+    delete log_manager;
+    delete disk_manager;
+    PAGE_CLEANER_CLEAN_RATIO = old_ratio;
+    PAGE_CLEANER_INTERVAL = old_interval;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * prefetcher should bring the whole chain into the pool, so that scan never misses.
+ * read-ahead with a strategy is limited by the ring
+ */
+TEST(BufferPoolManagerTest, PrefetchTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 64;
+    const size_t chain_size = 16;
+    DiskManager::RemoveFiles(filename);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+
+    // build a chain of pages, every page stores it's own id and id of the next page
+    std::vector<page_id_t> page_list(chain_size * 2);
+    for (size_t i = 0; i < page_list.size(); i++) {
+        ASSERT_NE(bpm->NewPage(&page_list[i]), nullptr);
+    }
+    for (size_t i = 0; i < page_list.size(); i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        auto data = reinterpret_cast<page_id_t *> (page->GetData());
+        data[0] = page_list[i];
+        data[1] = (i + 1) % chain_size == 0 ? INVALID_PAGE_ID : page_list[i + 1];
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+    }
+    bpm->FlushAllPages();
+    delete bpm;
+    bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+
+    auto next_page_id = [](Page *page) {
+        return reinterpret_cast<page_id_t *> (page->GetData())[1];
+    };
+    auto wait_prefetch = [&](size_t count) {
+        for (int retry = 0; retry < 500 && bpm->GetPrefetchCount() < count; retry++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ(bpm->GetPrefetchCount(), count);
+    };
+
+    // the first chain is longer than depth, prefetcher stops at the end of the chain
+    bpm->PrefetchChain(page_list[0], chain_size * 2, next_page_id);
+    wait_prefetch(chain_size);
+    EXPECT_EQ(bpm->GetReadCount(), chain_size);
+    for (size_t i = 0; i < chain_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(*reinterpret_cast<page_id_t *> (page->GetData()), page_list[i]);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_EQ(bpm->GetReadCount(), chain_size);
+
+    // ring of every instance holds 4 frames and scan needs two of them,
+    // so we could read ahead two pages in every instance
+    auto strategy = std::make_shared<BufferAccessStrategy>(4);
+    bpm->PrefetchChain(page_list[chain_size], chain_size, next_page_id, strategy);
+    wait_prefetch(chain_size + 2 * 2);
+
+    // single page
+    bpm->Prefetch(page_list.back());
+    wait_prefetch(chain_size + 2 * 2 + 1);
+    EXPECT_EQ(bpm->GetReadCount(), chain_size + 2 * 2 + 1);
+
+    // garbage page ids are ignored, chain stops right after it's head
+    bpm->Prefetch(-5);
+    bpm->Prefetch(1 << 20);
+    bpm->PrefetchChain(page_list[0], 2, [](Page *) { return -5; });
+    bpm->PrefetchChain(page_list[0], 2, [](Page *) { return 1 << 20; });
+    wait_prefetch(chain_size + 2 * 2 + 1 + 2);
+    EXPECT_TRUE(bpm->CheckPinCount());
+    delete bpm;
+
+    // prefetcher never waits for a frame. every frame is pinned, so the chain
+    // is dropped and the next request is served right away
+    bpm = new BufferPoolManager(2, disk_manager);
+    auto old_timeout = FRAME_WAIT_TIMEOUT;
+    FRAME_WAIT_TIMEOUT = std::chrono::seconds(10);
+    ASSERT_NE(bpm->FetchPage(page_list[0]), nullptr);
+    ASSERT_NE(bpm->FetchPage(page_list[1]), nullptr);
+    auto start = std::chrono::steady_clock::now();
+    bpm->PrefetchChain(page_list[2], 2, next_page_id);
+    bpm->Prefetch(page_list[0]);
+    wait_prefetch(1);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, FRAME_WAIT_TIMEOUT);
+    EXPECT_EQ(bpm->UnpinPage(page_list[0], false), true);
+    EXPECT_EQ(bpm->UnpinPage(page_list[1], false), true);
+    EXPECT_TRUE(bpm->CheckPinCount());
+    FRAME_WAIT_TIMEOUT = old_timeout;
+
+    delete bpm;
+    delete disk_manager;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * when every frame is pinned, FetchPage/NewPage should wait for an unpinned frame,
+ * and give up after FRAME_WAIT_TIMEOUT
+ */
+TEST(BufferPoolManagerTest, FrameWaitTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 4;
+    DiskManager::RemoveFiles(filename);
+
+    auto old_timeout = FRAME_WAIT_TIMEOUT;
+    FRAME_WAIT_TIMEOUT = std::chrono::milliseconds(50);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+    std::vector<page_id_t> page_list(buffer_pool_size + 1);
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        ASSERT_NE(bpm->NewPage(&page_list[i]), nullptr);
+    }
+
+    // nobody is going to unpin
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(bpm->NewPage(&page_list[buffer_pool_size]), nullptr);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, FRAME_WAIT_TIMEOUT);
+    EXPECT_EQ(bpm->GetFrameWaitCount(), 1);
+
+    // waiter should be woken up once a frame is unpinned
+    FRAME_WAIT_TIMEOUT = std::chrono::seconds(10);
+    std::thread waiter([&] {
+        auto page = bpm->FetchPage(page_list[0] + 100);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(bpm->UnpinPage(page_list[0] + 100, false), true);
+    });
+    for (int retry = 0; retry < 500 && bpm->GetFrameWaiterCount() == 0; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(bpm->GetFrameWaiterCount(), 1);
+    EXPECT_EQ(bpm->UnpinPage(page_list[0], false), true);
+    waiter.join();
+    EXPECT_EQ(bpm->GetFrameWaiterCount(), 0);
+    LOG_INFO("%s", bpm->GetTimeConsumption().c_str());
+
+    for (size_t i = 1; i < buffer_pool_size; i++) {
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_TRUE(bpm->CheckPinCount());
+
+    delete bpm;
+    delete disk_manager;
+    FRAME_WAIT_TIMEOUT = old_timeout;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * grow and shrink the buffer pool while pages are pinned and dirty
+ */
+TEST(BufferPoolManagerTest, ResizeTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 8;
+    const size_t max_pool_size = 16;
+    DiskManager::RemoveFiles(filename);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2, ReplacerType::LRU, max_pool_size);
+    EXPECT_EQ(bpm->GetMaxPoolSize(), max_pool_size);
+    EXPECT_GE(BufferPoolManager::GetDefaultPoolSize(), MIN_BUFFER_POOL_SIZE);
+
+    std::vector<page_id_t> page_list(max_pool_size);
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        ASSERT_NE(bpm->NewPage(&page_list[i]), nullptr);
+    }
+
+    // grow, and fill the new frames
+    EXPECT_EQ(bpm->Resize(max_pool_size), 0);
+    EXPECT_EQ(bpm->GetPoolSize(), max_pool_size);
+    for (size_t i = buffer_pool_size; i < max_pool_size; i++) {
+        ASSERT_NE(bpm->NewPage(&page_list[i]), nullptr);
+    }
+    for (size_t i = 0; i < max_pool_size; i++) {
+        *reinterpret_cast<page_id_t *> (bpm->FetchPage(page_list[i])->GetData()) = page_list[i];
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+    }
+
+    // every frame is pinned, they will be retired after they are unpinned
+    EXPECT_EQ(bpm->Resize(buffer_pool_size / 2), max_pool_size - buffer_pool_size / 2);
+    EXPECT_EQ(bpm->GetPoolSize(), buffer_pool_size / 2);
+    for (size_t i = 0; i < max_pool_size; i++) {
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_EQ(bpm->Resize(buffer_pool_size / 2), 0);
+
+    // dirty pages should be written back before their frames are retired
+    auto read_count = bpm->GetReadCount();
+    for (size_t i = 0; i < max_pool_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(*reinterpret_cast<page_id_t *> (page->GetData()), page_list[i]);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+    EXPECT_GE(bpm->GetReadCount() - read_count, max_pool_size - buffer_pool_size / 2);
+
+    // shrink with unpinned pages, then grow back
+    EXPECT_EQ(bpm->Resize(2), 0);
+    EXPECT_EQ(bpm->Resize(max_pool_size), 0);
+    for (size_t i = 0; i < max_pool_size; i++) {
+        auto page = bpm->FetchPage(page_list[i]);
+        ASSERT_NE(page, nullptr);
+        EXPECT_EQ(*reinterpret_cast<page_id_t *> (page->GetData()), page_list[i]);
+    }
+    for (size_t i = 0; i < max_pool_size; i++) {
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+    }
+
+    // grow while shrinking is writing dirty frames back, frames back in service shouldn't be retired
+    for (int round = 0; round < 20; round++) {
+        for (size_t i = 0; i < max_pool_size; i++) {
+            ASSERT_NE(bpm->FetchPage(page_list[i]), nullptr);
+            EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+        }
+        std::thread shrinker([&] { bpm->Resize(2); });
+        std::thread grower([&] { bpm->Resize(max_pool_size); });
+        shrinker.join();
+        grower.join();
+        EXPECT_EQ(bpm->Resize(max_pool_size), 0);
+        for (size_t i = 0; i < max_pool_size; i++) {
+            ASSERT_NE(bpm->FetchPage(page_list[i]), nullptr);
+        }
+        for (size_t i = 0; i < max_pool_size; i++) {
+            EXPECT_EQ(bpm->UnpinPage(page_list[i], false), true);
+        }
+    }
+    EXPECT_TRUE(bpm->CheckPinCount());
+
+    delete bpm;
+    delete disk_manager;
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * resident pages dumped on shutdown should be loaded on startup,
+ * so that hot pages won't miss after restart
+ */
+TEST(BufferPoolManagerTest, WarmRestartTest) {
+    const std::string filename = "test.db";
+    const std::string dump_filename = "test.dump";
+    const size_t buffer_pool_size = 16;
+    const size_t total_page_size = 64;
+    DiskManager::RemoveFiles(filename);
+    remove(dump_filename.c_str());
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+    EXPECT_EQ(bpm->LoadPages(dump_filename), 0);
+    bpm->RunPageDumper(dump_filename);
+
+    std::vector<page_id_t> page_list(total_page_size);
+    for (size_t i = 0; i < total_page_size; i++) {
+        ASSERT_NE(bpm->NewPage(&page_list[i]), nullptr);
+        *reinterpret_cast<page_id_t *> (bpm->FetchPage(page_list[i])->GetData()) = page_list[i];
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+        EXPECT_EQ(bpm->UnpinPage(page_list[i], true), true);
+    }
+    // touch some random pages, they should be resident after restart
+    std::vector<page_id_t> hot_pages = {page_list[3], page_list[7], page_list[20], page_list[42], page_list[61]};
+    for (auto page_id : hot_pages) {
+        ASSERT_NE(bpm->FetchPage(page_id), nullptr);
+        EXPECT_EQ(bpm->UnpinPage(page_id, false), true);
+    }
+    bpm->FlushAllPages();
+    // pages are dumped on shutdown
+    delete bpm;
+
+    for (bool wait : {true, false}) {
+        bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, 2);
+        EXPECT_EQ(bpm->LoadPages(dump_filename, wait), buffer_pool_size);
+        for (int retry = 0; retry < 500 && bpm->GetReadCount() < buffer_pool_size; retry++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_EQ(bpm->GetReadCount(), buffer_pool_size);
+
+        for (auto page_id : hot_pages) {
+            auto page = bpm->FetchPage(page_id);
+            ASSERT_NE(page, nullptr);
+            EXPECT_EQ(*reinterpret_cast<page_id_t *> (page->GetData()), page_id);
+            EXPECT_EQ(bpm->UnpinPage(page_id, false), true);
+        }
+        EXPECT_EQ(bpm->GetReadCount(), buffer_pool_size);
+        EXPECT_TRUE(bpm->CheckPinCount());
+        delete bpm;
+    }
+
+    delete disk_manager;
+    DiskManager::RemoveFiles(filename);
+    remove(dump_filename.c_str());
+}
+
+/**
+ * @brief
+ * compare the throughput of cached FetchPage/UnpinPage with single latch
+ * and with sharded buffer pool, from 1 thread to 32 threads.
+ * it's opt-in, run it with --gtest_also_run_disabled_tests
+ */
+TEST(BufferPoolManagerTest, DISABLED_ScalingBenchmark) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 128;
+    const size_t total_page_size = 64;
+    const size_t op_per_thread = 5000;
+    DiskManager::RemoveFiles(filename);
+
+    for (size_t num_instances : {1, 16}) {
+        auto disk_manager = new DiskManager(filename);
+        auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, num_instances);
+
+        std::vector<page_id_t> page_list(total_page_size);
+        for (size_t i = 0; i < total_page_size; i++) {
+            EXPECT_NE(bpm->NewPage(&page_list[i]), nullptr);
+            bpm->UnpinPage(page_list[i], false);
+        }
+
+        for (size_t thread_num = 1; thread_num <= 32; thread_num *= 2) {
+            std::vector<std::thread> worker_list;
+            auto t1 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < thread_num; i++) {
+                worker_list.emplace_back(std::thread([&, i]() {
+                    std::mt19937 mt(i);
+                    std::uniform_int_distribution<size_t> dis(0, total_page_size - 1);
+                    for (size_t j = 0; j < op_per_thread; j++) {
+                        auto page_id = page_list[dis(mt)];
+                        auto page = bpm->FetchPage(page_id);
+                        ASSERT_NE(page, nullptr);
+                        bpm->UnpinPage(page_id, false);
+                    }
+                }));
+            }
+            for (auto &worker : worker_list) {
+                worker.join();
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            LOG_INFO("instances: %lu, threads: %2lu, throughput: %.2f Mops/s",
+                     num_instances, thread_num, static_cast<double>(thread_num * op_per_thread) / std::max<long>(us, 1));
+        }
+        EXPECT_TRUE(bpm->CheckPinCount());
+
+        delete bpm;
+        delete disk_manager;
+        DiskManager::RemoveFiles(filename);
+    }
+}
+
+}
@@ -0,0 +1,211 @@
+/**
+ * @file clock_replacer_test.cpp
+ * @author sheep
+ * @brief unit test for clock replacer
+ * @version 0.1
+ * @date 2022-06-24
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/logger.h"
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace TinyDB {
+
+TEST(ClockReplacerTest, SimpleTest) {
+    auto clock = ClockReplacer(7);
+
+    clock.Unpin(1);
+    clock.Unpin(2);
+    clock.Unpin(3);
+    clock.Unpin(4);
+    clock.Unpin(5);
+    clock.Unpin(6);
+    clock.Unpin(1);
+    EXPECT_EQ(6, clock.Size());
+
+    // every frame is referenced, so the first round only clears reference bits
+    int value;
+    clock.Evict(&value);
+    EXPECT_EQ(1, value);
+    clock.Evict(&value);
+    EXPECT_EQ(2, value);
+    clock.Evict(&value);
+    EXPECT_EQ(3, value);
+
+    // since 3 is evicted, so pin 3 should have no effect
+    clock.Pin(3);
+    clock.Pin(4);
+    EXPECT_EQ(2, clock.Size());
+
+    clock.Unpin(4);
+
+    // 4 gets a second chance since we have used it recently
+    clock.Evict(&value);
+    EXPECT_EQ(5, value);
+    clock.Evict(&value);
+    EXPECT_EQ(6, value);
+    clock.Evict(&value);
+    EXPECT_EQ(4, value);
+
+    EXPECT_EQ(false, clock.Evict(&value));
+    EXPECT_EQ(0, clock.Size());
+}
+
+TEST(ClockReplacerTest, SecondChanceTest) {
+    auto clock = ClockReplacer(4);
+    int value;
+
+    for (int i = 0; i < 4; i++) {
+        clock.Unpin(i);
+    }
+    // clear all the reference bits, and evict 0
+    clock.Evict(&value);
+    EXPECT_EQ(0, value);
+
+    // touch 1 and 2, 3 should be the next victim
+    clock.Pin(1);
+    clock.Unpin(1);
+    clock.Pin(2);
+    clock.Unpin(2);
+    clock.Evict(&value);
+    EXPECT_EQ(3, value);
+
+    clock.Unpin(0);
+    EXPECT_EQ(3, clock.Size());
+    clock.Evict(&value);
+    EXPECT_EQ(1, value);
+}
+
+namespace {
+
+/**
+ * @brief
+ * replay the access trace on a simulated pool, every access is a pin/unpin pair
+ * @return number of hits
+ */
+size_t ReplayTrace(Replacer *replacer, size_t pool_size, const std::vector<page_id_t> &trace) {
+    std::unordered_map<page_id_t, frame_id_t> page_table;
+    std::vector<page_id_t> frames;
+    size_t hit = 0;
+    for (auto page_id : trace) {
+        frame_id_t frame_id;
+        auto it = page_table.find(page_id);
+        if (it != page_table.end()) {
+            hit++;
+            frame_id = it->second;
+            replacer->Pin(frame_id);
+        } else if (frames.size() < pool_size) {
+            frame_id = static_cast<frame_id_t>(frames.size());
+            frames.push_back(page_id);
+        } else {
+            EXPECT_TRUE(replacer->Evict(&frame_id));
+            page_table.erase(frames[frame_id]);
+            frames[frame_id] = page_id;
+        }
+        page_table[page_id] = frame_id;
+        replacer->Unpin(frame_id);
+    }
+    return hit;
+}
+
+}
+
+/**
+ * @brief
+ * compare hit rate and cost per access of lru and clock.
+ * it's opt-in, run it with --gtest_also_run_disabled_tests
+ */
+TEST(ClockReplacerTest, DISABLED_Benchmark) {
+    const size_t pool_size = 256;
+    const size_t total_page_size = 1024;
+    const size_t access_num = 200000;
+
+    std::mt19937 mt(0);
+    // 80% of accesses go to 20% of pages
+    std::vector<page_id_t> skewed;
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> hot(0, total_page_size / 5 - 1);
+    std::uniform_int_distribution<int> cold(total_page_size / 5, total_page_size - 1);
+    for (size_t i = 0; i < access_num; i++) {
+        skewed.push_back(percent(mt) < 80 ? hot(mt) : cold(mt));
+    }
+    // hot pages mixed with sequential scans that are larger than the pool
+    std::vector<page_id_t> scan;
+    for (size_t i = 0; i < access_num; i++) {
+        scan.push_back(i % 2 == 0 ? hot(mt) : static_cast<page_id_t>(total_page_size + (i / 2) % (pool_size * 2)));
+    }
+
+    for (auto &[name, trace] : {std::make_pair("skewed", &skewed), std::make_pair("scan", &scan)}) {
+        for (auto type : {ReplacerType::LRU, ReplacerType::CLOCK}) {
+            std::unique_ptr<Replacer> replacer;
+            if (type == ReplacerType::LRU) {
+                replacer = std::make_unique<LRUReplacer>(pool_size);
+            } else {
+                replacer = std::make_unique<ClockReplacer>(pool_size);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto hit = ReplayTrace(replacer.get(), pool_size, *trace);
+            auto end = std::chrono::steady_clock::now();
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            LOG_INFO("%s trace, %s replacer: hit rate %.3f, %.1f ns/access", name,
+                     type == ReplacerType::LRU ? "lru" : "clock",
+                     static_cast<double>(hit) / trace->size(), static_cast<double>(ns) / trace->size());
+        }
+    }
+
+    // pin/unpin pair on a resident frame, which is the hot path of buffer pool
+    for (auto type : {ReplacerType::LRU, ReplacerType::CLOCK}) {
+        std::unique_ptr<Replacer> replacer;
+        if (type == ReplacerType::LRU) {
+            replacer = std::make_unique<LRUReplacer>(pool_size);
+        } else {
+            replacer = std::make_unique<ClockReplacer>(pool_size);
+        }
+        for (size_t i = 0; i < pool_size; i++) {
+            replacer->Unpin(i);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < access_num; i++) {
+            replacer->Pin(i % pool_size);
+            replacer->Unpin(i % pool_size);
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        LOG_INFO("%s replacer: %.1f ns per pin/unpin", type == ReplacerType::LRU ? "lru" : "clock",
+                 static_cast<double>(ns) / access_num);
+    }
+}
+
+TEST(ClockReplacerTest, HotFramesTest) {
+    auto clock = ClockReplacer(4);
+    int value;
+
+    for (int i = 0; i < 4; i++) {
+        clock.Unpin(i);
+    }
+    // clear all the reference bits and evict 0, hand stops at 1
+    clock.Evict(&value);
+    EXPECT_EQ(0, value);
+    clock.Unpin(0);
+    clock.Pin(2);
+    clock.Unpin(2);
+
+    // referenced frames first, then the ones hand reaches last
+    EXPECT_EQ(clock.GetHotFrames(), std::vector<frame_id_t>({0, 2, 3, 1}));
+}
+
+}
@@ -0,0 +1,43 @@
+/**
+ * @file frame_arena_test.cpp
+ * @author sheep
+ * @brief unit test for frame arena
+ * @version 0.1
+ * @date 2022-06-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace TinyDB {
+
+TEST(FrameArenaTest, SimpleTest) {
+    // small arena, and one large enough for huge pages
+    for (size_t frame_num : {10, 1024}) {
+        FrameArena arena(frame_num);
+        EXPECT_TRUE(arena.IsMapped());
+        for (size_t i = 0; i < frame_num; i++) {
+            auto frame = arena.GetFrame(i);
+            // frames are page aligned and zeroed
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(frame) % PAGE_SIZE, 0);
+            EXPECT_EQ(frame[0], 0);
+            EXPECT_EQ(frame[PAGE_SIZE - 1], 0);
+            memset(frame, static_cast<int>(i % 128), PAGE_SIZE);
+        }
+        // frames don't overlap
+        for (size_t i = 0; i < frame_num; i++) {
+            auto frame = arena.GetFrame(i);
+            EXPECT_EQ(frame[0], static_cast<char>(i % 128));
+            EXPECT_EQ(frame[PAGE_SIZE - 1], static_cast<char>(i % 128));
+        }
+    }
+}
+
+}
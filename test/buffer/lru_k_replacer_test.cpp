@@ -0,0 +1,201 @@
+/**
+ * @file lru_k_replacer_test.cpp
+ * @author sheep
+ * @brief unit test for lru-k replacer
+ * @version 0.1
+ * @date 2022-06-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/logger.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace TinyDB {
+
+TEST(LRUKReplacerTest, SimpleTest) {
+    auto lru_k = LRUKReplacer(8, 2);
+
+    // frames are brought in and accessed once
+    for (int i = 1; i <= 6; i++) {
+        lru_k.Unpin(i);
+    }
+    EXPECT_EQ(6, lru_k.Size());
+
+    // 1 and 2 are accessed again, they have history now
+    lru_k.Pin(1);
+    lru_k.Unpin(1);
+    lru_k.Pin(2);
+    lru_k.Unpin(2);
+
+    // frames touched only once go first, in lru order
+    int value;
+    lru_k.Evict(&value);
+    EXPECT_EQ(3, value);
+    lru_k.Evict(&value);
+    EXPECT_EQ(4, value);
+
+    // pinned frame can't be evicted
+    lru_k.Pin(5);
+    lru_k.Evict(&value);
+    EXPECT_EQ(6, value);
+    EXPECT_EQ(2, lru_k.Size());
+
+    // 5 has two accesses now. 1 has the oldest second-to-last access
+    lru_k.Unpin(5);
+    lru_k.Evict(&value);
+    EXPECT_EQ(1, value);
+    lru_k.Evict(&value);
+    EXPECT_EQ(2, value);
+    lru_k.Evict(&value);
+    EXPECT_EQ(5, value);
+
+    EXPECT_EQ(false, lru_k.Evict(&value));
+    EXPECT_EQ(0, lru_k.Size());
+}
+
+TEST(LRUKReplacerTest, EvictionResetsHistoryTest) {
+    auto lru_k = LRUKReplacer(4, 2);
+    int value;
+
+    lru_k.Unpin(0);
+    lru_k.Pin(0);
+    lru_k.Unpin(0);
+    lru_k.Unpin(1);
+    lru_k.Evict(&value);
+    EXPECT_EQ(1, value);
+
+    // frame 0 is reused by another page, which has no history
+    lru_k.Evict(&value);
+    EXPECT_EQ(0, value);
+    lru_k.Unpin(0);
+    lru_k.Unpin(2);
+    lru_k.Pin(2);
+    lru_k.Unpin(2);
+    lru_k.Evict(&value);
+    EXPECT_EQ(0, value);
+}
+
+TEST(LRUKReplacerTest, CorrelatedPeriodTest) {
+    // accesses within 3 ticks are considered as one
+    auto lru_k = LRUKReplacer(4, 2, 3);
+    int value;
+
+    // frame 0 is touched twice in a row, which doesn't give it history
+    lru_k.Unpin(0);
+    lru_k.Pin(0);
+    lru_k.Unpin(0);
+    lru_k.Unpin(1);
+    lru_k.Unpin(2);
+    lru_k.Unpin(3);
+
+    // 2 and 3 are still in correlated period, so 0 and 1 go first in lru order
+    lru_k.Evict(&value);
+    EXPECT_EQ(0, value);
+    lru_k.Evict(&value);
+    EXPECT_EQ(1, value);
+    lru_k.Evict(&value);
+    EXPECT_EQ(2, value);
+    lru_k.Evict(&value);
+    EXPECT_EQ(3, value);
+}
+
+/**
+ * @brief
+ * hot pages are accessed repeatedly, then a large scan comes.
+ * lru-k should keep hot pages in the pool
+ */
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+    const size_t pool_size = 64;
+    const size_t hot_page_size = 32;
+    const size_t scan_page_size = 1024;
+
+    for (int use_lru_k = 0; use_lru_k < 2; use_lru_k++) {
+        std::unique_ptr<Replacer> replacer;
+        if (use_lru_k) {
+            replacer = std::make_unique<LRUKReplacer>(pool_size, 2);
+        } else {
+            replacer = std::make_unique<LRUReplacer>(pool_size);
+        }
+
+        std::unordered_map<page_id_t, frame_id_t> page_table;
+        std::vector<page_id_t> frames;
+        size_t hit = 0;
+        size_t total = 0;
+        auto access = [&](page_id_t page_id) {
+            total++;
+            frame_id_t frame_id;
+            auto it = page_table.find(page_id);
+            if (it != page_table.end()) {
+                hit++;
+                frame_id = it->second;
+                replacer->Pin(frame_id);
+            } else if (frames.size() < pool_size) {
+                frame_id = static_cast<frame_id_t>(frames.size());
+                frames.push_back(page_id);
+            } else {
+                EXPECT_TRUE(replacer->Evict(&frame_id));
+                page_table.erase(frames[frame_id]);
+                frames[frame_id] = page_id;
+            }
+            page_table[page_id] = frame_id;
+            replacer->Unpin(frame_id);
+        };
+
+        // warm up
+        for (int round = 0; round < 4; round++) {
+            for (size_t i = 0; i < hot_page_size; i++) {
+                access(i);
+            }
+        }
+        // scan, interleaved with hot pages. reuse distance of hot pages
+        // is larger than pool size, so lru will evict them
+        for (size_t i = 0; i < scan_page_size; i++) {
+            access(hot_page_size + i);
+            if (i % 4 == 0) {
+                access((i / 4) % hot_page_size);
+            }
+        }
+
+        // count hot pages that survived the scan
+        size_t resident = 0;
+        for (size_t i = 0; i < hot_page_size; i++) {
+            resident += page_table.count(i);
+        }
+        LOG_INFO("%s replacer: hit rate %.3f, %lu/%lu hot pages survived the scan", use_lru_k ? "lru-k" : "lru",
+                 static_cast<double>(hit) / total, resident, hot_page_size);
+        if (use_lru_k) {
+            EXPECT_EQ(resident, hot_page_size);
+        }
+    }
+}
+
+TEST(LRUKReplacerTest, HotFramesTest) {
+    auto lru_k = LRUKReplacer(8, 2);
+    for (int i = 0; i < 6; i++) {
+        lru_k.Unpin(i);
+    }
+    // frames with history are hotter than frames accessed only once
+    lru_k.Pin(1);
+    lru_k.Unpin(1);
+    lru_k.Pin(3);
+    lru_k.Unpin(3);
+    lru_k.Pin(4);
+
+    auto hot_frames = lru_k.GetHotFrames();
+    EXPECT_EQ(hot_frames, std::vector<frame_id_t>({3, 1, 5, 2, 0}));
+    for (auto it = hot_frames.rbegin(); it != hot_frames.rend(); ++it) {
+        int value;
+        EXPECT_TRUE(lru_k.Evict(&value));
+        EXPECT_EQ(*it, value);
+    }
+}
+
+}
@@ -13,6 +13,8 @@
 
 #include "buffer/lru_replacer.h"
 
+#include <vector>
+
 namespace TinyDB {
 
 /**
@@ -105,4 +107,23 @@ TEST(LRUReplacerTest, SimpleTest2) {
     EXPECT_EQ(false, lru.Evict(&value));
 }
 
-}
\ No newline at end of file
+TEST(LRUReplacerTest, HotFramesTest) {
+    auto lru = LRUReplacer(8);
+    for (int i = 0; i < 6; i++) {
+        lru.Unpin(i);
+    }
+    lru.Pin(2);
+    lru.Unpin(2);
+    lru.Pin(4);
+
+    // hottest first, it's the reverse of eviction order
+    auto hot_frames = lru.GetHotFrames();
+    EXPECT_EQ(hot_frames, std::vector<frame_id_t>({2, 5, 3, 1, 0}));
+    for (auto it = hot_frames.rbegin(); it != hot_frames.rend(); ++it) {
+        int value;
+        EXPECT_TRUE(lru.Evict(&value));
+        EXPECT_EQ(*it, value);
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+/**
+ * @file page_table_test.cpp
+ * @author sheep
+ * @brief unit test for page table
+ * @version 0.1
+ * @date 2022-06-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "buffer/page_table.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace TinyDB {
+
+TEST(PageTableTest, SimpleTest) {
+    PageTable table(16);
+
+    for (int i = 0; i < 16; i++) {
+        table.Insert(i * 7, i);
+    }
+    EXPECT_EQ(16, table.Size());
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(i, table.Find(i * 7));
+    }
+    EXPECT_EQ(INVALID_FRAME_ID, table.Find(1));
+    EXPECT_EQ(INVALID_FRAME_ID, table.Find(INVALID_PAGE_ID));
+
+    // remove half of them
+    for (int i = 0; i < 16; i += 2) {
+        EXPECT_TRUE(table.Erase(i * 7));
+    }
+    EXPECT_FALSE(table.Erase(0));
+    EXPECT_EQ(8, table.Size());
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(i % 2 == 0 ? INVALID_FRAME_ID : i, table.Find(i * 7));
+    }
+}
+
+TEST(PageTableTest, ChurnTest) {
+    // keep replacing entries, tombstones should be cleared by rebuilding
+    PageTable table(8);
+    for (int round = 0; round < 1000; round++) {
+        table.Insert(round, round % 8);
+        if (round >= 8) {
+            EXPECT_TRUE(table.Erase(round - 8));
+        }
+        EXPECT_EQ(round % 8, table.Find(round));
+    }
+    EXPECT_EQ(8, table.Size());
+    for (int i = 992; i < 1000; i++) {
+        EXPECT_EQ(i % 8, table.Find(i));
+    }
+}
+
+TEST(PageTableTest, ConcurrentReadTest) {
+    // a single writer is moving the entries around, while readers should
+    // only see the correct frame id, or a miss
+    const int num = 32;
+    PageTable table(num);
+    for (int i = 0; i < num; i++) {
+        table.Insert(i, i);
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                for (int i = 0; i < num; i++) {
+                    auto frame_id = table.Find(i);
+                    EXPECT_TRUE(frame_id == INVALID_FRAME_ID || frame_id == i);
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 2000; round++) {
+        int page_id = round % num;
+        table.Erase(page_id);
+        table.Insert(page_id, page_id);
+    }
+    stop.store(true);
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    for (int i = 0; i < num; i++) {
+        EXPECT_EQ(i, table.Find(i));
+    }
+}
+
+}
@@ -10,6 +10,7 @@
  */
 
 #include "catalog/catalog.h"
+#include "type/value_factory.h"
 
 #include <gtest/gtest.h>
 
@@ -18,7 +19,7 @@ namespace TinyDB {
 TEST(CatalogTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -55,7 +56,73 @@ TEST(CatalogTest, BasicTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
-}
\ No newline at end of file
+/**
+ * @brief
+ * tables and indexes are cached in the buffer pool they are assigned to
+ */
+TEST(CatalogTest, BufferPoolTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 50;
+    const size_t index_pool_size = 20;
+    DiskManager::RemoveFiles(filename);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    auto index_bpm = new BufferPoolManager(index_pool_size, disk_manager);
+
+    auto colA = Column("colA", TypeId::BIGINT);
+    std::vector<Column> cols;
+    cols.push_back(colA);
+    auto table_schema = Schema(cols);
+    std::vector<uint32_t> key_attrs = {0};
+
+    auto catalog = Catalog(bpm);
+    catalog.RegisterBufferPool("index", index_bpm);
+    EXPECT_EQ(catalog.GetBufferPool(DEFAULT_BUFFER_POOL), bpm);
+    EXPECT_EQ(catalog.GetBufferPool("index"), index_bpm);
+    EXPECT_EQ(catalog.GetBufferPool("bulk"), nullptr);
+
+    // pool should be registered before it's used
+    EXPECT_EQ(catalog.CreateTable("bulk_table", table_schema, nullptr, "bulk"), nullptr);
+    EXPECT_EQ(catalog.GetTable("bulk_table"), nullptr);
+
+    auto table = catalog.CreateTable("table", table_schema);
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(table->pool_name_, DEFAULT_BUFFER_POOL);
+    EXPECT_EQ(table->bpm_, bpm);
+    for (int64_t i = 0; i < 100; i++) {
+        std::vector<Value> values{ValueFactory::GetBigintValue(i)};
+        RID rid;
+        EXPECT_TRUE(table->table_->InsertTuple(Tuple(values, &table_schema), &rid).IsOk());
+    }
+
+    auto hit_count = index_bpm->GetHitCount();
+    auto index = catalog.CreateIndex("index", "table", table_schema, key_attrs, IndexType::BPlusTreeType, 8, "index");
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->pool_name_, "index");
+    EXPECT_EQ(index->bpm_, index_bpm);
+    EXPECT_EQ(catalog.CreateIndex("index2", "table", table_schema, key_attrs, IndexType::BPlusTreeType, 8, "bulk"),
+              nullptr);
+    // building the index touches pages of the index pool only
+    EXPECT_GT(index_bpm->GetHitCount(), hit_count);
+
+    auto stats = catalog.GetBufferPoolStats();
+    ASSERT_EQ(stats.size(), 2);
+    for (const auto &stat : stats) {
+        auto pool = catalog.GetBufferPool(stat.name_);
+        ASSERT_NE(pool, nullptr);
+        EXPECT_EQ(stat.pool_size_, pool->GetPoolSize());
+        EXPECT_EQ(stat.hit_count_, pool->GetHitCount());
+        EXPECT_EQ(stat.miss_count_, pool->GetMissCount());
+    }
+
+    delete index_bpm;
+    delete bpm;
+    delete disk_manager;
+    DiskManager::RemoveFiles(filename);
+}
+
+}
@@ -148,7 +148,7 @@ bool PerformWrite(ExecutionContext *context, int from, int to, int money, bool e
 TEST(TwoPhaseLockingTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -234,7 +234,7 @@ TEST(TwoPhaseLockingTest, BasicTest) {
     }
     LOG_INFO("Commit %d abort %d", commit_num.load(), iteration_num * worker_num - commit_num.load());
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
     delete txn_manager;
     delete disk_manager;
     delete bpm;
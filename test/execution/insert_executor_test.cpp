@@ -21,7 +21,7 @@ namespace TinyDB {
 TEST(InsertExecutorTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -93,13 +93,13 @@ TEST(InsertExecutorTest, BasicTest) {
     delete scan_executor;
     delete bpm;
     delete disk_manager;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(InsertExecutorTest, BasicTest2) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -194,7 +194,7 @@ TEST(InsertExecutorTest, BasicTest2) {
 
     delete bpm;
     delete disk_manager;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 }
\ No newline at end of file
@@ -28,7 +28,7 @@ namespace TinyDB {
 TEST(UpdateExecutorTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -157,7 +157,7 @@ TEST(UpdateExecutorTest, BasicTest) {
 
     delete bpm;
     delete disk_manager;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 }
\ No newline at end of file
@@ -20,7 +20,7 @@ namespace TinyDB {
 TEST(SeqScanExecutorTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -88,7 +88,59 @@ TEST(SeqScanExecutorTest, BasicTest) {
     delete executor;
     delete bpm;
     delete disk_manager;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
+}
+
+// table much smaller than the buffer pool doesn't go through the bulk read ring
+TEST(SeqScanExecutorTest, SmallTableTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 400;
+    DiskManager::RemoveFiles(filename);
+
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+    auto colA = Column("colA", TypeId::BIGINT);
+    auto colB = Column("colB", TypeId::VARCHAR, 20);
+    auto schema = Schema({colA, colB});
+    auto tuple = Tuple({Value(TypeId::BIGINT, static_cast<int64_t> (20010310)), Value(TypeId::VARCHAR, "hello world")},
+                       &schema);
+    auto catalog = Catalog(bpm);
+    auto table_meta = catalog.CreateTable("table", schema);
+    EXPECT_EQ(table_meta->table_->GetPageCount(), 1u);
+
+    // more pages than a ring could hold
+    while (table_meta->table_->GetPageCount() <= BULKREAD_RING_SIZE + 8) {
+        RID rid;
+        EXPECT_EQ(table_meta->table_->InsertTuple(tuple, &rid).IsOk(), true);
+    }
+    EXPECT_LE(table_meta->table_->GetPageCount(), BULKREAD_TABLE_RATIO * buffer_pool_size);
+    // evict the table by other pages, so that the first scan reads it from disk
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+        page_id_t page_id;
+        EXPECT_NE(bpm->NewPage(&page_id), nullptr);
+        bpm->UnpinPage(page_id, false);
+    }
+
+    ExecutionContext context(&catalog, bpm);
+    auto plan = new SeqScanPlan(&schema, nullptr, table_meta->oid_);
+    // scanning twice, every page stays in the pool after the first scan
+    for (int round = 0; round < 2; round++) {
+        auto miss_count = bpm->GetMissCount();
+        auto executor = new SeqScanExecutor(&context, plan);
+        executor->Init();
+        Tuple tmp;
+        while (executor->Next(&tmp)) {}
+        if (round == 1) {
+            EXPECT_EQ(bpm->GetMissCount(), miss_count);
+        }
+        delete executor;
+    }
+
+    delete plan;
+    delete bpm;
+    delete disk_manager;
+    DiskManager::RemoveFiles(filename);
 }
 
 }
\ No newline at end of file
@@ -25,7 +25,7 @@ namespace TinyDB {
 TEST(UpdateExecutorTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -110,7 +110,7 @@ TEST(UpdateExecutorTest, BasicTest) {
 
     delete bpm;
     delete disk_manager;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include <random>
 #include <gtest/gtest.h>
 #include <chrono>
+#include <thread>
 
 namespace TinyDB {
 
@@ -44,19 +45,21 @@ LogRecord GenerateRandomLogRecord(LogRecordType type) {
         return LogRecord(1, 1, type, rid, tuple, tuple);
     case LogRecordType::INITPAGE:
         return LogRecord(1, 1, type, 1, 1);
+    case LogRecordType::ALLOCATEPAGE:
+    case LogRecordType::DEALLOCATEPAGE:
+        return LogRecord(INVALID_TXN_ID, INVALID_LSN, type, 1);
     default:
         TINYDB_ASSERT(false, "invalid type");
     }
 }
 
 TEST(LogManagerTest, BasicFlushTest) {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
     auto dm = new DiskManager("test.db");
     auto lm = new LogManager(dm);
     std::random_device rd;
     std::mt19937 mt(rd());
-    std::uniform_int_distribution<int> dis(1, static_cast<int>(LogRecordType::ABORT));
+    std::uniform_int_distribution<int> dis(1, static_cast<int>(LogRecordType::DEALLOCATEPAGE));
     int log_num = 1000;
     std::vector<LogRecord> log_list;
     // shrink the time to speed up the test
@@ -102,7 +105,7 @@ TEST(LogManagerTest, BasicFlushTest) {
     while (dm->ReadLog(log_buffer, LOG_BUFFER_SIZE, offset)) {
         int inner_offset = 0;
         auto t1 = std::chrono::steady_clock::now();
-        while (true) {
+        while (inner_offset + sizeof(uint32_t) <= LOG_BUFFER_SIZE) {
             // first probe the size
             uint32_t size = *reinterpret_cast<const uint32_t *>(log_buffer + inner_offset);
             // size = 0 means there is no more log records
@@ -130,18 +133,16 @@ TEST(LogManagerTest, BasicFlushTest) {
 
     delete dm;
 
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 }
 
 TEST(LogManagerTest, ForceFlushTest) {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
     auto dm = new DiskManager("test.db");
     auto lm = new LogManager(dm);
     std::random_device rd;
     std::mt19937 mt(rd());
-    std::uniform_int_distribution<int> dis(1, static_cast<int>(LogRecordType::ABORT));
+    std::uniform_int_distribution<int> dis(1, static_cast<int>(LogRecordType::DEALLOCATEPAGE));
     int log_num = 1000;
     std::vector<LogRecord> log_list;
     // shrink the time to speed up the test
@@ -187,7 +188,7 @@ TEST(LogManagerTest, ForceFlushTest) {
     while (dm->ReadLog(log_buffer, LOG_BUFFER_SIZE, offset)) {
         int inner_offset = 0;
         auto t1 = std::chrono::steady_clock::now();
-        while (true) {
+        while (inner_offset + sizeof(uint32_t) <= LOG_BUFFER_SIZE) {
             // first probe the size
             uint32_t size = *reinterpret_cast<const uint32_t *>(log_buffer + inner_offset);
             // size = 0 means there is no more log records
@@ -215,9 +216,297 @@ TEST(LogManagerTest, ForceFlushTest) {
 
     delete dm;
 
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 }
 
+TEST(LogManagerTest, GroupCommitTest) {
+    DiskManager::RemoveFiles("test.db");
+    auto dm = new DiskManager("test.db");
+    auto lm = new LogManager(dm);
+    const int thread_num = 16;
+    const int commit_per_thread = 100;
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+
+    // committers sleep until their own record is persisted
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < commit_per_thread; j++) {
+                auto log = GenerateRandomLogRecord(LogRecordType::COMMIT);
+                auto lsn = lm->AppendLogRecord(log);
+                lm->Flush(lsn, true);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    // a committer whose record was persisted by others' write returns without waiting
+    auto wait_count = lm->GetFlushLatency().GetCount();
+    EXPECT_GT(wait_count, 0u);
+    EXPECT_LE(wait_count, static_cast<uint64_t>(thread_num * commit_per_thread));
+    // records of concurrent committers share a single write, so there are far fewer writes than commits
+    EXPECT_LT(lm->GetFlushCount(), static_cast<size_t>(thread_num * commit_per_thread / 2));
+    LOG_INFO("%s", lm->GetTimeConsumption().c_str());
+
+    // waiter without forcing is woken up by the periodic flush
+    auto log = GenerateRandomLogRecord(LogRecordType::COMMIT);
+    auto lsn = lm->AppendLogRecord(log);
+    lm->Flush(lsn, false);
+    wait_count = lm->GetFlushLatency().GetCount();
+    // and it's a no-op when log is persisted already
+    lm->Flush(lsn, false);
+    EXPECT_EQ(lm->GetFlushLatency().GetCount(), wait_count);
+
+    delete lm;
+
+    // every record is on disk
+    int record_num = 0;
+    char log_buffer[LOG_BUFFER_SIZE];
+    int offset = 0;
+    while (dm->ReadLog(log_buffer, LOG_BUFFER_SIZE, offset)) {
+        int inner_offset = 0;
+        while (inner_offset + sizeof(uint32_t) <= LOG_BUFFER_SIZE) {
+            uint32_t size = *reinterpret_cast<const uint32_t *>(log_buffer + inner_offset);
+            if (size == 0 || size + inner_offset > LOG_BUFFER_SIZE) {
+                break;
+            }
+            inner_offset += size;
+            record_num++;
+        }
+        offset += inner_offset;
+    }
+    EXPECT_EQ(record_num, thread_num * commit_per_thread + 1);
+
+    delete dm;
+    DiskManager::RemoveFiles("test.db");
+}
+
+TEST(LogManagerTest, ConcurrentAppendTest) {
+    DiskManager::RemoveFiles("test.db");
+    auto dm = new DiskManager("test.db");
+    auto lm = new LogManager(dm);
+    const int thread_num = 8;
+    const int log_per_thread = 2000;
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+
+    // records are much larger than the ring in total, so appenders wrap around and wait for space
+    std::vector<std::vector<LogRecord>> log_lists(thread_num);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i]() {
+            std::mt19937 mt(i);
+            std::uniform_int_distribution<int> dis(1, static_cast<int>(LogRecordType::DEALLOCATEPAGE));
+            for (int j = 0; j < log_per_thread; j++) {
+                auto log = GenerateRandomLogRecord(static_cast<LogRecordType>(dis(mt)));
+                lm->AppendLogRecord(log);
+                log_lists[i].push_back(log);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    lm->Flush(thread_num * log_per_thread - 1, true);
+    LOG_INFO("%s", lm->GetTimeConsumption().c_str());
+    delete lm;
+
+    std::vector<LogRecord> expected(thread_num * log_per_thread);
+    for (auto &log_list : log_lists) {
+        for (auto &log : log_list) {
+            ASSERT_GE(log.GetLSN(), 0);
+            ASSERT_LT(log.GetLSN(), thread_num * log_per_thread);
+            expected[log.GetLSN()] = log;
+        }
+    }
+
+    // log file is ordered by lsn without any gap
+    lsn_t next_lsn = 0;
+    char log_buffer[LOG_BUFFER_SIZE];
+    int offset = 0;
+    while (dm->ReadLog(log_buffer, LOG_BUFFER_SIZE, offset)) {
+        int inner_offset = 0;
+        while (inner_offset + sizeof(uint32_t) <= LOG_BUFFER_SIZE) {
+            uint32_t size = *reinterpret_cast<const uint32_t *>(log_buffer + inner_offset);
+            if (size == 0 || size + inner_offset > LOG_BUFFER_SIZE) {
+                break;
+            }
+            auto log = LogRecord::DeserializeFrom(log_buffer + inner_offset);
+            ASSERT_EQ(log.GetLSN(), next_lsn);
+            EXPECT_EQ(log, expected[next_lsn]);
+            next_lsn++;
+            inner_offset += size;
+        }
+        offset += inner_offset;
+    }
+    EXPECT_EQ(next_lsn, thread_num * log_per_thread);
+
+    delete dm;
+    DiskManager::RemoveFiles("test.db");
+}
+
+TEST(LogManagerTest, PartitionedAppendTest) {
+    DiskManager::RemoveFiles("test.db");
+    const size_t partition_num = 4;
+    LOG_PARTITION_NUM = partition_num;
+    auto dm = new DiskManager("test.db");
+    auto lm = new LogManager(dm);
+    EXPECT_EQ(dm->GetLogPartitionNum(), partition_num);
+    EXPECT_EQ(lm->GetPartitionNum(), partition_num);
+    const int thread_num = 8;
+    const int log_per_thread = 2000;
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+
+    std::vector<std::vector<LogRecord>> log_lists(thread_num);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i]() {
+            std::mt19937 mt(i);
+            std::uniform_int_distribution<int> dis(1, static_cast<int>(LogRecordType::DEALLOCATEPAGE));
+            for (int j = 0; j < log_per_thread; j++) {
+                auto log = GenerateRandomLogRecord(static_cast<LogRecordType>(dis(mt)));
+                lm->AppendLogRecord(log);
+                log_lists[i].push_back(log);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    // persisted lsn is the minimum over partitions, so it covers log of every partition
+    lm->Flush(thread_num * log_per_thread - 1, true);
+    LOG_INFO("%s", lm->GetTimeConsumption().c_str());
+    delete lm;
+
+    std::vector<LogRecord> expected(thread_num * log_per_thread);
+    for (auto &log_list : log_lists) {
+        for (auto &log : log_list) {
+            ASSERT_GE(log.GetLSN(), 0);
+            ASSERT_LT(log.GetLSN(), thread_num * log_per_thread);
+            expected[log.GetLSN()] = log;
+        }
+    }
+
+    // every partition is ordered by lsn, and every lsn shows up once across them
+    std::vector<bool> seen(thread_num * log_per_thread, false);
+    char log_buffer[LOG_BUFFER_SIZE];
+    for (size_t partition = 0; partition < partition_num; partition++) {
+        lsn_t prev_lsn = INVALID_LSN;
+        int offset = 0;
+        while (dm->ReadLog(log_buffer, LOG_BUFFER_SIZE, offset, partition)) {
+            int inner_offset = 0;
+            while (inner_offset + sizeof(uint32_t) <= LOG_BUFFER_SIZE) {
+                uint32_t size = *reinterpret_cast<const uint32_t *>(log_buffer + inner_offset);
+                if (size == 0 || size + inner_offset > LOG_BUFFER_SIZE) {
+                    break;
+                }
+                auto log = LogRecord::DeserializeFrom(log_buffer + inner_offset);
+                ASSERT_GT(log.GetLSN(), prev_lsn);
+                ASSERT_LT(log.GetLSN(), thread_num * log_per_thread);
+                ASSERT_FALSE(seen[log.GetLSN()]);
+                EXPECT_EQ(log, expected[log.GetLSN()]);
+                seen[log.GetLSN()] = true;
+                prev_lsn = log.GetLSN();
+                inner_offset += size;
+            }
+            offset += inner_offset;
+        }
+    }
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_TRUE(seen[i]) << "lsn " << i << " is missing";
+    }
+
+    delete dm;
+    LOG_PARTITION_NUM = 1;
+    DiskManager::RemoveFiles("test.db");
+}
+
+/**
+ * @brief
+ * append throughput of 1 to 32 threads, on a single log and on partitioned logs.
+ * it's opt-in, run it with --gtest_also_run_disabled_tests
+ */
+TEST(LogManagerTest, DISABLED_PartitionScalingBenchmark) {
+    const int log_per_thread = 20000;
+    const size_t max_partition_num = 8;
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+
+    auto remove_files = [&]() {
+        DiskManager::RemoveFiles("test.db");
+    };
+    for (int thread_num : {1, 2, 4, 8, 16, 32}) {
+        for (size_t partition_num : {static_cast<size_t>(1), max_partition_num}) {
+            remove_files();
+            LOG_PARTITION_NUM = partition_num;
+            auto dm = new DiskManager("test.db");
+            auto lm = new LogManager(dm);
+
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int i = 0; i < thread_num; i++) {
+                threads.emplace_back([&]() {
+                    for (int j = 0; j < log_per_thread; j++) {
+                        auto log = LogRecord(j, INVALID_LSN, LogRecordType::COMMIT);
+                        lm->AppendLogRecord(log);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            LOG_INFO("threads %d, partitions %lu: %.0f appends/s", thread_num, partition_num,
+                     thread_num * log_per_thread * 1e6 / std::max<int64_t>(duration.count(), 1));
+
+            delete lm;
+            delete dm;
+        }
+    }
+    LOG_PARTITION_NUM = 1;
+    remove_files();
+}
 
-}
\ No newline at end of file
+/**
+ * @brief
+ * commit latency of group commit against the old busy waiting.
+ * it's opt-in, run it with --gtest_also_run_disabled_tests
+ */
+TEST(LogManagerTest, DISABLED_GroupCommitBenchmark) {
+    const int commit_per_thread = 200;
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+
+    for (int thread_num : {1, 4, 16}) {
+        for (bool group_commit : {false, true}) {
+            DiskManager::RemoveFiles("test.db");
+            LOG_GROUP_COMMIT = group_commit;
+            auto dm = new DiskManager("test.db");
+            auto lm = new LogManager(dm);
+
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int i = 0; i < thread_num; i++) {
+                threads.emplace_back([&]() {
+                    for (int j = 0; j < commit_per_thread; j++) {
+                        auto log = LogRecord(j, INVALID_LSN, LogRecordType::COMMIT);
+                        lm->Flush(lm->AppendLogRecord(log), true);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            LOG_INFO("threads %d, %s: %.0f commits/s, %lu writes, latency {%s}", thread_num,
+                     group_commit ? "group commit" : "spin wait",
+                     thread_num * commit_per_thread * 1e6 / std::max<int64_t>(duration.count(), 1),
+                     lm->GetFlushCount(), lm->GetFlushLatency().ToString().c_str());
+
+            delete lm;
+            delete dm;
+        }
+    }
+    LOG_GROUP_COMMIT = true;
+    DiskManager::RemoveFiles("test.db");
+}
+
+}
@@ -23,6 +23,8 @@
 
 #include <gtest/gtest.h>
 #include <random>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace TinyDB {
 
@@ -39,14 +41,15 @@ bool PerformInsertion(ExecutionContext *context, const Tuple &tuple) {
 }
 
 TEST(RecoveryTest, RedoTest) {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 
     auto colA = Column("ID", TypeId::INTEGER);
     auto colC = Column("Money", TypeId::INTEGER);
     auto schema = Schema({colA, colC});
     
     LOG_TIMEOUT = std::chrono::milliseconds(300);
+    // catalog isn't persisted, table is opened on it's first page after restart
+    page_id_t first_page_id = INVALID_PAGE_ID;
 
     // id -> money
     std::unordered_map<int, int> accounts;
@@ -61,7 +64,7 @@ TEST(RecoveryTest, RedoTest) {
         {
             // use txn to create table
             auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
+            first_page_id = catalog.CreateTable("table", schema, txn_context)->table_->GetFirstPageId();
             tm->Commit(txn_context);
         }
         // scenario: insert many tuple then shutdown the database
@@ -131,12 +134,7 @@ TEST(RecoveryTest, RedoTest) {
         
         // fake the new catalog, since we aren't logging metadata now
         auto catalog = Catalog(bpm, lm);
-        {
-            // use txn to create table
-            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
-            tm->Commit(txn_context);
-        }
+        catalog.OpenTable("table", schema, first_page_id);
 
         // perform recovery
         auto rm = new RecoveryManager(dm, bpm, lm);
@@ -171,19 +169,19 @@ TEST(RecoveryTest, RedoTest) {
         delete rm;
     }
 
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 }
 
 TEST(RecoveryTest, ConcurrentRedoTest) {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 
     auto colA = Column("ID", TypeId::INTEGER);
     auto colC = Column("Money", TypeId::INTEGER);
     auto schema = Schema({colA, colC});
     
     LOG_TIMEOUT = std::chrono::milliseconds(300);
+    // catalog isn't persisted, table is opened on it's first page after restart
+    page_id_t first_page_id = INVALID_PAGE_ID;
 
     // id -> money
     std::unordered_map<int, int> accounts;
@@ -198,7 +196,7 @@ TEST(RecoveryTest, ConcurrentRedoTest) {
         {
             // use txn to create table
             auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
+            first_page_id = catalog.CreateTable("table", schema, txn_context)->table_->GetFirstPageId();
             tm->Commit(txn_context);
         }
         // scenario: insert many tuple then shutdown the database
@@ -281,13 +279,162 @@ TEST(RecoveryTest, ConcurrentRedoTest) {
         auto tm = new TwoPLManager(std::move(lock_manager), lm);
         
         // fake the new catalog, since we aren't logging metadata now
+        auto catalog = Catalog(bpm, lm);
+        catalog.OpenTable("table", schema, first_page_id);
+
+        // perform recovery
+        auto rm = new RecoveryManager(dm, bpm, lm);
+        rm->ARIES();
+
+        // after recovery, try to scan the tuple
+        std::vector<Tuple> result_set;
+        {
+            auto scan_plan = std::make_unique<SeqScanPlan>(&schema, nullptr, catalog.GetTable("table")->oid_);
+            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
+            auto exec_context = ExecutionContext(&catalog, bpm, tm, txn_context);
+            ExecutionEngine engine;
+            engine.Execute(&exec_context, scan_plan.get(), &result_set);
+            tm->Commit(txn_context);
+        }
+        EXPECT_EQ(result_set.size(), accounts.size());
+        for (uint i = 0; i < result_set.size(); i++) {
+            auto id = result_set[i].GetValue(&schema, 0).GetAs<int>();
+            auto money = result_set[i].GetValue(&schema, 1).GetAs<int>();
+            EXPECT_EQ(money, accounts[id]);
+        }
+
+        LOG_INFO("%s", tm->GetTimeConsumption().c_str());
+        LOG_INFO("%s", bpm->GetTimeConsumption().c_str());
+        LOG_INFO("%s", lm->GetTimeConsumption().c_str());
+        LOG_INFO("%s", dm->GetTimeConsumption().c_str());
+
+        delete tm;
+        delete bpm;
+        delete lm;
+        delete dm;
+        delete rm;
+    }
+
+    DiskManager::RemoveFiles("test.db");
+}
+
+/**
+ * @brief
+ * log is spread over partitions, recovery should merge them back
+ */
+TEST(RecoveryTest, PartitionedRedoTest) {
+    DiskManager::RemoveFiles("test.db");
+
+    auto colA = Column("ID", TypeId::INTEGER);
+    auto colC = Column("Money", TypeId::INTEGER);
+    auto schema = Schema({colA, colC});
+    
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+    // catalog isn't persisted, table is opened on it's first page after restart
+    page_id_t first_page_id = INVALID_PAGE_ID;
+    const size_t partition_num = 4;
+    LOG_PARTITION_NUM = partition_num;
+
+    // id -> money
+    std::unordered_map<int, int> accounts;
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        auto lock_manager = std::make_unique<LockManager>(DeadLockResolveProtocol::DL_DETECT);
+        auto tm = new TwoPLManager(std::move(lock_manager), lm);
+        
         auto catalog = Catalog(bpm, lm);
         {
             // use txn to create table
             auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
+            first_page_id = catalog.CreateTable("table", schema, txn_context)->table_->GetFirstPageId();
             tm->Commit(txn_context);
         }
+        // scenario: insert many tuple then shutdown the database
+        // after recovery, we should see all of insertions
+
+        std::random_device rd;
+        std::mt19937 mt(rd());
+        // generate account num
+        std::uniform_int_distribution<int> money_gen;
+        int num_of_txn = 3;
+        int num_of_worker = 8;
+        int op_per_txn = 10;
+        std::vector<std::thread> worker_list;
+        std::mutex mu;
+
+        for (int k = 0; k < num_of_worker; k++) {
+            worker_list.push_back(std::thread([&](int k){
+                for (int i = 0; i < num_of_txn; i++) {
+                    auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
+                    auto exec_context = ExecutionContext(&catalog, bpm, tm, txn_context);
+                    for (int j = 0; j < op_per_txn; j++) {
+                        auto ID = ValueFactory::GetIntegerValue(k * num_of_txn * op_per_txn + i * op_per_txn + j);
+                        auto money = ValueFactory::GetIntegerValue(money_gen(mt));
+                        auto tuple = Tuple({ID, money}, &schema);
+
+                        mu.lock();
+                        accounts[ID.GetAs<int>()] = money.GetAs<int>();
+                        mu.unlock();
+                        if (!PerformInsertion(&exec_context, tuple)) {
+                            LOG_INFO("Txn %d aborted", txn_context->GetTxnId());
+                            break;
+                        }
+                    }
+                    if (!txn_context->IsAborted()) {
+                        tm->Commit(txn_context);
+                    }
+                }
+            }, k));
+        }
+
+        for (int i = 0; i < num_of_worker; i++) {
+            worker_list[i].join();
+        }
+
+        {
+            std::vector<Tuple> result_set;
+            {
+                auto scan_plan = std::make_unique<SeqScanPlan>(&schema, nullptr, catalog.GetTable("table")->oid_);
+                auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
+                auto exec_context = ExecutionContext(&catalog, bpm, tm, txn_context);
+                ExecutionEngine engine;
+                engine.Execute(&exec_context, scan_plan.get(), &result_set);
+                tm->Commit(txn_context);
+            }
+            EXPECT_EQ(result_set.size(), accounts.size());
+            for (uint i = 0; i < result_set.size(); i++) {
+                auto id = result_set[i].GetValue(&schema, 0).GetAs<int>();
+                auto money = result_set[i].GetValue(&schema, 1).GetAs<int>();
+                EXPECT_EQ(money, accounts[id]);
+            }
+        }
+
+        LOG_INFO("%s", tm->GetTimeConsumption().c_str());
+        LOG_INFO("%s", bpm->GetTimeConsumption().c_str());
+        LOG_INFO("%s", lm->GetTimeConsumption().c_str());
+        LOG_INFO("%s", dm->GetTimeConsumption().c_str());
+
+        delete tm;
+        delete bpm;
+        delete lm;
+        delete dm;
+    }
+
+    {
+        // restart database, partitions left on disk should be found without the option
+        LOG_PARTITION_NUM = 1;
+        auto dm = new DiskManager("test.db");
+        EXPECT_EQ(dm->GetLogPartitionNum(), partition_num);
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        auto lock_manager = std::make_unique<LockManager>(DeadLockResolveProtocol::DL_DETECT);
+        auto tm = new TwoPLManager(std::move(lock_manager), lm);
+        
+        // fake the new catalog, since we aren't logging metadata now
+        auto catalog = Catalog(bpm, lm);
+        catalog.OpenTable("table", schema, first_page_id);
 
         // perform recovery
         auto rm = new RecoveryManager(dm, bpm, lm);
@@ -322,19 +469,83 @@ TEST(RecoveryTest, ConcurrentRedoTest) {
         delete rm;
     }
 
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 }
 
+/**
+ * @brief
+ * log after a hole of lsn is not persisted as a whole, it should be discarded
+ */
+TEST(RecoveryTest, PartitionHoleTest) {
+    DiskManager::RemoveFiles("test.db");
+
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+    LOG_PARTITION_NUM = 2;
+    const int log_per_thread = 10;
+    uint32_t log_size = 0;
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        // threads are assigned to partitions round robin, so the first and the last one share a partition
+        for (int i = 0; i < 3; i++) {
+            std::thread([&, i]() {
+                for (int j = 0; j < log_per_thread; j++) {
+                    auto log = LogRecord(i * log_per_thread + j, INVALID_LSN, LogRecordType::COMMIT);
+                    lm->AppendLogRecord(log);
+                    log_size = log.GetSize();
+                }
+            }).join();
+        }
+        lm->Flush(3 * log_per_thread - 1, true);
+
+        delete lm;
+        delete dm;
+    }
+
+    // lose the log of second thread
+    struct stat stat_buf[2];
+    ASSERT_EQ(stat("test.log", &stat_buf[0]), 0);
+    ASSERT_EQ(stat("test.log.1", &stat_buf[1]), 0);
+    const char *lost = stat_buf[0].st_size < stat_buf[1].st_size ? "test.log" : "test.log.1";
+    const char *kept = stat_buf[0].st_size < stat_buf[1].st_size ? "test.log.1" : "test.log";
+    ASSERT_EQ(truncate(lost, 0), 0);
+
+    {
+        LOG_PARTITION_NUM = 1;
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        auto rm = new RecoveryManager(dm, bpm, lm);
+        rm->ARIES();
+
+        // log of the third thread is cut
+        struct stat kept_stat;
+        ASSERT_EQ(stat(kept, &kept_stat), 0);
+        EXPECT_EQ(kept_stat.st_size, log_per_thread * log_size);
+        // lsn continues from the hole
+        auto log = LogRecord(0, INVALID_LSN, LogRecordType::COMMIT);
+        EXPECT_EQ(lm->AppendLogRecord(log), log_per_thread);
+
+        delete bpm;
+        delete lm;
+        delete dm;
+        delete rm;
+    }
+
+    DiskManager::RemoveFiles("test.db");
+}
+
+
 TEST(RecoveryTest, AbortRedoTest) {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 
     auto colA = Column("ID", TypeId::INTEGER);
     auto colC = Column("Money", TypeId::INTEGER);
     auto schema = Schema({colA, colC});
     
     LOG_TIMEOUT = std::chrono::milliseconds(300);
+    // catalog isn't persisted, table is opened on it's first page after restart
+    page_id_t first_page_id = INVALID_PAGE_ID;
 
     // id -> money
     std::unordered_map<int, int> accounts;
@@ -349,7 +560,7 @@ TEST(RecoveryTest, AbortRedoTest) {
         {
             // use txn to create table
             auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
+            first_page_id = catalog.CreateTable("table", schema, txn_context)->table_->GetFirstPageId();
             tm->Commit(txn_context);
         }
         // scenario: insert many tuple then shutdown the database
@@ -446,12 +657,7 @@ TEST(RecoveryTest, AbortRedoTest) {
         
         // fake the new catalog, since we aren't logging metadata now
         auto catalog = Catalog(bpm, lm);
-        {
-            // use txn to create table
-            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
-            tm->Commit(txn_context);
-        }
+        catalog.OpenTable("table", schema, first_page_id);
 
         // perform recovery
         auto rm = new RecoveryManager(dm, bpm, lm);
@@ -486,19 +692,19 @@ TEST(RecoveryTest, AbortRedoTest) {
         delete rm;
     }
 
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 }
 
 TEST(RecoveryTest, UndoTest) {
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
 
     auto colA = Column("ID", TypeId::INTEGER);
     auto colC = Column("Money", TypeId::INTEGER);
     auto schema = Schema({colA, colC});
     
     LOG_TIMEOUT = std::chrono::milliseconds(300);
+    // catalog isn't persisted, table is opened on it's first page after restart
+    page_id_t first_page_id = INVALID_PAGE_ID;
 
     // id -> money
     std::unordered_map<int, int> accounts;
@@ -513,7 +719,7 @@ TEST(RecoveryTest, UndoTest) {
         {
             // use txn to create table
             auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
+            first_page_id = catalog.CreateTable("table", schema, txn_context)->table_->GetFirstPageId();
             tm->Commit(txn_context);
         }
         // scenario: insert many tuple then shutdown the database
@@ -626,12 +832,7 @@ TEST(RecoveryTest, UndoTest) {
         
         // fake the new catalog, since we aren't logging metadata now
         auto catalog = Catalog(bpm, lm);
-        {
-            // use txn to create table
-            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
-            tm->Commit(txn_context);
-        }
+        catalog.OpenTable("table", schema, first_page_id);
 
         // perform recovery
         auto rm = new RecoveryManager(dm, bpm, lm);
@@ -676,12 +877,7 @@ TEST(RecoveryTest, UndoTest) {
         
         // fake the new catalog, since we aren't logging metadata now
         auto catalog = Catalog(bpm, lm);
-        {
-            // use txn to create table
-            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
-            catalog.CreateTable("table", schema, txn_context);
-            tm->Commit(txn_context);
-        }
+        catalog.OpenTable("table", schema, first_page_id);
 
         // perform recovery
         auto rm = new RecoveryManager(dm, bpm, lm);
@@ -716,8 +912,211 @@ TEST(RecoveryTest, UndoTest) {
         delete rm;
     }
 
-    remove("test.db");
-    remove("test.log");
+    DiskManager::RemoveFiles("test.db");
+}
+
+/**
+ * @brief
+ * lsn continues from the log on disk when database is started without recovery,
+ * so that log of both runs is replayed in order
+ */
+TEST(RecoveryTest, RestartedLogTest) {
+    DiskManager::RemoveFiles("test.db");
+
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+    const int commit_num = 10;
+    const int active_txn_num = 5;
+    // the first run is committed
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        for (int i = 0; i < commit_num; i++) {
+            auto log = LogRecord(i, INVALID_LSN, LogRecordType::COMMIT);
+            lm->AppendLogRecord(log);
+        }
+        lm->Flush(commit_num - 1, true);
+        delete lm;
+        delete dm;
+    }
+    // the second one leaves active txns, and it starts without recovery
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        for (int i = 0; i < active_txn_num; i++) {
+            auto log = LogRecord(commit_num + i, INVALID_LSN, LogRecordType::BEGIN);
+            EXPECT_EQ(lm->AppendLogRecord(log), commit_num + i);
+        }
+        lm->Flush(commit_num + active_txn_num - 1, true);
+        delete lm;
+        delete dm;
+    }
+
+    struct stat log_stat;
+    ASSERT_EQ(stat("test.log", &log_stat), 0);
+    auto log_size = log_stat.st_size;
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        auto rm = new RecoveryManager(dm, bpm, lm);
+        rm->ARIES();
+
+        // nothing is cut
+        ASSERT_EQ(stat("test.log", &log_stat), 0);
+        EXPECT_GE(log_stat.st_size, log_size);
+        // txns of the second run are aborted, their abort records follow the log of both runs
+        auto log = LogRecord(0, INVALID_LSN, LogRecordType::COMMIT);
+        EXPECT_EQ(lm->AppendLogRecord(log), commit_num + 2 * active_txn_num);
+
+        delete bpm;
+        delete lm;
+        delete dm;
+        delete rm;
+    }
+
+    DiskManager::RemoveFiles("test.db");
 }
 
-}
\ No newline at end of file
+/**
+ * @brief
+ * free space map isn't written back without checkpoint, it should be rebuilt from log
+ */
+TEST(RecoveryTest, FreeSpaceMapRedoTest) {
+    DiskManager::RemoveFiles("test.db");
+
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+    const int page_num = 32;
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        for (int i = 0; i < page_num; i++) {
+            dm->AllocatePage();
+        }
+        for (int i = 0; i < page_num; i += 2) {
+            dm->DeallocatePage(i);
+        }
+        // wait until allocation records are durable, every allocation takes a lsn
+        lm->Flush(page_num + page_num / 2 - 1, true);
+
+        delete lm;
+        delete dm;
+    }
+
+    {
+        // restart database
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        EXPECT_FALSE(dm->IsAllocated(1));
+
+        auto rm = new RecoveryManager(dm, bpm, lm);
+        rm->ARIES();
+
+        for (int i = 0; i < page_num; i++) {
+            EXPECT_EQ(dm->IsAllocated(i), i % 2 == 1);
+        }
+        EXPECT_EQ(dm->AllocatePage(), 0);
+
+        delete bpm;
+        delete lm;
+        delete dm;
+        delete rm;
+    }
+
+    DiskManager::RemoveFiles("test.db");
+}
+
+/**
+ * @brief
+ * table is cached by a named pool, while recovery runs through the default one.
+ * recovered tuples should be visible through the named pool
+ */
+TEST(RecoveryTest, NamedPoolRedoTest) {
+    DiskManager::RemoveFiles("test.db");
+
+    auto colA = Column("ID", TypeId::INTEGER);
+    auto colC = Column("Money", TypeId::INTEGER);
+    auto schema = Schema({colA, colC});
+
+    LOG_TIMEOUT = std::chrono::milliseconds(300);
+    // catalog isn't persisted, table is opened on it's first page after restart
+    page_id_t first_page_id = INVALID_PAGE_ID;
+    const int tuple_num = 30;
+    {
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        auto bulk_bpm = new BufferPoolManager(10, dm, lm);
+        auto lock_manager = std::make_unique<LockManager>(DeadLockResolveProtocol::DL_DETECT);
+        auto tm = new TwoPLManager(std::move(lock_manager), lm);
+
+        auto catalog = Catalog(bpm, lm);
+        catalog.RegisterBufferPool("bulk", bulk_bpm);
+        {
+            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
+            first_page_id = catalog.CreateTable("table", schema, txn_context, "bulk")->table_->GetFirstPageId();
+            tm->Commit(txn_context);
+        }
+        auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
+        auto exec_context = ExecutionContext(&catalog, bpm, tm, txn_context);
+        for (int i = 0; i < tuple_num; i++) {
+            auto tuple = Tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i * 10)}, &schema);
+            EXPECT_TRUE(PerformInsertion(&exec_context, tuple));
+        }
+        tm->Commit(txn_context);
+
+        delete tm;
+        delete bulk_bpm;
+        delete bpm;
+        delete lm;
+        delete dm;
+    }
+
+    {
+        // restart database
+        auto dm = new DiskManager("test.db");
+        auto lm = new LogManager(dm);
+        auto bpm = new BufferPoolManager(10, dm, lm);
+        auto bulk_bpm = new BufferPoolManager(10, dm, lm);
+        auto lock_manager = std::make_unique<LockManager>(DeadLockResolveProtocol::DL_DETECT);
+        auto tm = new TwoPLManager(std::move(lock_manager), lm);
+
+        // fake the new catalog, table is cached by the named pool from now on
+        auto catalog = Catalog(bpm, lm);
+        catalog.RegisterBufferPool("bulk", bulk_bpm);
+        catalog.OpenTable("table", schema, first_page_id, "bulk");
+        // named pool caches a stale copy of the table, it should be recovered in place
+        ASSERT_NE(bulk_bpm->FetchPage(first_page_id), nullptr);
+        bulk_bpm->UnpinPage(first_page_id, false);
+
+        auto rm = new RecoveryManager(dm, bpm, lm);
+        rm->AddBufferPool(bulk_bpm);
+        rm->ARIES();
+
+        std::vector<Tuple> result_set;
+        {
+            auto scan_plan = std::make_unique<SeqScanPlan>(&schema, nullptr, catalog.GetTable("table")->oid_);
+            auto txn_context = tm->Begin(IsolationLevel::SERIALIZABLE);
+            auto exec_context = ExecutionContext(&catalog, bpm, tm, txn_context);
+            ExecutionEngine engine;
+            engine.Execute(&exec_context, scan_plan.get(), &result_set);
+            tm->Commit(txn_context);
+        }
+        EXPECT_EQ(result_set.size(), static_cast<size_t>(tuple_num));
+        for (uint i = 0; i < result_set.size(); i++) {
+            auto id = result_set[i].GetValue(&schema, 0).GetAs<int>();
+            EXPECT_EQ(result_set[i].GetValue(&schema, 1).GetAs<int>(), id * 10);
+        }
+
+        delete tm;
+        delete bulk_bpm;
+        delete bpm;
+        delete lm;
+        delete dm;
+        delete rm;
+    }
+
+    DiskManager::RemoveFiles("test.db");
+}
+
+}
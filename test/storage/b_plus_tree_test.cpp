@@ -12,6 +12,7 @@
 #include "storage/index/b_plus_tree.h"
 #include "storage/index/generic_key.h"
 
+#include <algorithm>
 #include <thread>
 #include <gtest/gtest.h>
 #include <random>
@@ -22,7 +23,7 @@ namespace TinyDB {
 TEST(BPlusTreeTest, SequentialInsertTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -79,13 +80,70 @@ TEST(BPlusTreeTest, SequentialInsertTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
+}
+
+TEST(BPlusTreeTest, LargePageTest) {
+    const std::string filename = "test.db";
+    const size_t buffer_pool_size = 50;
+    DiskManager::RemoveFiles(filename);
+
+    DISK_PAGE_SIZE = 16 * 1024;
+    auto disk_manager = new DiskManager(filename);
+    auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    EXPECT_EQ(bpm->GetPageSize(), 16 * 1024);
+
+    auto colA = Column("colA", TypeId::BIGINT);
+    std::vector<Column> cols;
+    cols.push_back(colA);
+    auto schema = Schema(cols);
+
+    GenericComparator<8> comparator(&schema);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("large_page_test", bpm, comparator);
+    GenericKey<8> index_key;
+    BPlusTreeExecutionContext context;
+
+    int key_num = 50000;
+    std::vector<int64_t> keys(key_num);
+    for (int i = 0; i < key_num; i++) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+    for (auto key : keys) {
+        context.Reset();
+        auto tmp = Tuple({Value(TypeId::BIGINT, key)}, &schema);
+        index_key.SetFromKey(tmp);
+        EXPECT_EQ(tree.Insert(index_key, RID(key), &context), true);
+    }
+    // nodes are 4 times larger, so there are much fewer pages
+    EXPECT_LT(disk_manager->GetAllocateCount(), key_num / 500);
+
+    for (int i = 0; i < key_num; i += 2) {
+        context.Reset();
+        auto k = Tuple({Value(TypeId::BIGINT, keys[i])}, &schema);
+        index_key.SetFromKey(k);
+        EXPECT_EQ(tree.Remove(index_key, &context), true);
+    }
+    for (int i = 0; i < key_num; i++) {
+        std::vector<RID> result;
+        auto k = Tuple({Value(TypeId::BIGINT, keys[i])}, &schema);
+        index_key.SetFromKey(k);
+        EXPECT_EQ(tree.GetValue(index_key, &result, &context), i % 2 == 1);
+        if (i % 2 == 1) {
+            EXPECT_EQ(result[0], RID(keys[i]));
+        }
+    }
+
+    delete bpm;
+    delete disk_manager;
+    DISK_PAGE_SIZE = PAGE_SIZE;
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(BPlusTreeTest, RandomInsertTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -158,13 +216,13 @@ TEST(BPlusTreeTest, RandomInsertTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(BPlusTreeTest, ConcurrentBasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -262,13 +320,13 @@ TEST(BPlusTreeTest, ConcurrentBasicTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(BPlusTreeTest, ConcurrentStrictTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -384,13 +442,13 @@ TEST(BPlusTreeTest, ConcurrentStrictTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(BPlusTreeTest, BasicIteratorTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -465,13 +523,13 @@ TEST(BPlusTreeTest, BasicIteratorTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(BPlusTreeTest, ConcurrentIteratorTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -586,7 +644,7 @@ TEST(BPlusTreeTest, ConcurrentIteratorTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
-}
\ No newline at end of file
+}
@@ -2,8 +2,13 @@
 #include <string>
 #include <random>
 #include <cstring>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <sys/stat.h>
 
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/page_compressor.h"
 #include "common/logger.h"
 
 namespace TinyDB {
@@ -38,7 +43,7 @@ TEST(DiskManagerTest, SimpleIOTest) {
     res = strcmp(readBuffer, testString2.c_str());
     EXPECT_EQ(0, res);
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 TEST(DiskManagerTest, StrongTest) {
@@ -79,7 +84,598 @@ TEST(DiskManagerTest, StrongTest) {
 
     delete dm2;
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
-}
\ No newline at end of file
+/**
+ * @brief
+ * threads read and write their own pages concurrently, then sync
+ */
+TEST(DiskManagerTest, ConcurrentIOTest) {
+    std::string filename = "test.db";
+    DiskManager::RemoveFiles(filename);
+    auto dm = new DiskManager(filename);
+    const int thread_num = 8;
+    const int page_num = 64;
+    const int round_num = 16;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i] {
+            std::vector<page_id_t> pages;
+            for (int j = 0; j < page_num; j++) {
+                pages.push_back(dm->AllocatePage());
+            }
+            char data[PAGE_SIZE];
+            char buffer[PAGE_SIZE];
+            for (int round = 0; round < round_num; round++) {
+                for (auto page_id : pages) {
+                    memset(data, page_id + round, PAGE_SIZE);
+                    dm->WritePage(page_id, data);
+                }
+                for (auto page_id : pages) {
+                    memset(data, page_id + round, PAGE_SIZE);
+                    dm->ReadPage(page_id, buffer);
+                    EXPECT_EQ(std::memcmp(buffer, data, PAGE_SIZE), 0);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    dm->Sync();
+    EXPECT_EQ(dm->GetAllocateCount(), thread_num * page_num);
+
+    // reading past the end of file gives us a zero page
+    char buffer[PAGE_SIZE];
+    memset(buffer, 1, PAGE_SIZE);
+    dm->ReadPage(thread_num * page_num, buffer, false);
+    for (uint32_t i = 0; i < PAGE_SIZE; i++) {
+        EXPECT_EQ(buffer[i], 0);
+    }
+    LOG_INFO("%s", dm->GetTimeConsumption().c_str());
+
+    delete dm;
+    DiskManager::RemoveFiles(filename);
+}
+
+TEST(DiskManagerTest, BatchIOTest) {
+    std::string filename = "test.db";
+    DiskManager::RemoveFiles(filename);
+    const int page_num = 200;
+
+    // io_uring and the synchronous fallback should behave the same
+    auto old_depth = IO_URING_QUEUE_DEPTH;
+    for (size_t depth : {static_cast<size_t>(0), static_cast<size_t>(8)}) {
+        IO_URING_QUEUE_DEPTH = depth;
+        auto dm = new DiskManager(filename);
+        if (depth == 0) {
+            EXPECT_FALSE(dm->IsAsyncIOEnabled());
+        }
+        LOG_INFO("queue depth %lu, async io enabled: %d", depth, dm->IsAsyncIOEnabled());
+
+        std::vector<page_id_t> pages;
+        std::unique_ptr<char[]> data(new char[page_num * PAGE_SIZE]);
+        IOBatch write_batch;
+        for (int i = 0; i < page_num; i++) {
+            pages.push_back(dm->AllocatePage());
+            memset(data.get() + i * PAGE_SIZE, pages.back() + depth, PAGE_SIZE);
+            write_batch.AddWrite(pages.back(), data.get() + i * PAGE_SIZE);
+        }
+        // batch is larger than the ring
+        dm->ExecuteBatch(&write_batch);
+        EXPECT_TRUE(write_batch.IsCompleted());
+
+        std::unique_ptr<char[]> buffer(new char[(page_num + 1) * PAGE_SIZE]);
+        memset(buffer.get(), 1, (page_num + 1) * PAGE_SIZE);
+        IOBatch read_batch;
+        for (int i = 0; i < page_num; i++) {
+            read_batch.AddRead(pages[i], buffer.get() + i * PAGE_SIZE);
+        }
+        // reading past the end of file gives us a zero page
+        read_batch.AddRead(pages.back() + 1, buffer.get() + page_num * PAGE_SIZE);
+        dm->SubmitBatch(&read_batch);
+        dm->WaitBatch(&read_batch);
+        EXPECT_EQ(std::memcmp(buffer.get(), data.get(), page_num * PAGE_SIZE), 0);
+        for (uint32_t i = 0; i < PAGE_SIZE; i++) {
+            EXPECT_EQ(buffer[page_num * PAGE_SIZE + i], 0);
+        }
+        if (dm->IsAsyncIOEnabled()) {
+            EXPECT_EQ(dm->GetAsyncIOCount(), page_num * 2 + 1);
+        }
+
+        delete dm;
+        DiskManager::RemoveFiles(filename);
+    }
+    IO_URING_QUEUE_DEPTH = old_depth;
+}
+
+/**
+ * @brief
+ * throughput of random page reads with different queue depth,
+ * queue depth 0 means synchronous I/O.
+ * it's opt-in, run it with --gtest_also_run_disabled_tests
+ */
+TEST(DiskManagerTest, DISABLED_QueueDepthBenchmark) {
+    std::string filename = "test.db";
+    DiskManager::RemoveFiles(filename);
+    const int page_num = 1024;
+    const int read_num = 8192;
+
+    auto old_depth = IO_URING_QUEUE_DEPTH;
+    {
+        auto dm = new DiskManager(filename);
+        char data[PAGE_SIZE] = {0};
+        for (int i = 0; i < page_num; i++) {
+            dm->WritePage(dm->AllocatePage(), data);
+        }
+        dm->Sync();
+        delete dm;
+    }
+
+    for (size_t depth : {0, 1, 4, 16, 64}) {
+        IO_URING_QUEUE_DEPTH = depth;
+        auto dm = new DiskManager(filename);
+        size_t batch_size = std::max<size_t>(depth, 1);
+        std::unique_ptr<char[]> buffer(new char[batch_size * PAGE_SIZE]);
+        std::mt19937 mt(0);
+        std::uniform_int_distribution<page_id_t> dis(0, page_num - 1);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < read_num; i += batch_size) {
+            IOBatch batch;
+            for (size_t j = 0; j < batch_size; j++) {
+                batch.AddRead(dis(mt), buffer.get() + j * PAGE_SIZE);
+            }
+            dm->ExecuteBatch(&batch);
+        }
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        LOG_INFO("queue depth %lu (async %d): %.0f pages/s", depth, dm->IsAsyncIOEnabled(),
+                 read_num * 1e6 / std::max<int64_t>(duration.count(), 1));
+        delete dm;
+    }
+    IO_URING_QUEUE_DEPTH = old_depth;
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * pages bypass page cache, both aligned and unaligned buffers should work
+ */
+TEST(DiskManagerTest, DirectIOTest) {
+    std::string filename = "test.db";
+    DiskManager::RemoveFiles(filename);
+    const int page_num = 16;
+
+    auto old_direct_io = DISK_DIRECT_IO;
+    DISK_DIRECT_IO = true;
+    auto dm = new DiskManager(filename);
+    LOG_INFO("direct io enabled: %d, async io enabled: %d", dm->IsDirectIOEnabled(), dm->IsAsyncIOEnabled());
+
+    // buffers are deliberately misaligned by one byte
+    std::unique_ptr<char[]> data(new char[page_num * PAGE_SIZE + 1]);
+    std::unique_ptr<char[]> buffer(new char[page_num * PAGE_SIZE + 1]);
+    std::vector<page_id_t> pages;
+    for (int i = 0; i < page_num; i++) {
+        pages.push_back(dm->AllocatePage());
+        memset(data.get() + 1 + i * PAGE_SIZE, pages.back() + 1, PAGE_SIZE);
+    }
+    // synchronous path for the first half, batch for the other half
+    IOBatch write_batch;
+    for (int i = 0; i < page_num; i++) {
+        if (i < page_num / 2) {
+            dm->WritePage(pages[i], data.get() + 1 + i * PAGE_SIZE);
+        } else {
+            write_batch.AddWrite(pages[i], data.get() + 1 + i * PAGE_SIZE);
+        }
+    }
+    dm->ExecuteBatch(&write_batch);
+
+    IOBatch read_batch;
+    for (int i = 0; i < page_num; i++) {
+        if (i % 2 == 0) {
+            dm->ReadPage(pages[i], buffer.get() + 1 + i * PAGE_SIZE);
+        } else {
+            read_batch.AddRead(pages[i], buffer.get() + 1 + i * PAGE_SIZE);
+        }
+    }
+    dm->ExecuteBatch(&read_batch);
+    EXPECT_EQ(std::memcmp(buffer.get() + 1, data.get() + 1, page_num * PAGE_SIZE), 0);
+    dm->Sync();
+    delete dm;
+
+    // pages should be readable with buffered I/O as well
+    DISK_DIRECT_IO = false;
+    dm = new DiskManager(filename);
+    EXPECT_FALSE(dm->IsDirectIOEnabled());
+    for (int i = 0; i < page_num; i++) {
+        char page[PAGE_SIZE];
+        dm->ReadPage(pages[i], page);
+        EXPECT_EQ(std::memcmp(page, data.get() + 1 + i * PAGE_SIZE, PAGE_SIZE), 0);
+    }
+    delete dm;
+
+    DISK_DIRECT_IO = old_direct_io;
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * deallocated pages should be handed out again, and free space map should survive restart
+ */
+TEST(DiskManagerTest, FreePageReuseTest) {
+    std::string filename = "test.db";
+    DiskManager::RemoveFiles(filename);
+    const int page_num = 64;
+
+    auto dm = new DiskManager(filename);
+    for (int i = 0; i < page_num; i++) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+    }
+    for (int i = 0; i < page_num; i += 4) {
+        dm->DeallocatePage(i);
+    }
+    EXPECT_EQ(dm->GetFreePageCount(), static_cast<size_t>(page_num / 4));
+    // double free is ignored
+    dm->DeallocatePage(0);
+    EXPECT_EQ(dm->GetFreePageCount(), static_cast<size_t>(page_num / 4));
+
+    // lowest free pages go first
+    EXPECT_EQ(dm->AllocatePage(), 0);
+    EXPECT_EQ(dm->AllocatePage(), 4);
+    EXPECT_EQ(dm->GetFreePageCount(), static_cast<size_t>(page_num / 4 - 2));
+    dm->Sync();
+    delete dm;
+
+    dm = new DiskManager(filename);
+    EXPECT_EQ(dm->GetFreePageCount(), static_cast<size_t>(page_num / 4 - 2));
+    for (int i = 0; i < page_num; i++) {
+        EXPECT_EQ(dm->IsAllocated(i), i % 4 != 0 || i <= 4);
+    }
+    for (int i = 8; i < page_num; i += 4) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+    }
+    // file shouldn't grow until every free page is reused
+    EXPECT_EQ(dm->GetFreePageCount(), 0u);
+    EXPECT_EQ(dm->AllocatePage(), page_num);
+    delete dm;
+
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * file should be extended by extents, and a reused page should read as zero
+ */
+TEST(DiskManagerTest, FileExtensionTest) {
+    std::string filename = "test.db";
+    DiskManager::RemoveFiles(filename);
+    auto extension_pages = DISK_EXTENSION_PAGES;
+    DISK_EXTENSION_PAGES = 16;
+
+    auto file_size = [&]() {
+        struct stat stat_buf;
+        EXPECT_EQ(stat(filename.c_str(), &stat_buf), 0);
+        return static_cast<size_t>(stat_buf.st_size);
+    };
+
+    auto dm = new DiskManager(filename);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+    }
+    // file begins with the header page
+    EXPECT_EQ(file_size(), (DiskManager::HEADER_PAGE_COUNT + 16) * PAGE_SIZE);
+    for (int i = 10; i < 17; i++) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+    }
+    EXPECT_EQ(file_size(), (DiskManager::HEADER_PAGE_COUNT + 32) * PAGE_SIZE);
+
+    char data[PAGE_SIZE];
+    memset(data, 'a', PAGE_SIZE);
+    dm->WritePage(3, data);
+    dm->DeallocatePage(3);
+    EXPECT_EQ(dm->AllocatePage(), 3);
+    dm->ReadPage(3, data);
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        EXPECT_EQ(data[i], 0);
+    }
+
+    // pages in extent that haven't been written read as zero
+    memset(data, 'a', PAGE_SIZE);
+    dm->ReadPage(20, data);
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        EXPECT_EQ(data[i], 0);
+    }
+    delete dm;
+
+    DISK_EXTENSION_PAGES = extension_pages;
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * pages should be spread over segment files, which are created on demand
+ */
+TEST(DiskManagerTest, SegmentTest) {
+    std::string filename = "test.db";
+    const int segment_pages = 1024;
+    // header page takes the first slot of segment 0, thus extents of 4 pages are not aligned
+    // to segments, and the last one of them ends right before segment 3
+    const int page_num = 3 * segment_pages - 4;
+    auto remove_files = [&]() {
+        DiskManager::RemoveFiles(filename);
+    };
+    auto file_exists = [](const std::string &name) {
+        struct stat stat_buf;
+        return stat(name.c_str(), &stat_buf) == 0;
+    };
+    remove_files();
+    auto segment_size = DISK_SEGMENT_SIZE;
+    auto extension_pages = DISK_EXTENSION_PAGES;
+    DISK_SEGMENT_SIZE = segment_pages * PAGE_SIZE;
+    DISK_EXTENSION_PAGES = 4;
+
+    char data[PAGE_SIZE];
+    auto dm = new DiskManager(filename);
+    // reading a segment that doesn't exist won't create it
+    dm->ReadPage(page_num, data, false);
+    EXPECT_FALSE(file_exists(filename + ".1"));
+
+    // extents span segments
+    for (int i = 0; i < page_num; i++) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+    }
+    for (int i = 0; i < page_num; i += 7) {
+        memset(data, i, PAGE_SIZE);
+        dm->WritePage(i, data);
+    }
+    EXPECT_TRUE(file_exists(filename + ".2"));
+    EXPECT_FALSE(file_exists(filename + ".3"));
+
+    // a write far away creates the segments before it as well
+    memset(data, 'x', PAGE_SIZE);
+    dm->WritePage(4 * segment_pages + 1, data);
+    EXPECT_TRUE(file_exists(filename + ".3"));
+    EXPECT_TRUE(file_exists(filename + ".4"));
+    dm->Sync();
+    delete dm;
+
+    dm = new DiskManager(filename);
+    for (int i = 0; i < page_num; i += 7) {
+        dm->ReadPage(i, data);
+        EXPECT_EQ(data[0], static_cast<char>(i));
+        EXPECT_EQ(data[PAGE_SIZE - 1], static_cast<char>(i));
+    }
+    dm->ReadPage(4 * segment_pages + 1, data);
+    EXPECT_EQ(data[0], 'x');
+    delete dm;
+
+    DISK_SEGMENT_SIZE = segment_size;
+    DISK_EXTENSION_PAGES = extension_pages;
+    remove_files();
+}
+
+TEST(DiskManagerTest, PageCompressorTest) {
+    std::mt19937 mt(0);
+    std::uniform_int_distribution<int> dis(0, 255);
+    char page[PAGE_SIZE];
+    char compressed[PAGE_SIZE];
+    char decompressed[PAGE_SIZE];
+
+    auto round_trip = [&]() {
+        auto size = PageCompressor::Compress(page, PAGE_SIZE, compressed, PAGE_SIZE);
+        if (size == 0) {
+            return size;
+        }
+        EXPECT_TRUE(PageCompressor::Decompress(compressed, size, decompressed, PAGE_SIZE));
+        EXPECT_EQ(memcmp(page, decompressed, PAGE_SIZE), 0);
+        // truncated data should be detected
+        EXPECT_FALSE(PageCompressor::Decompress(compressed, size / 2, decompressed, PAGE_SIZE));
+        return size;
+    };
+
+    // empty page
+    memset(page, 0, PAGE_SIZE);
+    EXPECT_LT(round_trip(), 64u);
+
+    // rows sharing most of their bytes
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        page[i] = "history row 0000|"[i % 17];
+        if (i % 17 == 15) {
+            page[i] = static_cast<char>('0' + dis(mt) % 10);
+        }
+    }
+    EXPECT_LT(round_trip(), PAGE_SIZE / 2);
+
+    // random data doesn't fit
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        page[i] = static_cast<char>(dis(mt));
+    }
+    EXPECT_EQ(PageCompressor::Compress(page, PAGE_SIZE, compressed, PAGE_SIZE - 1), 0u);
+}
+
+/**
+ * @brief
+ * compressed pages should survive restart, and be rewritten in place of old versions
+ */
+TEST(DiskManagerTest, CompressionTest) {
+    std::string filename = "test.db";
+    auto remove_files = [&]() {
+        DiskManager::RemoveFiles(filename);
+    };
+    remove_files();
+    DISK_PAGE_COMPRESSION = true;
+    const int page_num = 64;
+
+    auto fill = [](char *data, int page_id, int version) {
+        for (size_t i = 0; i < PAGE_SIZE; i++) {
+            data[i] = static_cast<char>('a' + (i / 64 + page_id + version) % 8);
+        }
+        // an incompressible page now and then
+        if (page_id % 16 == 0) {
+            std::mt19937 mt(page_id + version);
+            for (size_t i = 0; i < PAGE_SIZE; i++) {
+                data[i] = static_cast<char>(mt());
+            }
+        }
+    };
+
+    char data[PAGE_SIZE];
+    char expected[PAGE_SIZE];
+    auto dm = new DiskManager(filename);
+    EXPECT_TRUE(dm->IsCompressionEnabled());
+    for (int i = 0; i < page_num; i++) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+        fill(data, i, 0);
+        dm->WritePage(i, data);
+    }
+    dm->Sync();
+    // rewrite them, old slots are reused after sync
+    for (int i = 0; i < page_num; i++) {
+        fill(data, i, 1);
+        dm->WritePage(i, data);
+    }
+    dm->Sync();
+    for (int i = 0; i < page_num; i += 2) {
+        fill(data, i, 2);
+        dm->WritePage(i, data);
+    }
+    dm->Sync();
+    EXPECT_LT(dm->GetCompressionRatio(), 0.5);
+    LOG_INFO("%s", dm->GetCompressionReport().c_str());
+    delete dm;
+
+    struct stat stat_buf;
+    EXPECT_EQ(stat("test.cpg", &stat_buf), 0);
+    EXPECT_LT(static_cast<size_t>(stat_buf.st_size), 2 * page_num * PAGE_SIZE / 2);
+
+    dm = new DiskManager(filename);
+    for (int i = 0; i < page_num; i++) {
+        fill(expected, i, i % 2 == 0 ? 2 : 1);
+        dm->ReadPage(i, data);
+        EXPECT_EQ(memcmp(data, expected, PAGE_SIZE), 0);
+    }
+    // page that is never written reads as zero
+    dm->ReadPage(page_num, data, false);
+    EXPECT_EQ(data[0], 0);
+    delete dm;
+
+    DISK_PAGE_COMPRESSION = false;
+    remove_files();
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+    const std::string filename = "test.db";
+    const size_t page_size = 16 * 1024;
+    const int page_num = 100;
+    DiskManager::RemoveFiles(filename);
+
+    // page size is chosen when db is created
+    DISK_PAGE_SIZE = page_size;
+    auto dm = new DiskManager(filename);
+    EXPECT_EQ(dm->GetPageSize(), page_size);
+    std::vector<char> data(page_size);
+    for (int i = 0; i < page_num; i++) {
+        EXPECT_EQ(dm->AllocatePage(), i);
+        memset(data.data(), i, page_size);
+        dm->WritePage(i, data.data());
+    }
+    dm->Sync();
+    delete dm;
+
+    // and it's read from the header afterwards
+    DISK_PAGE_SIZE = PAGE_SIZE;
+    dm = new DiskManager(filename);
+    EXPECT_EQ(dm->GetPageSize(), page_size);
+    for (int i = 0; i < page_num; i++) {
+        dm->ReadPage(i, data.data());
+        EXPECT_EQ(data[0], static_cast<char>(i));
+        EXPECT_EQ(data[page_size - 1], static_cast<char>(i));
+    }
+    delete dm;
+
+    // invalid page size is rejected
+    DiskManager::RemoveFiles(filename);
+    DISK_PAGE_SIZE = PAGE_SIZE + 1;
+    EXPECT_THROW(DiskManager dm(filename), Exception);
+    DISK_PAGE_SIZE = PAGE_SIZE;
+    DiskManager::RemoveFiles(filename);
+}
+
+/**
+ * @brief
+ * db file created before header is introduced should still be readable,
+ * and its pages shouldn't be handed out again
+ */
+TEST(DiskManagerTest, LegacyFileTest) {
+    const std::string filename = "test.db";
+    const int page_num = 8;
+    auto remove_files = [&]() {
+        DiskManager::RemoveFiles(filename);
+    };
+    auto file_exists = [](const std::string &name) {
+        struct stat stat_buf;
+        return stat(name.c_str(), &stat_buf) == 0;
+    };
+    auto write_legacy_file = [&]() {
+        auto file = fopen(filename.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        char data[PAGE_SIZE];
+        for (int i = 0; i < page_num; i++) {
+            memset(data, 'a' + i, PAGE_SIZE);
+            EXPECT_EQ(fwrite(data, 1, PAGE_SIZE, file), PAGE_SIZE);
+        }
+        fclose(file);
+    };
+    remove_files();
+    write_legacy_file();
+
+    // page size of the legacy file is the default one, even if another one is configured
+    DISK_PAGE_SIZE = 16 * 1024;
+    auto dm = new DiskManager(filename);
+    DISK_PAGE_SIZE = PAGE_SIZE;
+    EXPECT_EQ(dm->GetPageSize(), PAGE_SIZE);
+    char data[PAGE_SIZE];
+    for (int i = 0; i < page_num; i++) {
+        dm->ReadPage(i, data);
+        EXPECT_EQ(data[0], static_cast<char>('a' + i));
+        EXPECT_EQ(data[PAGE_SIZE - 1], static_cast<char>('a' + i));
+    }
+    EXPECT_EQ(dm->AllocatePage(), page_num);
+    memset(data, 'x', PAGE_SIZE);
+    dm->WritePage(page_num, data);
+    dm->Sync();
+    delete dm;
+
+    // reopening it keeps the layout and the allocation state
+    dm = new DiskManager(filename);
+    dm->ReadPage(0, data);
+    EXPECT_EQ(data[0], 'a');
+    dm->ReadPage(page_num, data);
+    EXPECT_EQ(data[0], 'x');
+    EXPECT_EQ(dm->AllocatePage(), page_num + 1);
+    delete dm;
+
+    // legacy file larger than a segment keeps all of its pages in a single file
+    remove_files();
+    write_legacy_file();
+    auto segment_size = DISK_SEGMENT_SIZE;
+    DISK_SEGMENT_SIZE = 4 * PAGE_SIZE;
+    dm = new DiskManager(filename);
+    for (int i = 0; i < page_num; i++) {
+        dm->ReadPage(i, data);
+        EXPECT_EQ(data[0], static_cast<char>('a' + i));
+    }
+    EXPECT_EQ(dm->AllocatePage(), page_num);
+    memset(data, 'x', PAGE_SIZE);
+    dm->WritePage(page_num, data);
+    dm->ReadPage(page_num, data);
+    EXPECT_EQ(data[0], 'x');
+    EXPECT_FALSE(file_exists(filename + ".1"));
+    delete dm;
+    DISK_SEGMENT_SIZE = segment_size;
+    remove_files();
+}
+
+}
@@ -20,7 +20,7 @@ namespace TinyDB {
 TEST(IndexTest, InterfaceTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 50;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -135,7 +135,7 @@ TEST(IndexTest, InterfaceTest) {
 
     delete disk_manager;
     delete bpm;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 }
\ No newline at end of file
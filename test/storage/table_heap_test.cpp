@@ -18,7 +18,7 @@ namespace TinyDB {
 TEST(TableHeapTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -83,7 +83,7 @@ TEST(TableHeapTest, BasicTest) {
         EXPECT_EQ(table->GetTuple(tuple_list[i], &tmp).IsOk(), false);
     }
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
     delete table;
     delete bpm;
     delete disk_manager;
@@ -92,7 +92,7 @@ TEST(TableHeapTest, BasicTest) {
 TEST(TableHeapTest, IteratorTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 3;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -145,8 +145,9 @@ TEST(TableHeapTest, IteratorTest) {
             EXPECT_EQ(table->InsertTuple(tuple_update, &tuple_list[i]).IsOk(), true);
         }
     }
-    // scan them
-    for (it = table->Begin(), cnt = 0; it != table->End(); ++it, ++cnt) {
+    // scan them with a bulk read ring
+    auto strategy = std::make_shared<BufferAccessStrategy>();
+    for (it = table->Begin(strategy), cnt = 0; it != table->End(); ++it, ++cnt) {
         EXPECT_EQ(*it == tuple_update, true);
         // don't test the rid, since they may out of order after insertion/deletion
         // EXPECT_EQ(it->GetRID(), tuple_list[cnt]);
@@ -162,7 +163,7 @@ TEST(TableHeapTest, IteratorTest) {
     it = table->Begin();
     EXPECT_EQ(it, table->End());
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
     delete table;
     delete bpm;
     delete disk_manager;
@@ -21,7 +21,7 @@ namespace TinyDB {
 TEST(TablePageTest, BasicTest) {
     const std::string filename = "test.db";
     const size_t buffer_pool_size = 1;
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 
     auto disk_manager = new DiskManager(filename);
     auto bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
@@ -146,7 +146,7 @@ TEST(TablePageTest, BasicTest) {
     delete bpm;
     delete disk_manager;
 
-    remove(filename.c_str());
+    DiskManager::RemoveFiles(filename);
 }
 
 }
\ No newline at end of file